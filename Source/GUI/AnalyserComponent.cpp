@@ -61,8 +61,43 @@ AnalyserComponent::AnalyserComponent()
 
     addAndMakeVisible (fftScope);
     fftScope.assignFftProcessor (&fftProcessor);
-    fftScope.setAggregationMethod (static_cast<const FftScope<12>::AggregationMethod> (config->getIntAttribute ("FftAggregationMethod", static_cast<int> (FftScope<12>::AggregationMethod::Maximum))));
-    fftScope.setReleaseCharacteristic (static_cast<const FftScope<12>::ReleaseCharacteristic> (config->getIntAttribute ("FftReleaseCharacteristic", static_cast<int> (FftScope<12>::ReleaseCharacteristic::Off))));
+    fftScope.setAggregationMethod (static_cast<const FftScope::AggregationMethod> (config->getIntAttribute ("FftAggregationMethod", static_cast<int> (FftScope::AggregationMethod::Maximum))));
+    fftScope.setReleaseCharacteristic (static_cast<const FftScope::ReleaseCharacteristic> (config->getIntAttribute ("FftReleaseCharacteristic", static_cast<int> (FftScope::ReleaseCharacteristic::Off))));
+    fftScope.setHoldTraces (static_cast<FftScope::HoldTraces> (jlimit (static_cast<int> (FftScope::HoldTraces::None), static_cast<int> (FftScope::HoldTraces::TimedPeak), config->getIntAttribute ("FftHoldTraces", static_cast<int> (FftScope::HoldTraces::None)))));
+    fftProcessor.setFftOrder (jlimit (FftProcessor::minOrder, FftProcessor::maxOrder, config->getIntAttribute ("FftOrder", FftProcessor::defaultOrder)));
+    fftProcessor.setResolutionLevels (jlimit (1, FftProcessor::maxResolutionLevels, config->getIntAttribute ("FftResolutionLevels", 1)));
+    fftProcessor.setWindowingMethod (static_cast<dsp::WindowingFunction<float>::WindowingMethod> (jlimit (0, FftProcessor::numWindows - 1, config->getIntAttribute ("FftWindow", dsp::WindowingFunction<float>::hann))));
+    fftProcessor.setOverlap (static_cast<const FftProcessor::Overlap> (config->getIntAttribute ("FftOverlap", FftProcessor::Overlap::None)));
+    fftProcessor.setAveraging (static_cast<const FftProcessor::Averaging> (config->getIntAttribute ("FftAveraging", FftProcessor::Averaging::NoAveraging)));
+    fftProcessor.setLinearAveragingFrames (config->getIntAttribute ("FftAveragingFrames", fftProcessor.getLinearAveragingFrames()));
+    fftProcessor.setExponentialAveragingTime (static_cast<float> (config->getDoubleAttribute ("FftAveragingTime", fftProcessor.getExponentialAveragingTime())));
+    fftProcessor.setPowerSpectralDensityEnabled (config->getBoolAttribute ("FftPsd", false));
+    const auto phaseOverlay = jlimit (static_cast<int> (FftScope::PhaseOverlay::None), static_cast<int> (FftScope::PhaseOverlay::GroupDelay), config->getIntAttribute ("FftPhaseOverlay", static_cast<int> (FftScope::PhaseOverlay::None)));
+    fftScope.setPhaseOverlay (static_cast<FftScope::PhaseOverlay> (phaseOverlay));
+    fftProcessor.setPhaseEnabled (fftScope.getPhaseOverlay() != FftScope::PhaseOverlay::None);
+    addChildComponent (spectrogram);
+    spectrogram.assignFftProcessor (&fftProcessor);
+    if (fftProcessor.isPowerSpectralDensityEnabled())
+    {
+        fftScope.setDbRange (-160.0f, 0.0f);
+        spectrogram.setDbRange (-160.0f, 0.0f);
+    }
+    setHarmonicAnalysisEnabled (config->getBoolAttribute ("HarmonicAnalysis", false));
+    addChildComponent (transferFunctionScope);
+    transferFunctionScope.assignTransferFunctionAnalyser (&transferFunctionAnalyser);
+    addChildComponent (impulseResponseScope);
+    impulseResponseScope.assignSweepMeasurement (&sweepMeasurement);
+    impulseResponseScope.onMeasure = [this]
+    {
+        sweepProcessor.set (measuredProcessor.get());
+        sweepMeasurement.startMeasurement();
+    };
+    setMeasuredProcessor (static_cast<const MeasuredProcessor> (jlimit (static_cast<int> (ProcessorA), static_cast<int> (ProcessorB), config->getIntAttribute ("MeasuredProcessor", ProcessorA))));
+    addChildComponent (zoomFftScope);
+    zoomFftProcessor.setCentreFrequency (config->getDoubleAttribute ("ZoomFftCentre", zoomFftProcessor.getCentreFrequency()));
+    zoomFftProcessor.setZoomOrder (jlimit (ZoomFftProcessor::minZoomOrder, ZoomFftProcessor::maxZoomOrder, config->getIntAttribute ("ZoomFftOrder", ZoomFftProcessor::defaultZoomOrder)));
+    zoomFftScope.assignZoomFftProcessor (&zoomFftProcessor);
+    setFftView (static_cast<const FftView> (jlimit (static_cast<int> (SpectrumView), static_cast<int> (ZoomFftView), config->getIntAttribute ("FftView", SpectrumView))));
 
     addAndMakeVisible (oscilloscope);
     oscilloscope.assignAudioScopeProcessor (&audioScopeProcessor);
@@ -70,6 +105,13 @@ AnalyserComponent::AnalyserComponent()
     oscilloscope.setXMax (config->getIntAttribute ("ScopeXMax", oscilloscope.getDefaultXMaximum()));
     oscilloscope.setMaxAmplitude (static_cast<float> (config->getDoubleAttribute("ScopeMaxAmplitude", 1.0)));
     oscilloscope.setAggregationMethod (static_cast<const Oscilloscope::AggregationMethod> (config->getIntAttribute ("ScopeAggregationMethod", static_cast<int> (Oscilloscope::AggregationMethod::NearestSample))));
+    setAnalysedChannels (config->getIntAttribute ("AnalysedFirstChannel", 0), config->getIntAttribute ("AnalysedNumChannels", 0));
+    audioScopeProcessor.setHistoryLength (static_cast<float> (config->getDoubleAttribute ("ScopeHistoryLength", 0.0)));
+    audioScopeProcessor.setTriggerMode (static_cast<const AudioScopeProcessor::TriggerMode> (jlimit (static_cast<int> (AudioScopeProcessor::TriggerMode::FreeRun), static_cast<int> (AudioScopeProcessor::TriggerMode::Level), config->getIntAttribute ("ScopeTriggerMode", AudioScopeProcessor::TriggerMode::FreeRun))));
+    audioScopeProcessor.setTriggerLevel (static_cast<float> (config->getDoubleAttribute ("ScopeTriggerLevel", 0.0)));
+    audioScopeProcessor.setAutoTrigger (config->getBoolAttribute ("ScopeAutoTrigger", true));
+    oscilloscope.setViewMode (static_cast<const Oscilloscope::ViewMode> (jlimit (static_cast<int> (Oscilloscope::ViewMode::LatestBlock), static_cast<int> (Oscilloscope::ViewMode::Roll), config->getIntAttribute ("ScopeViewMode", Oscilloscope::ViewMode::LatestBlock))));
+    oscilloscope.setHistorySpan (config->getDoubleAttribute ("ScopeHistorySpan", 10.0));
 
     addAndMakeVisible (goniometer);
     goniometer.assignAudioScopeProcessor (&audioScopeProcessor);
@@ -83,6 +125,7 @@ AnalyserComponent::AnalyserComponent()
     // Construct config component last so it picks up the correct values
     configComponent = std::make_unique<AnalyserConfigComponent> (this);
     btnConfig->onClick = [this] { 
+        configComponent->updateChannelList();
         DialogWindow::showDialog ("Analyser configuration", configComponent.get(), nullptr, Colours::darkgrey, true);
     };
 
@@ -93,10 +136,33 @@ AnalyserComponent::~AnalyserComponent()
     // Update configuration from class state
     config->setAttribute ("FftAggregationMethod", static_cast<int> (fftScope.getAggregationMethod()));
     config->setAttribute ("FftReleaseCharacteristic", static_cast<int> (fftScope.getReleaseCharacteristic()));
+    config->setAttribute ("FftHoldTraces", static_cast<int> (fftScope.getHoldTraces()));
+    config->setAttribute ("FftOrder", fftProcessor.getFftOrder());
+    config->setAttribute ("FftResolutionLevels", fftProcessor.getResolutionLevels());
+    config->setAttribute ("FftWindow", static_cast<int> (fftProcessor.getWindowingMethod()));
+    config->setAttribute ("FftOverlap", fftProcessor.getOverlap());
+    config->setAttribute ("FftAveraging", fftProcessor.getAveraging());
+    config->setAttribute ("FftAveragingFrames", fftProcessor.getLinearAveragingFrames());
+    config->setAttribute ("FftAveragingTime", fftProcessor.getExponentialAveragingTime());
+    config->setAttribute ("FftPsd", fftProcessor.isPowerSpectralDensityEnabled());
+    config->setAttribute ("FftPhaseOverlay", static_cast<int> (fftScope.getPhaseOverlay()));
+    config->setAttribute ("FftView", fftView);
+    config->setAttribute ("MeasuredProcessor", measuredProcessor.get());
+    config->setAttribute ("AnalysedFirstChannel", firstAnalysedChannel);
+    config->setAttribute ("AnalysedNumChannels", numAnalysedChannels);
+    config->setAttribute ("ZoomFftCentre", zoomFftProcessor.getCentreFrequency());
+    config->setAttribute ("ZoomFftOrder", zoomFftProcessor.getZoomOrder());
+    config->setAttribute ("HarmonicAnalysis", isHarmonicAnalysisEnabled());
     config->setAttribute ("ScopeXMin", oscilloscope.getXMin());
     config->setAttribute ("ScopeXMax", oscilloscope.getXMax());
     config->setAttribute ("ScopeMaxAmplitude", oscilloscope.getMaxAmplitude());
     config->setAttribute ("ScopeAggregationMethod", oscilloscope.getAggregationMethod());
+    config->setAttribute ("ScopeViewMode", oscilloscope.getViewMode());
+    config->setAttribute ("ScopeHistorySpan", oscilloscope.getHistorySpan());
+    config->setAttribute ("ScopeHistoryLength", audioScopeProcessor.getHistoryLength());
+    config->setAttribute ("ScopeTriggerMode", audioScopeProcessor.getTriggerMode());
+    config->setAttribute ("ScopeTriggerLevel", audioScopeProcessor.getTriggerLevel());
+    config->setAttribute ("ScopeAutoTrigger", audioScopeProcessor.isAutoTriggerEnabled());
 
     // Save configuration to application properties
     auto* propertiesFile = DSPTestbenchApplication::getApp().appProperties.getUserSettings();
@@ -137,7 +203,7 @@ void AnalyserComponent::resized()
         Track (mainMeterBackground.getDesiredWidth())
     };
     analyserGrid.items.addArray({
-        GridItem (fftScope).withArea (1, 1),
+        GridItem (getFftViewComponent()).withArea (1, 1),
         GridItem (oscilloscope).withArea (2, 1),
         GridItem (goniometer).withArea (GridItem::Span (2), 2),
         GridItem (mainMeterBackground).withArea (GridItem::Span (2), 3)
@@ -181,6 +247,14 @@ void AnalyserComponent::prepare (const dsp::ProcessSpec& spec)
     {
         fftProcessor.prepare (spec);
         fftScope.prepare (spec);
+        spectrogram.prepare (spec);
+        harmonicAnalyser.prepare (spec);
+        transferFunctionAnalyser.prepare (spec);
+        transferFunctionScope.prepare (spec);
+        sweepMeasurement.prepare (spec);
+        impulseResponseScope.prepare (spec);
+        zoomFftProcessor.prepare (spec);
+        zoomFftScope.prepare (spec);
         audioScopeProcessor.prepare (spec);
         oscilloscope.prepare();
         goniometer.prepare();
@@ -226,15 +300,14 @@ void AnalyserComponent::prepare (const dsp::ProcessSpec& spec)
 }
 void AnalyserComponent::process (const dsp::ProcessContextReplacing<float>& context)
 {
-    auto* inputBlock = &context.getInputBlock();
-    for (size_t ch = 0; ch < inputBlock->getNumChannels(); ++ch)
-    {
-        const auto chNum = static_cast<int> (ch);
-        const auto numSamples = static_cast<int> (inputBlock->getNumSamples());
-        const auto* audioData = inputBlock->getChannelPointer (ch);
-        fftProcessor.appendData (chNum, numSamples, audioData);
-        audioScopeProcessor.appendData (chNum, numSamples, audioData);
-    }
+    // The channels are appended together so they stay in lockstep (& whole blocks are processed without being copied)
+    const auto& inputBlock = context.getInputBlock();
+    fftProcessor.appendBlock (inputBlock);
+    audioScopeProcessor.appendBlock (inputBlock);
+    if (harmonicAnalysisEnabled.get())
+        harmonicAnalyser.appendBlock (inputBlock);
+    if (zoomFftEnabled.get())
+        zoomFftProcessor.appendBlock (inputBlock);
     peakMeterProcessor.process (context);
     vuMeterProcessor.process (context);
     clipCounterProcessor.process (context);
@@ -293,28 +366,314 @@ void AnalyserComponent::showClipStats()
         clipStatsWindow->addToDesktop();
     }
 }
+int AnalyserComponent::getFrameSize() const
+{
+    return jmax (fftProcessor.getAnalysisLength(), audioScopeProcessor.getMaximumBlockSize());
+}
+void AnalyserComponent::setStimulusFrequency (const double frequencyInHz)
+{
+    harmonicAnalyser.setStimulusFrequency (frequencyInHz);
+}
+void AnalyserComponent::setHarmonicAnalysisEnabled (const bool shouldBeEnabled)
+{
+    harmonicAnalysisEnabled.set (shouldBeEnabled);
+    fftScope.assignHarmonicAnalyser (shouldBeEnabled ? &harmonicAnalyser : nullptr);
+}
+bool AnalyserComponent::isHarmonicAnalysisEnabled() const
+{
+    return harmonicAnalysisEnabled.get();
+}
+void AnalyserComponent::setFftView (const FftView view)
+{
+    fftView = view;
+    fftScope.setVisible (view == SpectrumView);
+    spectrogram.setVisible (view == SpectrogramView);
+    transferFunctionScope.setVisible (view == TransferFunctionView);
+    impulseResponseScope.setVisible (view == ImpulseResponseView);
+    zoomFftScope.setVisible (view == ZoomFftView);
+    zoomFftEnabled.set (view == ZoomFftView);
+    transferFunctionProcessor.set (view == TransferFunctionView ? measuredProcessor.get() : 0);
+    resized();
+}
+AnalyserComponent::FftView AnalyserComponent::getFftView() const
+{
+    return fftView;
+}
+void AnalyserComponent::setMaximumProcessorLatency (const int maximumLatencySamples)
+{
+    transferFunctionAnalyser.setMaximumReferenceDelay (maximumLatencySamples);
+}
+void AnalyserComponent::setProcessorLatencies (const int latencySamplesA, const int latencySamplesB)
+{
+    // The analyser resets its averaging itself if the delay changes
+    processorLatencyA = latencySamplesA;
+    processorLatencyB = latencySamplesB;
+    transferFunctionAnalyser.setReferenceDelay (measuredProcessor.get() == ProcessorA ? latencySamplesA : latencySamplesB);
+}
+void AnalyserComponent::setMeasuredProcessor (const MeasuredProcessor source)
+{
+    measuredProcessor = source;
+    transferFunctionAnalyser.setReferenceDelay (source == ProcessorA ? processorLatencyA.get() : processorLatencyB.get());
+    transferFunctionAnalyser.resetAveraging();
+    transferFunctionScope.setDescription (source == ProcessorA ? "Processor A" : "Processor B");
+    impulseResponseScope.setDescription (source == ProcessorA ? "Processor A" : "Processor B");
+    if (fftView == TransferFunctionView)
+        transferFunctionProcessor.set (source);
+}
+AnalyserComponent::MeasuredProcessor AnalyserComponent::getMeasuredProcessor() const
+{
+    return static_cast<MeasuredProcessor> (measuredProcessor.get());
+}
+void AnalyserComponent::setAnalysedChannels (const int firstChannel, const int numChannelsToAnalyse)
+{
+    // The processors can only mask the first 64 channels
+    firstAnalysedChannel = jlimit (0, 63, firstChannel);
+    numAnalysedChannels = jlimit (0, 64 - firstAnalysedChannel, numChannelsToAnalyse);
+    const auto mask = numAnalysedChannels == 0 || numAnalysedChannels == 64 ? ~uint64 (0)
+                                                                           : ((uint64 (1) << numAnalysedChannels) - 1) << firstAnalysedChannel;
+    fftProcessor.setChannelMask (mask);
+    audioScopeProcessor.setChannelMask (mask);
+}
+int AnalyserComponent::getFirstAnalysedChannel() const
+{
+    return firstAnalysedChannel;
+}
+int AnalyserComponent::getNumAnalysedChannels() const
+{
+    return numAnalysedChannels;
+}
+bool AnalyserComponent::isMeasuringTransferFunction (const MeasuredProcessor source) const noexcept
+{
+    return statusActive.get() && transferFunctionProcessor.get() == source;
+}
+void AnalyserComponent::appendTransferFunctionReference (const dsp::AudioBlock<float>& block)
+{
+    if (block.getNumChannels() > 0)
+        transferFunctionAnalyser.appendReference (block.getChannelPointer (0), static_cast<int> (block.getNumSamples()));
+}
+void AnalyserComponent::appendTransferFunctionResponse (const dsp::AudioBlock<float>& block)
+{
+    if (block.getNumChannels() > 0)
+        transferFunctionAnalyser.appendResponse (block.getChannelPointer (0), static_cast<int> (block.getNumSamples()));
+}
+bool AnalyserComponent::isMeasuringImpulseResponse (const MeasuredProcessor source) const noexcept
+{
+    return sweepMeasurement.isSweepActive() && sweepProcessor.get() == source;
+}
+void AnalyserComponent::renderSweep (const dsp::AudioBlock<float>& block)
+{
+    sweepMeasurement.renderSweep (block);
+}
+void AnalyserComponent::captureSweepResponse (const dsp::AudioBlock<float>& block)
+{
+    sweepMeasurement.captureResponse (block);
+}
 int AnalyserComponent::getOscilloscopeMaximumBlockSize() const
 {
     return oscilloscope.getMaximumBlockSize();
 }
+Component& AnalyserComponent::getFftViewComponent()
+{
+    switch (fftView)
+    {
+        case SpectrogramView: return spectrogram;
+        case TransferFunctionView: return transferFunctionScope;
+        case ImpulseResponseView: return impulseResponseScope;
+        case ZoomFftView: return zoomFftScope;
+        case SpectrumView:
+        default: return fftScope;
+    }
+}
 
 AnalyserComponent::AnalyserConfigComponent::AnalyserConfigComponent (AnalyserComponent* analyserToConfigure): analyserComponent(analyserToConfigure)
 {
     auto* fftScopePtr = &analyserComponent->fftScope;
     auto* osc = &analyserComponent->oscilloscope;
 
+    auto* fftProcessorPtr = &analyserComponent->fftProcessor;
+
+    lblFftSize.setText("FFT size", dontSendNotification);
+    lblFftSize.setJustificationType (Justification::centredRight);
+    addAndMakeVisible(lblFftSize);
+
+    cmbFftSize.setTooltip ("Set the number of points in the FFT.\n\nSmaller sizes respond more quickly but have coarser frequency resolution. Larger sizes resolve low frequencies better but respond more slowly.");
+    for (auto order = FftProcessor::minOrder; order <= FftProcessor::maxOrder; ++order)
+        cmbFftSize.addItem (String (1 << order), order);
+    addAndMakeVisible (cmbFftSize);
+    cmbFftSize.setSelectedId (fftProcessorPtr->getFftOrder(), dontSendNotification);
+    cmbFftSize.onChange = [this, fftProcessorPtr]
+    {
+        fftProcessorPtr->setFftOrder (cmbFftSize.getSelectedId());
+    };
+
+    lblFftResolution.setText("FFT multi-resolution", dontSendNotification);
+    lblFftResolution.setJustificationType (Justification::centredRight);
+    addAndMakeVisible(lblFftResolution);
+
+    cmbFftResolution.setTooltip ("Set the number of resolution levels.\n\nEach extra level computes an FFT of the same size on a signal decimated by a further factor of 2, doubling the frequency resolution of the bottom octave without needing a larger FFT. The lowest octaves update more slowly as a result.");
+    cmbFftResolution.addItem ("Off", 1);
+    for (auto numLevels = 2; numLevels <= FftProcessor::maxResolutionLevels; ++numLevels)
+        cmbFftResolution.addItem (String (numLevels) + " levels (LF resolution x" + String (1 << (numLevels - 1)) + ")", numLevels);
+    addAndMakeVisible (cmbFftResolution);
+    cmbFftResolution.setSelectedId (fftProcessorPtr->getResolutionLevels(), dontSendNotification);
+    cmbFftResolution.onChange = [this, fftProcessorPtr]
+    {
+        fftProcessorPtr->setResolutionLevels (cmbFftResolution.getSelectedId());
+    };
+
+    lblFftWindow.setText("FFT window", dontSendNotification);
+    lblFftWindow.setJustificationType (Justification::centredRight);
+    addAndMakeVisible(lblFftWindow);
+
+    cmbFftWindow.setTooltip ("Set the window applied to each FFT frame.\n\nFlat top gives the most accurate amplitude for sinusoids that fall between bins. Blackman-Harris and Kaiser give the greatest dynamic range. Rectangular gives the finest frequency resolution but the worst leakage.");
+    for (auto w = 0; w < FftProcessor::numWindows; ++w)
+        cmbFftWindow.addItem (dsp::WindowingFunction<float>::getWindowingMethodName (static_cast<dsp::WindowingFunction<float>::WindowingMethod> (w)), w + 1);
+    addAndMakeVisible (cmbFftWindow);
+    cmbFftWindow.setSelectedId (static_cast<int> (fftProcessorPtr->getWindowingMethod()) + 1, dontSendNotification);
+    cmbFftWindow.onChange = [this, fftProcessorPtr]
+    {
+        fftProcessorPtr->setWindowingMethod (static_cast<dsp::WindowingFunction<float>::WindowingMethod> (cmbFftWindow.getSelectedId() - 1));
+    };
+
+    lblFftAveraging.setText("FFT averaging", dontSendNotification);
+    lblFftAveraging.setJustificationType (Justification::centredRight);
+    addAndMakeVisible(lblFftAveraging);
+
+    // Averaging options are encoded in the item IDs (linear averaging frames are 100 + index, exponential time constants are 200 + index)
+    const std::array<int, 6> averagingFrames { 4, 8, 16, 32, 64, 128 };
+    const std::array<float, 5> averagingTimes { 0.1f, 0.3f, 1.0f, 3.0f, 10.0f };
+    cmbFftAveraging.setTooltip ("Set how successive FFT frames are averaged (in power).\n\nLinear averaging outputs the average of each block of frames (Welch's method). Exponential averaging weights recent frames most heavily with the specified time constant. Averaging gives a stable reading of the noise floor.");
+    cmbFftAveraging.addItem ("Off", FftProcessor::Averaging::NoAveraging);
+    for (auto i = 0; i < static_cast<int> (averagingFrames.size()); ++i)
+        cmbFftAveraging.addItem ("Linear, " + String (averagingFrames[static_cast<size_t> (i)]) + " frames", 100 + i);
+    for (auto i = 0; i < static_cast<int> (averagingTimes.size()); ++i)
+        cmbFftAveraging.addItem ("Exponential, " + String (averagingTimes[static_cast<size_t> (i)]) + " s", 200 + i);
+    addAndMakeVisible (cmbFftAveraging);
+    auto averagingId = static_cast<int> (FftProcessor::Averaging::NoAveraging);
+    if (fftProcessorPtr->getAveraging() == FftProcessor::Averaging::LinearAveraging)
+    {
+        for (auto i = 0; i < static_cast<int> (averagingFrames.size()); ++i)
+            if (averagingFrames[static_cast<size_t> (i)] == fftProcessorPtr->getLinearAveragingFrames())
+                averagingId = 100 + i;
+    }
+    else if (fftProcessorPtr->getAveraging() == FftProcessor::Averaging::ExponentialAveraging)
+    {
+        for (auto i = 0; i < static_cast<int> (averagingTimes.size()); ++i)
+            if (approximatelyEqual (averagingTimes[static_cast<size_t> (i)], fftProcessorPtr->getExponentialAveragingTime()))
+                averagingId = 200 + i;
+    }
+    cmbFftAveraging.setSelectedId (averagingId, dontSendNotification);
+    cmbFftAveraging.onChange = [this, fftProcessorPtr, averagingFrames, averagingTimes]
+    {
+        const auto id = cmbFftAveraging.getSelectedId();
+        if (id >= 200)
+        {
+            fftProcessorPtr->setExponentialAveragingTime (averagingTimes[static_cast<size_t> (id - 200)]);
+            fftProcessorPtr->setAveraging (FftProcessor::Averaging::ExponentialAveraging);
+        }
+        else if (id >= 100)
+        {
+            fftProcessorPtr->setLinearAveragingFrames (averagingFrames[static_cast<size_t> (id - 100)]);
+            fftProcessorPtr->setAveraging (FftProcessor::Averaging::LinearAveraging);
+        }
+        else
+        {
+            fftProcessorPtr->setAveraging (FftProcessor::Averaging::NoAveraging);
+        }
+        fftProcessorPtr->resetAveraging();
+    };
+
+    lblFftUnits.setText("FFT scope units", dontSendNotification);
+    lblFftUnits.setJustificationType (Justification::centredRight);
+    addAndMakeVisible(lblFftUnits);
+
+    cmbFftUnits.setTooltip ("Set whether the FFT scope shows the amplitude of each bin (dB) or the power spectral density (dB/Hz).\n\nThe power spectral density is corrected for the equivalent noise bandwidth of the window, so noise floors can be compared regardless of FFT size or window.");
+    cmbFftUnits.addItem ("Amplitude (dB)", 1);
+    cmbFftUnits.addItem ("Power spectral density (dB/Hz)", 2);
+    addAndMakeVisible (cmbFftUnits);
+    cmbFftUnits.setSelectedId (fftProcessorPtr->isPowerSpectralDensityEnabled() ? 2 : 1, dontSendNotification);
+    cmbFftUnits.onChange = [this, fftProcessorPtr, fftScopePtr]
+    {
+        const auto psd = cmbFftUnits.getSelectedId() == 2;
+        fftProcessorPtr->setPowerSpectralDensityEnabled (psd);
+        fftScopePtr->setDbRange (psd ? -160.0f : -80.0f, 0.0f);
+        analyserComponent->spectrogram.setDbRange (psd ? -160.0f : -80.0f, 0.0f);
+    };
+
+    lblFftPhase.setText("FFT phase overlay", dontSendNotification);
+    lblFftPhase.setJustificationType (Justification::centredRight);
+    addAndMakeVisible(lblFftPhase);
+
+    cmbFftPhase.setTooltip ("Set whether the phase or group delay of each bin is drawn over the amplitude in the FFT scope (against the scale on the right).\n\nPhase is measured relative to the centre of the FFT frame using a complex FFT, so the phase of a steady signal will rotate from frame to frame - it is most useful for impulses and for comparing the phase of linear-phase and minimum-phase filters. Bins more than 60dB below the loudest bin are not drawn. Phase isn't computed in multi-resolution mode.");
+    cmbFftPhase.addItem ("None", static_cast<int> (FftScope::PhaseOverlay::None));
+    cmbFftPhase.addItem ("Phase", static_cast<int> (FftScope::PhaseOverlay::Phase));
+    cmbFftPhase.addItem ("Group delay", static_cast<int> (FftScope::PhaseOverlay::GroupDelay));
+    addAndMakeVisible (cmbFftPhase);
+    cmbFftPhase.setSelectedId (static_cast<int> (fftScopePtr->getPhaseOverlay()), dontSendNotification);
+    cmbFftPhase.onChange = [this, fftProcessorPtr, fftScopePtr]
+    {
+        const auto overlay = static_cast<FftScope::PhaseOverlay> (cmbFftPhase.getSelectedId());
+        fftProcessorPtr->setPhaseEnabled (overlay != FftScope::PhaseOverlay::None);
+        fftScopePtr->setPhaseOverlay (overlay);
+    };
+
+    lblFftView.setText("FFT view", dontSendNotification);
+    lblFftView.setJustificationType (Justification::centredRight);
+    addAndMakeVisible(lblFftView);
+
+    cmbFftView.setTooltip ("Set whether the FFT data is shown as a spectrum or as a scrolling spectrogram, or whether the transfer function or impulse response of a processor is shown instead.\n\nThe spectrogram shows the history of the first channel, with time running from left to right and the level shown by colour.\n\nThe transfer function compares the first channel going into the processor with the first channel coming out of it (see below).\n\nThe impulse response view plays an exponential sine sweep through the processor when its measure button is clicked, then shows the linear impulse response along with the frequency response of the linear part and each harmonic (H2 to H5) against the sweep frequency.\n\nThe zoom FFT shows a narrow band around a centre frequency at much finer resolution than the spectrum (e.g. to resolve closely spaced tones or hum sidebands). Set the centre frequency & span at the top of the view.");
+    cmbFftView.addItem ("Spectrum", SpectrumView);
+    cmbFftView.addItem ("Spectrogram", SpectrogramView);
+    cmbFftView.addItem ("Transfer function", TransferFunctionView);
+    cmbFftView.addItem ("Impulse response (sine sweep)", ImpulseResponseView);
+    cmbFftView.addItem ("Zoom FFT", ZoomFftView);
+    addAndMakeVisible (cmbFftView);
+    cmbFftView.setSelectedId (analyserComponent->getFftView(), dontSendNotification);
+    cmbFftView.onChange = [this]
+    {
+        analyserComponent->setFftView (static_cast<const FftView> (cmbFftView.getSelectedId()));
+    };
+
+    lblMeasuredProcessor.setText("Measured processor", dontSendNotification);
+    lblMeasuredProcessor.setJustificationType (Justification::centredRight);
+    addAndMakeVisible(lblMeasuredProcessor);
+
+    cmbMeasuredProcessor.setTooltip ("Set which processor is measured when the FFT view is set to transfer function or impulse response.\n\nFor the transfer function, the magnitude, phase and coherence are measured by comparing the signal going into the processor with the signal coming out of it, so any broadband stimulus can be used (e.g. noise or music). The processor's latency is compensated for. Coherence close to 1 means the measurement is reliable - it drops where the stimulus has little energy or where the processor is non-linear or adds noise.\n\nFor the impulse response, the sweep replaces the processor's input (whatever sources are routed to it) for the duration of the measurement.");
+    cmbMeasuredProcessor.addItem ("Processor A", ProcessorA);
+    cmbMeasuredProcessor.addItem ("Processor B", ProcessorB);
+    addAndMakeVisible (cmbMeasuredProcessor);
+    cmbMeasuredProcessor.setSelectedId (analyserComponent->getMeasuredProcessor(), dontSendNotification);
+    cmbMeasuredProcessor.onChange = [this]
+    {
+        analyserComponent->setMeasuredProcessor (static_cast<const MeasuredProcessor> (cmbMeasuredProcessor.getSelectedId()));
+    };
+
+    lblHarmonicAnalysis.setText("Harmonic analysis", dontSendNotification);
+    lblHarmonicAnalysis.setJustificationType (Justification::centredRight);
+    addAndMakeVisible(lblHarmonicAnalysis);
+
+    cmbHarmonicAnalysis.setTooltip ("Set whether THD, THD+N, SNR, SINAD and the level of each harmonic are measured & shown over the FFT scope.\n\nThe measurements are only made while a source is generating a steady sine (i.e. not sweeping), which is used to locate the fundamental & harmonics. Results are averaged over successive frames so they settle after a few seconds.");
+    cmbHarmonicAnalysis.addItem ("Off", 1);
+    cmbHarmonicAnalysis.addItem ("On", 2);
+    addAndMakeVisible (cmbHarmonicAnalysis);
+    cmbHarmonicAnalysis.setSelectedId (analyserComponent->isHarmonicAnalysisEnabled() ? 2 : 1, dontSendNotification);
+    cmbHarmonicAnalysis.onChange = [this]
+    {
+        analyserComponent->setHarmonicAnalysisEnabled (cmbHarmonicAnalysis.getSelectedId() == 2);
+    };
+
     lblFftAggregation.setText("FFT scope aggregation method", dontSendNotification);
     lblFftAggregation.setJustificationType (Justification::centredRight);
     addAndMakeVisible(lblFftAggregation);
 
     cmbFftAggregation.setTooltip ("Defines how to aggregate samples if there are more than one per pixel in the plot.\n\nThe maximum method will better show the peak value of a harmonic, but will make white noise looks like it tails upwards. The average method will make white noise look flat but is more computationally intensive.");
-    cmbFftAggregation.addItem ("Maximum", static_cast<int> (FftScope<12>::AggregationMethod::Maximum));
-    cmbFftAggregation.addItem ("Average", static_cast<int> (FftScope<12>::AggregationMethod::Average));
+    cmbFftAggregation.addItem ("Maximum", static_cast<int> (FftScope::AggregationMethod::Maximum));
+    cmbFftAggregation.addItem ("Average", static_cast<int> (FftScope::AggregationMethod::Average));
     addAndMakeVisible (cmbFftAggregation);
     cmbFftAggregation.setSelectedId (static_cast<int> (fftScopePtr->getAggregationMethod()), dontSendNotification);
     cmbFftAggregation.onChange = [this, fftScopePtr]
     {
-        fftScopePtr->setAggregationMethod (static_cast<const FftScope<12>::AggregationMethod>(cmbFftAggregation.getSelectedId()));
+        fftScopePtr->setAggregationMethod (static_cast<const FftScope::AggregationMethod>(cmbFftAggregation.getSelectedId()));
     };
     
     lblFftRelease.setText("FFT scope release characteristic", dontSendNotification);
@@ -322,15 +681,48 @@ AnalyserComponent::AnalyserConfigComponent::AnalyserConfigComponent (AnalyserCom
     addAndMakeVisible(lblFftRelease);
 
     cmbFftRelease.setTooltip ("Set the release characteristic for the envelope applied to each FFT amplitude bin.");
-    cmbFftRelease.addItem ("Off", FftScope<12>::ReleaseCharacteristic::Off);
-    cmbFftRelease.addItem ("Quick", FftScope<12>::ReleaseCharacteristic::Quick);
-    cmbFftRelease.addItem ("Medium", FftScope<12>::ReleaseCharacteristic::Medium);
-    cmbFftRelease.addItem ("Slow", FftScope<12>::ReleaseCharacteristic::Slow);
+    cmbFftRelease.addItem ("Off", FftScope::ReleaseCharacteristic::Off);
+    cmbFftRelease.addItem ("Quick", FftScope::ReleaseCharacteristic::Quick);
+    cmbFftRelease.addItem ("Medium", FftScope::ReleaseCharacteristic::Medium);
+    cmbFftRelease.addItem ("Slow", FftScope::ReleaseCharacteristic::Slow);
     addAndMakeVisible (cmbFftRelease);
     cmbFftRelease.setSelectedId (fftScopePtr->getReleaseCharacteristic(), dontSendNotification);
     cmbFftRelease.onChange = [this, fftScopePtr]
     {
-        fftScopePtr->setReleaseCharacteristic (static_cast<const FftScope<12>::ReleaseCharacteristic>(cmbFftRelease.getSelectedId()));
+        fftScopePtr->setReleaseCharacteristic (static_cast<const FftScope::ReleaseCharacteristic>(cmbFftRelease.getSelectedId()));
+    };
+
+    lblFftHold.setText("FFT scope hold traces", dontSendNotification);
+    lblFftHold.setJustificationType (Justification::centredRight);
+    addAndMakeVisible(lblFftHold);
+
+    cmbFftHold.setTooltip ("Set which hold traces are drawn behind the live FFT of each channel.\n\nThe peak hold shows the worst-case spectrum since the traces were restarted (e.g. of a transient) & the minimum hold shows the noise floor over a long run. The timed peak hold releases each peak after two to four seconds. Double click on the FFT scope to restart the hold traces (they also restart when the FFT size, resolution or units change).");
+    cmbFftHold.addItem ("None", static_cast<int> (FftScope::HoldTraces::None));
+    cmbFftHold.addItem ("Peak hold", static_cast<int> (FftScope::HoldTraces::Peak));
+    cmbFftHold.addItem ("Minimum hold", static_cast<int> (FftScope::HoldTraces::Minimum));
+    cmbFftHold.addItem ("Peak & minimum hold", static_cast<int> (FftScope::HoldTraces::PeakAndMinimum));
+    cmbFftHold.addItem ("Timed peak hold", static_cast<int> (FftScope::HoldTraces::TimedPeak));
+    addAndMakeVisible (cmbFftHold);
+    cmbFftHold.setSelectedId (static_cast<int> (fftScopePtr->getHoldTraces()), dontSendNotification);
+    cmbFftHold.onChange = [this, fftScopePtr]
+    {
+        fftScopePtr->setHoldTraces (static_cast<FftScope::HoldTraces> (cmbFftHold.getSelectedId()));
+    };
+
+    lblFftOverlap.setText("FFT frame overlap", dontSendNotification);
+    lblFftOverlap.setJustificationType (Justification::centredRight);
+    addAndMakeVisible(lblFftOverlap);
+
+    cmbFftOverlap.setTooltip ("Set the overlap between successive FFT frames.\n\nHigher overlaps update the FFT scope more often (so short transients are less likely to be missed) but are more computationally intensive.");
+    cmbFftOverlap.addItem ("None", FftProcessor::Overlap::None);
+    cmbFftOverlap.addItem ("50%", FftProcessor::Overlap::Half);
+    cmbFftOverlap.addItem ("75%", FftProcessor::Overlap::ThreeQuarters);
+    cmbFftOverlap.addItem ("87.5%", FftProcessor::Overlap::SevenEighths);
+    addAndMakeVisible (cmbFftOverlap);
+    cmbFftOverlap.setSelectedId (fftProcessorPtr->getOverlap(), dontSendNotification);
+    cmbFftOverlap.onChange = [this, fftProcessorPtr]
+    {
+        fftProcessorPtr->setOverlap (static_cast<const FftProcessor::Overlap>(cmbFftOverlap.getSelectedId()));
     };
 
 
@@ -349,9 +741,103 @@ AnalyserComponent::AnalyserConfigComponent::AnalyserConfigComponent (AnalyserCom
         osc->setAggregationMethod (static_cast<const Oscilloscope::AggregationMethod>(cmbScopeAggregation.getSelectedId()));
     };
 
+    lblAnalysedChannels.setText("Analysed channels", dontSendNotification);
+    lblAnalysedChannels.setJustificationType (Justification::centredRight);
+    addAndMakeVisible(lblAnalysedChannels);
+
+    cmbAnalysedChannels.setTooltip ("Set which channels are analysed & shown by the FFT scope, spectrogram and oscilloscope.\n\nWith high channel counts, analysing only the channels of interest saves most of the CPU used by the analyser (channels that aren't analysed are discarded before any processing). The FFT scope shows the number of channels analysed & the CPU load of the analysis when there are more than two channels. The spectrogram shows the first analysed channel.");
+    addAndMakeVisible (cmbAnalysedChannels);
+    updateChannelList();
+    cmbAnalysedChannels.onChange = [this]
+    {
+        // IDs encode the first channel & the number of channels (an ID of 1 selects every channel)
+        const auto id = cmbAnalysedChannels.getSelectedId() - 1;
+        if (id >= 0)
+            analyserComponent->setAnalysedChannels (id / 128, id % 128);
+    };
+
+    lblScopeView.setText("Oscilloscope view", dontSendNotification);
+    lblScopeView.setJustificationType (Justification::centredRight);
+    addAndMakeVisible(lblScopeView);
+
+    cmbScopeView.setTooltip ("Set what the oscilloscope shows.\n\nThe latest block shows the most recent 4096 samples. Roll mode scrolls through the oscilloscope history as audio arrives (the time axis shows seconds before the latest sample). In roll mode, drag to the right to look back through the history & zoom with the mouse wheel.");
+    cmbScopeView.addItem ("Latest block", Oscilloscope::ViewMode::LatestBlock);
+    cmbScopeView.addItem ("Roll (history)", Oscilloscope::ViewMode::Roll);
+    addAndMakeVisible (cmbScopeView);
+    cmbScopeView.setSelectedId (osc->getViewMode(), dontSendNotification);
+    cmbScopeView.onChange = [this, osc]
+    {
+        osc->setViewMode (static_cast<const Oscilloscope::ViewMode>(cmbScopeView.getSelectedId()));
+    };
+
+    lblScopeHistory.setText("Oscilloscope history length", dontSendNotification);
+    lblScopeHistory.setJustificationType (Justification::centredRight);
+    addAndMakeVisible(lblScopeHistory);
+
+    cmbScopeHistory.setTooltip ("Set the length of audio kept for the oscilloscope's roll mode.\n\nThe history is off by default. The memory is allocated for the analysed channels when the audio device is (re)started, so a change to the length or the analysed channels takes effect then. The history is shortened if it would need more than 256 MB for all the analysed channels.");
+    auto* scopeProcessorPtr = &analyserComponent->audioScopeProcessor;
+    // IDs are the length in seconds plus one (an ID of 1 turns the history off)
+    cmbScopeHistory.addItem ("Off", 1);
+    cmbScopeHistory.addItem ("10 seconds", 11);
+    cmbScopeHistory.addItem ("1 minute", 61);
+    cmbScopeHistory.addItem ("5 minutes", 301);
+    addAndMakeVisible (cmbScopeHistory);
+    cmbScopeHistory.setSelectedId (roundToInt (scopeProcessorPtr->getHistoryLength()) + 1, dontSendNotification);
+    cmbScopeHistory.onChange = [this, scopeProcessorPtr]
+    {
+        scopeProcessorPtr->setHistoryLength (static_cast<float> (cmbScopeHistory.getSelectedId() - 1));
+    };
+
+    lblScopeTrigger.setText("Oscilloscope trigger", dontSendNotification);
+    lblScopeTrigger.setJustificationType (Justification::centredRight);
+    addAndMakeVisible(lblScopeTrigger);
+
+    cmbScopeTrigger.setTooltip ("Set when the oscilloscope is updated.\n\nFree run shows every block, so periodic signals drift across the display. The other modes search the first analysed channel for a trigger & only show the blocks that start just before one (marked by a vertical line), so periodic signals stay still. The level mode triggers on an edge of either polarity. In auto mode, the oscilloscope is also updated if there hasn't been a trigger for a quarter of a second. Triggering doesn't affect roll mode.");
+    // IDs are the trigger mode, plus 16 for auto mode
+    cmbScopeTrigger.addItem ("Free run", AudioScopeProcessor::TriggerMode::FreeRun);
+    cmbScopeTrigger.addItem ("Rising edge (auto)", AudioScopeProcessor::TriggerMode::RisingEdge + 16);
+    cmbScopeTrigger.addItem ("Falling edge (auto)", AudioScopeProcessor::TriggerMode::FallingEdge + 16);
+    cmbScopeTrigger.addItem ("Level (auto)", AudioScopeProcessor::TriggerMode::Level + 16);
+    cmbScopeTrigger.addItem ("Rising edge (normal)", AudioScopeProcessor::TriggerMode::RisingEdge);
+    cmbScopeTrigger.addItem ("Falling edge (normal)", AudioScopeProcessor::TriggerMode::FallingEdge);
+    cmbScopeTrigger.addItem ("Level (normal)", AudioScopeProcessor::TriggerMode::Level);
+    addAndMakeVisible (cmbScopeTrigger);
+    const auto triggerMode = scopeProcessorPtr->getTriggerMode();
+    const auto triggerModeId = triggerMode == AudioScopeProcessor::TriggerMode::FreeRun || !scopeProcessorPtr->isAutoTriggerEnabled() ? triggerMode : triggerMode + 16;
+    cmbScopeTrigger.setSelectedId (triggerModeId, dontSendNotification);
+    cmbScopeTrigger.onChange = [this, scopeProcessorPtr]
+    {
+        const auto id = cmbScopeTrigger.getSelectedId();
+        scopeProcessorPtr->setAutoTrigger (id > 16);
+        scopeProcessorPtr->setTriggerMode (static_cast<const AudioScopeProcessor::TriggerMode> (id % 16));
+    };
+
+    lblScopeTriggerLevel.setText("Oscilloscope trigger level", dontSendNotification);
+    lblScopeTriggerLevel.setJustificationType (Justification::centredRight);
+    addAndMakeVisible(lblScopeTriggerLevel);
+
+    cmbScopeTriggerLevel.setTooltip ("Set the level the signal has to pass through to trigger the oscilloscope (shown by a tick on the trigger line).\n\nThe signal has to move back past the level by a small amount before it can trigger again, so noise around the level doesn't cause false triggers.");
+    // IDs are the index into the list of levels plus one
+    const std::array<float, 9> triggerLevels { -0.5f, -0.1f, -0.01f, 0.0f, 0.001f, 0.01f, 0.1f, 0.25f, 0.5f };
+    for (size_t i = 0; i < triggerLevels.size(); ++i)
+    {
+        const auto level = triggerLevels[i];
+        const auto dbStr = level == 0.0f ? String() : " (" + String (roundToInt (Decibels::gainToDecibels (std::abs (level)))) + " dB)";
+        cmbScopeTriggerLevel.addItem (String (level) + dbStr, static_cast<int> (i) + 1);
+        if (std::abs (level - scopeProcessorPtr->getTriggerLevel()) < 1.0e-6f)
+            cmbScopeTriggerLevel.setSelectedId (static_cast<int> (i) + 1, dontSendNotification);
+    }
+    addAndMakeVisible (cmbScopeTriggerLevel);
+    cmbScopeTriggerLevel.onChange = [this, scopeProcessorPtr, triggerLevels]
+    {
+        const auto index = cmbScopeTriggerLevel.getSelectedId() - 1;
+        if (index >= 0)
+            scopeProcessorPtr->setTriggerLevel (triggerLevels[static_cast<size_t> (index)]);
+    };
+
     const String helpText = "You can pan the waveform in the oscilloscope by dragging it to the left or right. "
         "You can zoom in on the time axis with the mouse wheel. If you hold down the shift key, you can zoom "
-        "the amplitude axis. You can reset the default zoom by double-clicking.";
+        "the amplitude axis. You can reset the default zoom by double-clicking (which also returns roll mode to the latest audio).";
     txtHelp.setText(helpText, false);
     txtHelp.setMultiLine (true);
     txtHelp.setReadOnly (true);
@@ -362,7 +848,35 @@ AnalyserComponent::AnalyserConfigComponent::AnalyserConfigComponent (AnalyserCom
     txtHelp.setColour (TextEditor::ColourIds::outlineColourId, Colours::transparentBlack);
     addAndMakeVisible (txtHelp);
 
-    setSize (800, 300);
+    setSize (800, 940);
+}
+void AnalyserComponent::AnalyserConfigComponent::updateChannelList()
+{
+    const auto numChannels = jmin (64, analyserComponent->numChannels);
+    const auto addItem = [this] (const int first, const int count)
+    {
+        const auto name = count == 1 ? "Channel " + String (first + 1) : "Channels " + String (first + 1) + "-" + String (first + count);
+        cmbAnalysedChannels.addItem (name, first * 128 + count + 1);
+    };
+
+    // Offer groups of eight & pairs with high channel counts, & single channels unless there are too many to list
+    cmbAnalysedChannels.clear (dontSendNotification);
+    cmbAnalysedChannels.addItem ("All channels", 1);
+    for (auto groupSize : { 8, 2, 1 })
+    {
+        if (numChannels <= groupSize || (groupSize == 1 && numChannels > 16))
+            continue;
+        for (auto first = 0; first + groupSize <= numChannels; first += groupSize)
+            addItem (first, groupSize);
+    }
+
+    // Keep the current selection even if it isn't in the list (e.g. if the analyser hasn't been prepared yet)
+    const auto first = analyserComponent->getFirstAnalysedChannel();
+    const auto count = analyserComponent->getNumAnalysedChannels();
+    const auto id = count == 0 ? 1 : first * 128 + count + 1;
+    if (cmbAnalysedChannels.indexOfItemId (id) < 0)
+        addItem (first, count);
+    cmbAnalysedChannels.setSelectedId (id, dontSendNotification);
 }
 void AnalyserComponent::AnalyserConfigComponent::resized ()
 {
@@ -377,6 +891,22 @@ void AnalyserComponent::AnalyserConfigComponent::resized ()
         Track(GUI_BASE_SIZE_PX),
         Track(GUI_BASE_SIZE_PX),
         Track(GUI_BASE_SIZE_PX),
+        Track(GUI_BASE_SIZE_PX),
+        Track(GUI_BASE_SIZE_PX),
+        Track(GUI_BASE_SIZE_PX),
+        Track(GUI_BASE_SIZE_PX),
+        Track(GUI_BASE_SIZE_PX),
+        Track(GUI_BASE_SIZE_PX),
+        Track(GUI_BASE_SIZE_PX),
+        Track(GUI_BASE_SIZE_PX),
+        Track(GUI_BASE_SIZE_PX),
+        Track(GUI_BASE_SIZE_PX),
+        Track(GUI_BASE_SIZE_PX),
+        Track(GUI_BASE_SIZE_PX),
+        Track(GUI_BASE_SIZE_PX),
+        Track(GUI_BASE_SIZE_PX),
+        Track(GUI_BASE_SIZE_PX),
+        Track(GUI_BASE_SIZE_PX),
         Track(1_fr)
     };
 
@@ -387,9 +917,25 @@ void AnalyserComponent::AnalyserConfigComponent::resized ()
 
     grid.items.addArray({
         GridItem(txtHelp).withArea( { }, GridItem::Span (2)),
+        GridItem(lblFftSize), GridItem(cmbFftSize),
+        GridItem(lblFftResolution), GridItem(cmbFftResolution),
+        GridItem(lblFftWindow), GridItem(cmbFftWindow),
+        GridItem(lblFftAveraging), GridItem(cmbFftAveraging),
+        GridItem(lblFftUnits), GridItem(cmbFftUnits),
+        GridItem(lblFftPhase), GridItem(cmbFftPhase),
+        GridItem(lblFftView), GridItem(cmbFftView),
+        GridItem(lblMeasuredProcessor), GridItem(cmbMeasuredProcessor),
+        GridItem(lblHarmonicAnalysis), GridItem(cmbHarmonicAnalysis),
         GridItem(lblFftAggregation), GridItem(cmbFftAggregation),
         GridItem(lblFftRelease), GridItem(cmbFftRelease),
+        GridItem(lblFftHold), GridItem(cmbFftHold),
+        GridItem(lblFftOverlap), GridItem(cmbFftOverlap),
         GridItem(lblScopeAggregation), GridItem(cmbScopeAggregation),
+        GridItem(lblAnalysedChannels), GridItem(cmbAnalysedChannels),
+        GridItem(lblScopeView), GridItem(cmbScopeView),
+        GridItem(lblScopeHistory), GridItem(cmbScopeHistory),
+        GridItem(lblScopeTrigger), GridItem(cmbScopeTrigger),
+        GridItem(lblScopeTriggerLevel), GridItem(cmbScopeTriggerLevel),
     });
 
     grid.performLayout(getLocalBounds().reduced(GUI_GAP_I(2), GUI_GAP_I(2)));
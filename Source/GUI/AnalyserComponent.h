@@ -12,10 +12,18 @@
 
 #include "../JuceLibraryCode/JuceHeader.h"
 #include "FftScope.h"
+#include "Spectrogram.h"
+#include "TransferFunctionScope.h"
+#include "ImpulseResponseScope.h"
+#include "ZoomFftScope.h"
 #include "Oscilloscope.h"
 #include "Goniometer.h"
 #include "MeteringComponents.h"
 #include "../Processing/FftProcessor.h"
+#include "../Processing/HarmonicAnalyser.h"
+#include "../Processing/TransferFunctionAnalyser.h"
+#include "../Processing/SweepMeasurement.h"
+#include "../Processing/ZoomFftProcessor.h"
 #include "../Processing/AudioScopeProcessor.h"
 #include "../Processing/MeteringProcessors.h"
 
@@ -23,6 +31,23 @@ class AnalyserComponent final :  public Component, public dsp::ProcessorBase, pu
 {
 public:
 
+    /** Defines the view shown in place of the FFT scope (values are used as ComboBox IDs). */
+    enum FftView
+    {
+        SpectrumView = 1,       // Amplitude against frequency
+        SpectrogramView,        // Scrolling time-frequency history
+        TransferFunctionView,   // Frequency & phase response of a processor (see setMeasuredProcessor)
+        ImpulseResponseView,    // Impulse response & harmonic distortion of a processor measured with a sine sweep (see setMeasuredProcessor)
+        ZoomFftView             // High resolution spectrum of a narrow band
+    };
+
+    /** Defines which processor's transfer function or impulse response is measured (values are used as ComboBox IDs). */
+    enum MeasuredProcessor
+    {
+        ProcessorA = 1,
+        ProcessorB
+    };
+
     AnalyserComponent();
     ~AnalyserComponent() override;
 
@@ -40,10 +65,62 @@ public:
 
     void showClipStats();
 
+    /** Returns the number of samples needed to fill both the FFT & oscilloscope frames. */
+    int getFrameSize() const;
+
+    /** Sets the frequency of the sine used as a stimulus (or 0 if there isn't one) for harmonic analysis. This is safe to call from the audio thread. */
+    void setStimulusFrequency (const double frequencyInHz);
+
+    /** Sets whether harmonic analysis is performed (the results are shown over the FFT scope). */
+    void setHarmonicAnalysisEnabled (const bool shouldBeEnabled);
+    bool isHarmonicAnalysisEnabled() const;
+
+    /** Sets which view of the FFT data is shown. */
+    void setFftView (const FftView view);
+    FftView getFftView() const;
+
+    /** Sets the longest processor latency that can be compensated for when measuring a transfer function. This must be called before prepare(). */
+    void setMaximumProcessorLatency (const int maximumLatencySamples);
+
+    /** Sets the latency of each processor, which is compensated for when measuring its transfer function. This is safe to call from the
+     *  audio thread (the latencies can change as the processors' controls change). */
+    void setProcessorLatencies (const int latencySamplesA, const int latencySamplesB);
+
+    /** Sets which processor's transfer function is measured (while the transfer function view is shown) & which processor the next sweep
+     *  measurement is played through. */
+    void setMeasuredProcessor (const MeasuredProcessor source);
+    MeasuredProcessor getMeasuredProcessor() const;
+
+    /** Sets which channels are analysed & shown by the FFT scope, spectrogram & oscilloscope (a count of 0 selects every channel). With
+     *  high channel counts, analysing only the channels of interest saves most of the cost of the analysis. */
+    void setAnalysedChannels (const int firstChannel, const int numChannelsToAnalyse);
+    int getFirstAnalysedChannel() const;
+    int getNumAnalysedChannels() const;
+
+    /** Returns true if the transfer function of the given processor is being measured. This is safe to call from the audio thread. */
+    bool isMeasuringTransferFunction (const MeasuredProcessor source) const noexcept;
+
+    /** Appends the signal going into (reference) or coming out of (response) the processor whose transfer function is being measured.
+     *  Call these on the audio thread, with the reference first. */
+    void appendTransferFunctionReference (const dsp::AudioBlock<float>& block);
+    void appendTransferFunctionResponse (const dsp::AudioBlock<float>& block);
+
+    /** Returns true if a sweep measurement is waiting to start or playing through the given processor. This is safe to call from the audio thread. */
+    bool isMeasuringImpulseResponse (const MeasuredProcessor source) const noexcept;
+
+    /** Replaces the input of the processor with the next part of the sweep (call this on the audio thread before processing). */
+    void renderSweep (const dsp::AudioBlock<float>& block);
+
+    /** Captures the output of the processor in response to the sweep (call this on the audio thread after processing). */
+    void captureSweepResponse (const dsp::AudioBlock<float>& block);
+
 private:
 
     int getOscilloscopeMaximumBlockSize() const;
 
+    /** Returns the component for the current FFT view. */
+    Component& getFftViewComponent();
+
     class AnalyserConfigComponent : public Component
     {
     public:
@@ -54,14 +131,49 @@ private:
         //void paint (Graphics& g) override;
         void resized () override;
 
+        /** Refills the list of channel subsets to suit the number of channels the analyser was prepared with. */
+        void updateChannelList();
+
     private:
         AnalyserComponent* analyserComponent;
         Label lblFftAggregation;
         ComboBox cmbFftAggregation;
+        Label lblFftSize;
+        ComboBox cmbFftSize;
+        Label lblFftResolution;
+        ComboBox cmbFftResolution;
+        Label lblFftWindow;
+        ComboBox cmbFftWindow;
+        Label lblFftAveraging;
+        ComboBox cmbFftAveraging;
+        Label lblFftUnits;
+        ComboBox cmbFftUnits;
+        Label lblFftPhase;
+        ComboBox cmbFftPhase;
+        Label lblFftView;
+        ComboBox cmbFftView;
+        Label lblMeasuredProcessor;
+        ComboBox cmbMeasuredProcessor;
+        Label lblHarmonicAnalysis;
+        ComboBox cmbHarmonicAnalysis;
         Label lblFftRelease;
         ComboBox cmbFftRelease;
+        Label lblFftHold;
+        ComboBox cmbFftHold;
+        Label lblFftOverlap;
+        ComboBox cmbFftOverlap;
         Label lblScopeAggregation;
         ComboBox cmbScopeAggregation;
+        Label lblAnalysedChannels;
+        ComboBox cmbAnalysedChannels;
+        Label lblScopeView;
+        ComboBox cmbScopeView;
+        Label lblScopeHistory;
+        ComboBox cmbScopeHistory;
+        Label lblScopeTrigger;
+        ComboBox cmbScopeTrigger;
+        Label lblScopeTriggerLevel;
+        ComboBox cmbScopeTriggerLevel;
         TextEditor txtHelp;
 
         JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AnalyserConfigComponent);
@@ -76,8 +188,24 @@ private:
     std::unique_ptr<DrawableButton> btnExpand{};
     std::unique_ptr<AnalyserConfigComponent> configComponent{};
 
-    FftProcessor<12> fftProcessor;
-    FftScope<12> fftScope;
+    FftProcessor fftProcessor;
+    FftScope fftScope;
+    Spectrogram spectrogram;
+    FftView fftView = SpectrumView;
+    HarmonicAnalyser harmonicAnalyser;
+    Atomic<bool> harmonicAnalysisEnabled = false;
+    TransferFunctionAnalyser transferFunctionAnalyser;
+    TransferFunctionScope transferFunctionScope;
+    Atomic<int> measuredProcessor = ProcessorA;
+    Atomic<int> transferFunctionProcessor = 0; // The MeasuredProcessor being measured (or 0 if none)
+    SweepMeasurement sweepMeasurement;
+    ImpulseResponseScope impulseResponseScope;
+    Atomic<int> sweepProcessor = 0; // The MeasuredProcessor the sweep is played through
+    Atomic<int> processorLatencyA = 0;
+    Atomic<int> processorLatencyB = 0;
+    ZoomFftProcessor zoomFftProcessor;
+    ZoomFftScope zoomFftScope;
+    Atomic<bool> zoomFftEnabled = false;
 
     AudioScopeProcessor audioScopeProcessor;
     Oscilloscope oscilloscope;
@@ -96,6 +224,8 @@ private:
     std::unique_ptr<DialogWindow> clipStatsWindow{};
 
     int numChannels = 0;
+    int firstAnalysedChannel = 0;
+    int numAnalysedChannels = 0; // 0 means all channels
 
     Atomic<bool> statusActive = true;
 
@@ -10,6 +10,7 @@
 
 #include "BenchmarkComponent.h"
 #include "../Main.h"
+#include "../Processing/SimdProcessorHarness.h"
 
 BenchmarkComponent::BenchmarkComponent (ProcessorHarness* processorHarnessA,
                                         ProcessorHarness* processorHarnessB,
@@ -138,6 +139,7 @@ BenchmarkComponent::BenchmarkComponent (ProcessorHarness* processorHarnessA,
     btnStart.onClick = [this]
     {
         // Start running benchmarks on a different thread
+        benchmarkThread.setSimdComparisonEnabled (false);
         benchmarkThread.setProcessSpec (spec);
         benchmarkThread.startRealtimeThread (Thread::RealtimeOptions());
     };
@@ -152,11 +154,29 @@ BenchmarkComponent::BenchmarkComponent (ProcessorHarness* processorHarnessA,
     };
     addAndMakeVisible (btnReset);
 
+    btnCompareSimd.setButtonText ("Compare SIMD");
+    btnCompareSimd.setTooltip ("Compare the scalar & SIMD processing paths (including the cost of transposing channels into SIMD lanes) at 2, 4, 8 & 16 channels - only processors that support SIMD processing are tested");
+    btnCompareSimd.onClick = [this]
+    {
+        benchmarkThread.setSimdComparisonEnabled (true);
+        benchmarkThread.setProcessSpec (spec);
+        benchmarkThread.startRealtimeThread (Thread::RealtimeOptions());
+    };
+    addAndMakeVisible (btnCompareSimd);
+
+    txtSimdResults.setMultiLine (true);
+    txtSimdResults.setReadOnly (true);
+    txtSimdResults.setCaretVisible (false);
+    txtSimdResults.setPopupMenuEnabled (true);
+    txtSimdResults.setFont (normalFont);
+    txtSimdResults.setTextToShowWhenEmpty ("SIMD comparison results will be shown here (durations are averages per process call in microseconds)", Colours::grey);
+    addAndMakeVisible (txtSimdResults);
+
     lblBufferAlignmentStatus.setJustificationType (Justification::centredRight);
     lblBufferAlignmentStatus.setColour (Label::textColourId, Colours::lightgrey);
     addAndMakeVisible (lblBufferAlignmentStatus);
 
-    setSize (690, 430);
+    setSize (690, 560);
     startTimerHz (5);
 }
 BenchmarkComponent::~BenchmarkComponent()
@@ -286,12 +306,13 @@ void BenchmarkComponent::resized()
         GridItem().withArea (1, 7, 6, 7),
         GridItem (lblBlockSize),    GridItem (cmbBlockSize),    GridItem(),     GridItem (lblCycles),       GridItem (cmbCycles),
         GridItem (lblChannels),     GridItem (cmbChannels),     GridItem(),     GridItem (lblIterations),   GridItem (cmbIterations),
-        GridItem (lblSampleRate),   GridItem (cmbSampleRate),   GridItem(),     GridItem(),                 GridItem(),
+        GridItem (lblSampleRate),   GridItem (cmbSampleRate),   GridItem(),     GridItem(),                 GridItem (btnCompareSimd),
         GridItem (lblBufferAlignmentStatus).withArea ({}, GridItem::Span (2)),  GridItem(), GridItem (btnStart), GridItem (btnReset)
     });
 
     resultsGrid.performLayout (getLocalBounds().withHeight (290));
-    controlsGrid.performLayout (getLocalBounds().withTrimmedTop (290));
+    controlsGrid.performLayout (getLocalBounds().withTrimmedTop (290).withHeight (140));
+    txtSimdResults.setBounds (getLocalBounds().withTrimmedTop (430).reduced (GUI_GAP_I (2)));
 }
 void BenchmarkComponent::timerCallback()
 {
@@ -332,6 +353,10 @@ void BenchmarkComponent::setBufferAlignmentStatus (const String& status)
 {
     lblBufferAlignmentStatus.setText (status, sendNotificationSync);
 }
+void BenchmarkComponent::setSimdComparisonResults (const String& results)
+{
+    txtSimdResults.setText (results, false);
+}
 int BenchmarkComponent::getValueLabelIndex (const int processorIndex, const int routineIndex, const int valueIndex) const
 {
     const auto offset = (processorIndex == 0) ? 0 : static_cast<int> (routines.size() * values.size());
@@ -353,6 +378,12 @@ void BenchmarkComponent::BenchmarkThread::run()
     jassert (testCycles > 0 && processingIterations > 0);
     jassert (testSpec.numChannels > 0 && testSpec.maximumBlockSize > 0 && testSpec.sampleRate > 0);
 
+    if (simdComparison)
+    {
+        runSimdComparison();
+        return;
+    }
+
     const dsp::ProcessContextReplacing<float> context (*audioBlock.get());
     
     // Only count non null harnesses
@@ -392,7 +423,8 @@ void BenchmarkComponent::BenchmarkThread::run()
 }
 void BenchmarkComponent::BenchmarkThread::threadComplete (bool /* userPressedCancel */)
 {
-    // Nothing to do here!
+    if (simdComparison)
+        parent->setSimdComparisonResults (simdComparisonResults);
 }
 void BenchmarkComponent::BenchmarkThread::setTestCycles (const int cycles)
 {
@@ -416,6 +448,20 @@ void BenchmarkComponent::BenchmarkThread::setProcessSpec (dsp::ProcessSpec & spe
     srcComponent->prepare (spec);
     const dsp::ProcessContextReplacing<float> context (*audioBlock.get());
     srcComponent->process (context);
+
+    if (simdComparison)
+    {
+        // The SIMD comparison runs at several channel counts, so prepare a block with enough channels for all of them
+        auto simdSpec = spec;
+        simdSpec.numChannels = static_cast<uint32> (simdChannelCounts.back());
+        simdAudioBlock = std::make_unique<dsp::AudioBlock<float>> (simdHeapBlock, simdSpec.numChannels, simdSpec.maximumBlockSize);
+        srcComponent->prepare (simdSpec);
+        srcComponent->process (dsp::ProcessContextReplacing<float> (*simdAudioBlock.get()));
+    }
+}
+void BenchmarkComponent::BenchmarkThread::setSimdComparisonEnabled (const bool shouldCompare)
+{
+    simdComparison = shouldCompare;
 }
 bool BenchmarkComponent::BenchmarkThread::isSseAligned (const float* data)
 {
@@ -431,4 +477,48 @@ String BenchmarkComponent::BenchmarkThread::getAudioBlockAlignmentStatus() const
 		return "AudioBlock is SSE aligned";
 	else
 		return "AudioBlock is not SSE aligned";
-}
\ No newline at end of file
+}
+void BenchmarkComponent::BenchmarkThread::runSimdComparison()
+{
+    jassert (simdAudioBlock);
+
+    // Only count harnesses that support SIMD processing
+    auto numSimdHarnesses = 0;
+    for (auto p : *processingHarnesses)
+        if (dynamic_cast<SimdProcessorHarness*> (p)) numSimdHarnesses++;
+
+    auto numerator = 0;
+    const auto denominator = static_cast<double> (numSimdHarnesses * static_cast<int> (simdChannelCounts.size()));
+    simdComparisonResults.clear();
+    setProgress (0.0);
+
+    for (auto p : *processingHarnesses)
+    {
+        if (!p)
+            continue;
+
+        auto* simdHarness = dynamic_cast<SimdProcessorHarness*> (p);
+        if (!simdHarness)
+        {
+            simdComparisonResults << p->getProcessorName() << ": no SIMD processing path" << newLine;
+            continue;
+        }
+
+        simdComparisonResults << p->getProcessorName() << " (" << static_cast<int> (SimdProcessorHarness::numLanes) << " lanes per SIMD register)" << newLine;
+        for (const auto numChannels : simdChannelCounts)
+        {
+            const auto block = simdAudioBlock->getSubsetChannelBlock (0, static_cast<size_t> (numChannels));
+            const auto result = simdHarness->compareWithScalarPath (block, testSpec.sampleRate, processingIterations);
+
+            simdComparisonResults << "    " << String (numChannels).paddedLeft (' ', 2) << " channels:  "
+                                  << "scalar " << String (result.scalarDuration * 1000.0, 1)
+                                  << "  SIMD " << String (result.simdDuration * 1000.0, 1)
+                                  << " (transpose " << String (result.transposeDuration * 1000.0, 1) << ")"
+                                  << "  speed-up x" << String (result.getSpeedUp(), 2) << newLine;
+
+            numerator++;
+            setProgress (static_cast<double> (numerator) / denominator);
+            if (threadShouldExit()) return;
+        }
+    }
+}
@@ -25,6 +25,7 @@ public:
     void resized() override;
     void timerCallback() override;
     void setBufferAlignmentStatus (const String &status);
+    void setSimdComparisonResults (const String& results);
 
 private:
 
@@ -46,6 +47,9 @@ private:
         /**< Set ProcessSpec to test against. */
         void setProcessSpec (dsp::ProcessSpec& spec);
 
+        /** Set whether the next run compares the scalar & SIMD paths (at 2, 4, 8 & 16 channels) instead of running the test cycles. */
+        void setSimdComparisonEnabled (const bool shouldCompare);
+
     private:
 
         /** Returns true if the specified pointer points to 16 byte aligned data. */
@@ -54,6 +58,9 @@ private:
         /** Returns a string describing the buffer alignment status. */
         String getAudioBlockAlignmentStatus() const;
 
+        /** Compares the scalar & SIMD paths of any harnesses that support SIMD processing. */
+        void runSimdComparison();
+
         std::vector<ProcessorHarness*>* processingHarnesses{};
         SourceComponent* srcComponent;
         BenchmarkComponent* parent;
@@ -62,6 +69,11 @@ private:
         dsp::ProcessSpec testSpec {};
         HeapBlock<char> heapBlock{};
         std::unique_ptr<dsp::AudioBlock<float>> audioBlock{};
+        bool simdComparison = false;
+        String simdComparisonResults{};
+        HeapBlock<char> simdHeapBlock{};
+        std::unique_ptr<dsp::AudioBlock<float>> simdAudioBlock{};
+        const std::vector<int> simdChannelCounts = { 2, 4, 8, 16 };
     };
 
     int getValueLabelIndex (const int processorIndex, const int routineIndex, const int valueIndex) const;
@@ -72,7 +84,8 @@ private:
     OwnedArray<Label> valueLabels{};
     Label lblChannels, lblBlockSize, lblSampleRate, lblCycles, lblIterations, lblBufferAlignmentStatus;
     ComboBox cmbChannels, cmbBlockSize, cmbSampleRate, cmbCycles, cmbIterations;
-    TextButton btnStart, btnReset;
+    TextButton btnStart, btnReset, btnCompareSimd;
+    TextEditor txtSimdResults;
 
     dsp::ProcessSpec spec;
 
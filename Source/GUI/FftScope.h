@@ -11,9 +11,9 @@
 #pragma once
 
 #include "../Processing/FftProcessor.h"
+#include "../Processing/HarmonicAnalyser.h"
 #include "../Processing/FastApproximations.h"
 
-template <int Order>
 class FftScope final : public Component, public Timer
 {
 public:
@@ -34,6 +34,24 @@ public:
         Slow            // Each bin will fade slowly after a peak
     };
 
+    /** Defines the optional overlay drawn over the amplitude of each channel (values are used as ComboBox IDs). */
+    enum class PhaseOverlay : int
+    {
+        None = 1,       // Amplitude only
+        Phase,          // Phase of each bin (wrapped to +/-180 degrees, against the scale on the right)
+        GroupDelay      // Group delay of each bin (the scale on the right spans +/- half the FFT frame)
+    };
+
+    /** Defines which hold traces are drawn behind the amplitude of each channel (values are used as ComboBox IDs). */
+    enum class HoldTraces : int
+    {
+        None = 1,       // No hold traces
+        Peak,           // Infinite peak hold
+        Minimum,        // Infinite minimum hold (shows the noise floor)
+        PeakAndMinimum, // Both infinite holds
+        TimedPeak       // Peak hold which releases each peak after the processor's hold time
+    };
+
     FftScope();
     ~FftScope() override;
 
@@ -41,9 +59,13 @@ public:
     void resized() override;
     void mouseMove(const MouseEvent& event) override;
     void mouseExit(const MouseEvent& event) override;
+    void mouseDoubleClick (const MouseEvent& event) override;
     void timerCallback() override;
 
-    void assignFftProcessor (FftProcessor<Order>* fftMultPtr);
+    void assignFftProcessor (FftProcessor* fftMultPtr);
+
+    /** Assigns a HarmonicAnalyser whose measurements are shown over the FFT (or nullptr to hide them). */
+    void assignHarmonicAnalyser (HarmonicAnalyser* harmonicAnalyserPtr);
 
     // Must be called after FftProcessor:prepare() so that the AudioProbe listeners can be set up properly
     void prepare (const dsp::ProcessSpec& spec);
@@ -56,6 +78,9 @@ public:
     void setDbMax (const float maximumDb);
     float getDbMax() const;
 
+    // Set both limits of the y-axis & update the display
+    void setDbRange (const float minimumDb, const float maximumDb);
+
     // Set minimum frequency for x-axis (defaults to 10Hz otherwise)
     void setFreqMin (const float minimumFreq);
     float getFreqMin() const;
@@ -75,6 +100,24 @@ public:
     /** Get the release characteristic for the envelope applied to each FFT amplitude bin. */
     ReleaseCharacteristic getReleaseCharacteristic() const;
 
+    /** Set the overlay drawn over the amplitude of each channel. Note that the FftProcessor must be computing phase for this to be
+     *  shown (see FftProcessor::setPhaseEnabled), which it only does with a single resolution level. */
+    void setPhaseOverlay (const PhaseOverlay overlay);
+    PhaseOverlay getPhaseOverlay() const;
+
+    /** Set the hold traces drawn behind the amplitude of each channel (this enables or disables hold traces in the FftProcessor). */
+    void setHoldTraces (const HoldTraces traces);
+    HoldTraces getHoldTraces() const;
+
+    /** Restarts the hold traces (also done by double clicking on the scope). */
+    void resetHoldTraces();
+
+    /** Formats a frequency for display (e.g. "1.50 kHz"), optionally without the units (e.g. "1.50K"). */
+    static String hertzToString (const double frequencyInHz, const int numDecimals, const bool appendHz, const bool includeSpace);
+
+    /** Returns the colour used to draw a channel (also used by other scopes to distinguish traces). */
+    static Colour getColourForChannel (const int channel);
+
     /** Allows mouse moves over this component to trigger repaints. This enables cursor co-ordinates to be painted even if audio has been suspended. */
     void setMouseMoveRepaintEnablement (const bool enableRepaints);
 
@@ -92,14 +135,18 @@ private:
     class Foreground final : public Component
     {
     public:
-        explicit Foreground (FftScope<Order>* parentFftScope);
+        explicit Foreground (FftScope* parentFftScope);
         void paint (Graphics& g) override;
     private:
         FftScope* parentScope;
     };
 
-    void paintFft (Graphics& g) const;
+    void paintFft (Graphics& g);
     void paintFftScale (Graphics& g) const;
+    void paintHarmonicMeasurements (Graphics& g);
+    void paintPhase (Graphics& g, const int channel, const FftProcessor::FftFrame& frame);
+    void paintHoldTrace (Graphics& g, const int channel, const FftProcessor::HoldTrace trace, const FftProcessor::FftFrame& frame);
+    Path createTrace (const float* y) const;
 
     inline float toDbVFromLinear (const float linear) const;
     inline float toPxFromLinear (const float linear) const;
@@ -108,14 +155,30 @@ private:
     inline float toHzFromPx (const float xInPixels) const;
     inline float toPxFromHz (const float xInHz) const;
 
-    String hertzToString (const double frequencyInHz, const int numDecimals, const bool appendHz, const bool includeSpace) const;
-    static Colour getColourForChannel (const int channel);
     void preCalculateVariables();
+    void calculateBinPositions (const int fftSize, const int numLevels);
+    static float sum (const float* data, const int num);
 
     Background background;
     Foreground foreground;
-	FftProcessor<Order>* fftProcessor;
-    HeapBlock<float> x, y;
+	FftProcessor* fftProcessor;
+    HarmonicAnalyser* harmonicAnalyser = nullptr;
+    HarmonicAnalyser::Measurement measurement{};
+    HeapBlock<float> x;
+    std::unique_ptr<FftProcessor::PhaseFrame> phaseFrame{};
+    std::unique_ptr<FftProcessor::FftFrame> holdFrame{};
+    PhaseOverlay phaseOverlay = PhaseOverlay::None;
+    HoldTraces holdTraces = HoldTraces::None;
+    int numBinPositions = 0; // Number of bins for which x positions have been calculated (the layout may change at runtime)
+    int binLayoutSize = 0;   // FFT size for which x positions have been calculated
+    int binLayoutLevels = 0; // Number of resolution levels for which x positions have been calculated
+
+    // Groups of consecutive bins that are plotted as a single point (in CSR layout, so group k covers the bins from
+    // pixelGroupStart[k] up to pixelGroupStart[k + 1]). These are recalculated when the size or number of bins changes.
+    HeapBlock<int> pixelGroupStart;
+    HeapBlock<float> pixelGroupX;
+    int numPixelGroups = 0;
+    int firstBin = 1;
 	double samplingFreq = 48000; // will be set correctly in prepare()
     float dbMax = 0.0f;
     float dbMin = -80.0f;
@@ -136,8 +199,8 @@ private:
     bool mouseMoveRepaintsEnabled = false;
     
     ListenerRemovalCallback removeListenerCallback = {};
-    typename WeakReference<FftScope<Order>>::Master masterReference;
-    friend class WeakReference<FftScope<Order>>;
+    WeakReference<FftScope>::Master masterReference;
+    friend class WeakReference<FftScope>;
 
     Atomic<bool> dataFrameReady;
 
@@ -149,35 +212,30 @@ private:
 
 
 // ===========================================================================================
-// Template implementations
+// Implementation
 // ===========================================================================================
 
-template <int Order>
-FftScope<Order>::Background::Background (FftScope* parentFftScope)
+inline FftScope::Background::Background (FftScope* parentFftScope)
     :   parentScope (parentFftScope)
 {
     setBufferedToImage (true);
 }
 
-template <int Order>
-void FftScope<Order>::Background::paint (Graphics& g)
+inline void FftScope::Background::paint (Graphics& g)
 {
     parentScope->paintFftScale (g);
 }
 
-template <int Order>
-FftScope<Order>::Foreground::Foreground (FftScope* parentFftScope)
+inline FftScope::Foreground::Foreground (FftScope* parentFftScope)
     :   parentScope (parentFftScope)
 { }
 
-template <int Order>
-void FftScope<Order>::Foreground::paint (Graphics& g)
+inline void FftScope::Foreground::paint (Graphics& g)
 {
     parentScope->paintFft (g);
 }
 
-template <int Order>
-FftScope<Order>::FftScope ()
+inline FftScope::FftScope ()
     :   background (this),
         foreground (this),
         fftProcessor (nullptr)
@@ -195,28 +253,24 @@ FftScope<Order>::FftScope ()
     startTimer (5);
 }
 
-template <int Order>
-FftScope<Order>::~FftScope ()
+inline FftScope::~FftScope ()
 {
     masterReference.clear();
     // Remove listener callbacks so we don't leave anything hanging if we pop up an FftScope then remove it
     if (removeListenerCallback) removeListenerCallback();
 }
 
-template <int Order>
-void FftScope<Order>::paint (Graphics&)
+inline void FftScope::paint (Graphics&)
 { }
 
-template <int Order>
-void FftScope<Order>::resized ()
+inline void FftScope::resized ()
 {
     preCalculateVariables();
     background.setBounds (getLocalBounds());
     foreground.setBounds (getLocalBounds());
 }
 
-template <int Order>
-void FftScope<Order>::mouseMove (const MouseEvent& event)
+inline void FftScope::mouseMove (const MouseEvent& event)
 {
     currentX = event.x;
     currentY = event.y;
@@ -226,8 +280,7 @@ void FftScope<Order>::mouseMove (const MouseEvent& event)
         repaint();
 }
 
-template <int Order>
-void FftScope<Order>::mouseExit (const MouseEvent&)
+inline void FftScope::mouseExit (const MouseEvent&)
 {
     // Set to -1 to indicate out of bounds
     currentX = -1;
@@ -238,8 +291,12 @@ void FftScope<Order>::mouseExit (const MouseEvent&)
         repaint();
 }
 
-template<int Order>
-inline void FftScope<Order>::timerCallback()
+inline void FftScope::mouseDoubleClick (const MouseEvent&)
+{
+    resetHoldTraces();
+}
+
+inline void FftScope::timerCallback()
 {
     // Only repaint if a new data frame is ready (flag is set by a listener callback from the audio thread)
     if (dataFrameReady.get())
@@ -249,21 +306,28 @@ inline void FftScope<Order>::timerCallback()
     }
 }
 
-template <int Order>
-void FftScope<Order>::assignFftProcessor (FftProcessor<Order>* fftMultPtr)
+inline void FftScope::assignFftProcessor (FftProcessor* fftMultPtr)
 {
     jassert (fftMultPtr != nullptr);
     fftProcessor = fftMultPtr;
-    x.allocate (fftProcessor->getMaximumBlockSize(), true);
-    y.allocate (fftProcessor->getMaximumBlockSize(), true);
+    x.allocate (FftProcessor::maxNumBins, true);
+    pixelGroupStart.allocate (FftProcessor::maxNumBins + 1, true);
+    pixelGroupX.allocate (FftProcessor::maxNumBins, true);
+    phaseFrame = std::make_unique<FftProcessor::PhaseFrame>();
+    holdFrame = std::make_unique<FftProcessor::FftFrame>();
+}
+
+inline void FftScope::assignHarmonicAnalyser (HarmonicAnalyser* harmonicAnalyserPtr)
+{
+    harmonicAnalyser = harmonicAnalyserPtr;
+    repaint();
 }
 
-template <int Order>
-void FftScope<Order>::prepare (const dsp::ProcessSpec& spec)
+inline void FftScope::prepare (const dsp::ProcessSpec& spec)
 {
     samplingFreq = spec.sampleRate;
     preCalculateVariables();
-    WeakReference<FftScope<Order>> weakThis = this;
+    WeakReference<FftScope> weakThis = this;
     removeListenerCallback = fftProcessor->addListenerCallback ([this, weakThis]
     {
         // Check the WeakReference because the callback may live longer than this FftScope
@@ -272,68 +336,67 @@ void FftScope<Order>::prepare (const dsp::ProcessSpec& spec)
     });
 }
 
-template <int Order>
-void FftScope<Order>::setDbMin (const float minimumDb)
+inline void FftScope::setDbMin (const float minimumDb)
 {
     dbMin = minimumDb;
 }
 
-template <int Order>
-float FftScope<Order>::getDbMin () const
+inline float FftScope::getDbMin () const
 {
     return dbMin;
 }
 
-template <int Order>
-void FftScope<Order>::setDbMax (const float maximumDb)
+inline void FftScope::setDbMax (const float maximumDb)
 {
     dbMax = maximumDb;
 }
 
-template <int Order>
-float FftScope<Order>::getDbMax () const
+inline float FftScope::getDbMax () const
 {
     return dbMax;
 }
 
-template <int Order>
-void FftScope<Order>::setFreqMin (const float minimumFreq)
+inline void FftScope::setDbRange (const float minimumDb, const float maximumDb)
+{
+    jassert (minimumDb < maximumDb);
+    dbMin = minimumDb;
+    dbMax = maximumDb;
+    preCalculateVariables();
+    background.repaint();
+    repaint();
+}
+
+inline void FftScope::setFreqMin (const float minimumFreq)
 {
     minFreq = minimumFreq;
 }
 
-template <int Order>
-float FftScope<Order>::getFreqMin () const
+inline float FftScope::getFreqMin () const
 {
     return minFreq;
 }
 
-template <int Order>
-void FftScope<Order>::setFreqMax (const float maximumFreq)
+inline void FftScope::setFreqMax (const float maximumFreq)
 {
     maxFreq = maximumFreq;
 }
 
-template <int Order>
-float FftScope<Order>::getFreqMax () const
+inline float FftScope::getFreqMax () const
 {
     return maxFreq;
 }
 
-template <int Order>
-void FftScope<Order>::setAggregationMethod (const AggregationMethod method)
+inline void FftScope::setAggregationMethod (const AggregationMethod method)
 {
     aggregationMethod = method;
 }
 
-template<int Order>
-typename FftScope<Order>::AggregationMethod FftScope<Order>::getAggregationMethod() const
+inline FftScope::AggregationMethod FftScope::getAggregationMethod() const
 {
     return aggregationMethod;
 }
 
-template<int Order>
-inline void FftScope<Order>::setReleaseCharacteristic(const ReleaseCharacteristic releaseCharacteristic)
+inline void FftScope::setReleaseCharacteristic(const ReleaseCharacteristic releaseCharacteristic)
 {
     switch (releaseCharacteristic) {
     case Quick:
@@ -353,86 +416,102 @@ inline void FftScope<Order>::setReleaseCharacteristic(const ReleaseCharacteristi
     }
 }
 
-template<int Order>
-typename FftScope<Order>::ReleaseCharacteristic FftScope<Order>::getReleaseCharacteristic() const
+inline void FftScope::setPhaseOverlay (const PhaseOverlay overlay)
+{
+    phaseOverlay = overlay;
+    background.repaint();
+    repaint();
+}
+
+inline FftScope::PhaseOverlay FftScope::getPhaseOverlay() const
+{
+    return phaseOverlay;
+}
+
+inline void FftScope::setHoldTraces (const HoldTraces traces)
+{
+    holdTraces = traces;
+    fftProcessor->setHoldTracesEnabled (traces != HoldTraces::None);
+    repaint();
+}
+
+inline FftScope::HoldTraces FftScope::getHoldTraces() const
+{
+    return holdTraces;
+}
+
+inline void FftScope::resetHoldTraces()
+{
+    fftProcessor->resetHoldTraces();
+}
+
+inline FftScope::ReleaseCharacteristic FftScope::getReleaseCharacteristic() const
 {
     if (fftProcessor->isAmplitudeEnvelopeEnabled())
     {
         if (fftProcessor->getAmplitudeEnvelopeReleaseConstant() == quickRelease)
-            return FftScope<Order>::ReleaseCharacteristic::Quick;
+            return FftScope::ReleaseCharacteristic::Quick;
         if (fftProcessor->getAmplitudeEnvelopeReleaseConstant() == mediumRelease)
-            return FftScope<Order>::ReleaseCharacteristic::Medium;
+            return FftScope::ReleaseCharacteristic::Medium;
         if (fftProcessor->getAmplitudeEnvelopeReleaseConstant() == slowRelease)
-            return FftScope<Order>::ReleaseCharacteristic::Slow;
+            return FftScope::ReleaseCharacteristic::Slow;
     }
-    return FftScope<Order>::ReleaseCharacteristic::Off;
+    return FftScope::ReleaseCharacteristic::Off;
 }
 
-template<int Order>
-inline void FftScope<Order>::setMouseMoveRepaintEnablement(const bool enableRepaints)
+inline void FftScope::setMouseMoveRepaintEnablement(const bool enableRepaints)
 {
     mouseMoveRepaintsEnabled = enableRepaints;
 }
 
-template <int Order>
-void FftScope<Order>::paintFft (Graphics& g) const
+inline void FftScope::paintFft (Graphics& g)
 {
     // To speed things up we make sure we stay within the graphics context so we can disable clipping at the component level
 
-    const auto n = fftProcessor->getMaximumBlockSize() / 2;
-    //const auto amplitudeCorrection = 2.0f / static_cast<float> (n); // For Hann window
-    //const auto bottomY = static_cast<float> (getHeight() - 1);
-
     for (auto ch = 0; ch < fftProcessor->getNumChannels(); ++ch)
     {
-        // Copy frequency data and scale
-        fftProcessor->copyFrequencyFrame (y, ch);
-
-        // Create a path representing the freq data for this channel and pre-allocate space
-        Path p;
-        p.preallocateSpace ((getWidth() + 1) * 3); // Will generally be a lot less than this for log frequency scale
+        if (!fftProcessor->isChannelEnabled (ch))
+            continue;
+
+        // Read the latest frequency data in place (the number & spacing of bins depends on the FFT size & resolution levels used to
+        // compute the frame, & the lease stops the analysis thread reusing the frame until we're done)
+        const auto lease = fftProcessor->leaseFrequencyFrame (ch);
+        if (!lease)
+            continue;
+        const auto& frame = *lease.get();
+        if (frame.fftSize != binLayoutSize || frame.numLevels != binLayoutLevels)
+            calculateBinPositions (frame.fftSize, frame.numLevels);
+        if (numPixelGroups == 0)
+            continue;
+
+        // Hold traces are drawn first so that the live trace stays on top
+        if (holdTraces == HoldTraces::Peak || holdTraces == HoldTraces::PeakAndMinimum)
+            paintHoldTrace (g, ch, FftProcessor::PeakHold, frame);
+        if (holdTraces == HoldTraces::Minimum || holdTraces == HoldTraces::PeakAndMinimum)
+            paintHoldTrace (g, ch, FftProcessor::MinHold, frame);
+        if (holdTraces == HoldTraces::TimedPeak)
+            paintHoldTrace (g, ch, FftProcessor::TimedHold, frame);
 
-        // Find first positive x value (important if minFreq is set higher than default
-        auto i = 0;
-        while (x[i] < 0)
-            ++i;
-        p.startNewSubPath (x[i], toPxFromLinear (y[i]));
-        ++i;
-
-        // Iterate through x and plot each point, but aggregate across y if x interval is less than a pixel
-        auto curX = static_cast<int> (x[i]); // x co-ordinate in pixels
-        float aggY; // aggregated y value
-        while (curX < getWidth() && i <= n)
-        {
-            const auto nextX = curX + 1; // next pixel along on x-axis
-            if (aggregationMethod == AggregationMethod::Average)
-            {
-                auto ySum = y[i];
-                auto count = 1;
-                while (i < n && x[i+1] < nextX)
-                {
-                    i++;
-                    ySum += y[i];
-                    count++;
-                }
-                aggY = ySum / static_cast<float> (count);
-            }
-            else // aggregate with maximum
-            {
-                aggY = y[i];
-                while (i < n && x[i+1] < nextX)
-                {
-                    i++;
-                    aggY = jmax (aggY, y[i]);
-                }
-            }
-            p.lineTo (x[i], toPxFromLinear (aggY));
-            ++i;
-            curX = static_cast<int> (x[i]);
-        }
         const auto pst = PathStrokeType (1.0f);
         g.setColour (getColourForChannel (ch));
-        g.strokePath (p, pst);
+        g.strokePath (createTrace (frame.f), pst);
+
+        if (phaseOverlay != PhaseOverlay::None)
+            paintPhase (g, ch, frame);
+    }
+
+    if (harmonicAnalyser != nullptr)
+        paintHarmonicMeasurements (g);
+
+    // With many channels, show how many are analysed & what they cost (the load is that of the analysis thread)
+    if (fftProcessor->getNumChannels() > 2)
+    {
+        g.setColour (Colours::grey);
+        g.setFont (Font (GUI_SIZE_F(0.5)));
+        const auto txt = String (fftProcessor->getNumEnabledChannels()) + " of " + String (fftProcessor->getNumChannels()) + " channels, "
+                         + String (fftProcessor->getAnalysisLoad() * 100.0f, 1) + "% CPU";
+        const auto lblW = GUI_SIZE_I(4.5);
+        g.drawText (txt, getWidth() - lblW - GUI_SIZE_I(0.1), getHeight() - GUI_SIZE_I(1.3), lblW, GUI_SIZE_I(0.6), Justification::centredRight, false);
     }
 
     // Output mouse co-ordinates in Hz/dB
@@ -443,7 +522,7 @@ void FftScope<Order>::paintFft (Graphics& g) const
         const auto freq = toHzFromPx (static_cast<float> (currentX));
         const auto freqStr = hertzToString (freq, 2, true, true);
         const auto dbStr = String (toDbVFromPx (static_cast<float> (currentY)), 1);
-        const auto txt = freqStr + ", " + dbStr + " dB";
+        const auto txt = freqStr + ", " + dbStr + (fftProcessor->isPowerSpectralDensityEnabled() ? " dB/Hz" : " dB");
         const auto offset = GUI_GAP_I(2);
         auto lblX = currentX + offset;
         auto lblY = currentY + offset;
@@ -461,8 +540,132 @@ void FftScope<Order>::paintFft (Graphics& g) const
     }
 }
 
-template <int Order>
-void FftScope<Order>::paintFftScale (Graphics& g) const
+inline Path FftScope::createTrace (const float* y) const
+{
+    // Create a path representing the freq data and pre-allocate space
+    Path p;
+    p.preallocateSpace ((numPixelGroups + 1) * 3);
+    p.startNewSubPath (x[firstBin], toPxFromLinear (y[firstBin]));
+
+    // Plot each group of bins (there is one group per pixel column where bins are closer together than a pixel) reducing
+    // the values in the group first so that only one value per group is converted to pixels
+    for (auto k = 0; k < numPixelGroups; ++k)
+    {
+        const auto begin = pixelGroupStart[k];
+        const auto count = pixelGroupStart[k + 1] - begin;
+        float aggY; // aggregated y value
+        if (count == 1)
+            aggY = y[begin];
+        else if (aggregationMethod == AggregationMethod::Average)
+            aggY = sum (y + begin, count) / static_cast<float> (count);
+        else // aggregate with maximum
+            aggY = FloatVectorOperations::findMaximum (y + begin, count);
+        p.lineTo (pixelGroupX[k], toPxFromLinear (aggY));
+    }
+    return p;
+}
+
+inline void FftScope::paintHoldTrace (Graphics& g, const int channel, const FftProcessor::HoldTrace trace, const FftProcessor::FftFrame& frame)
+{
+    // The hold trace must share the layout of the amplitude frame (it lags by a frame at most when the layout changes)
+    const auto numBins = fftProcessor->copyHoldFrame (*holdFrame, channel, trace);
+    if (numBins == 0 || holdFrame->fftSize != frame.fftSize || holdFrame->numLevels != frame.numLevels)
+        return;
+
+    g.setColour (getColourForChannel (channel).withAlpha (0.45f));
+    g.strokePath (createTrace (holdFrame->f), PathStrokeType (1.0f));
+}
+
+inline void FftScope::paintPhase (Graphics& g, const int channel, const FftProcessor::FftFrame& frame)
+{
+    // Phase is only computed for single resolution frames (& must match the amplitude frame that has just been drawn)
+    const auto numBins = fftProcessor->copyPhaseFrame (*phaseFrame, channel);
+    if (numBins == 0 || phaseFrame->fftSize != frame.fftSize || frame.numLevels != 1 || numPixelGroups == 0)
+        return;
+
+    const auto showPhase = phaseOverlay == PhaseOverlay::Phase;
+    const auto* values = showPhase ? phaseFrame->f : phaseFrame->f + numBins;
+    const auto* y = frame.f;
+    const auto h = static_cast<float> (getHeight());
+    const auto groupDelaySpan = static_cast<float> (static_cast<double> (frame.fftSize) / samplingFreq);
+
+    // Bins more than 60dB below the loudest have meaningless phase, so they leave gaps. Where bins share a pixel column, the
+    // loudest is plotted. Wrapped phase isn't joined up where it jumps from one side of the scale to the other.
+    const auto threshold = FloatVectorOperations::findMaximum (y, numBins) * 0.001f;
+    Path p;
+    p.preallocateSpace ((numPixelGroups + 1) * 3);
+    auto drawing = false;
+    auto previous = 0.0f;
+    for (auto k = 0; k < numPixelGroups; ++k)
+    {
+        auto bin = pixelGroupStart[k];
+        for (auto i = bin + 1; i < pixelGroupStart[k + 1]; ++i)
+            if (y[i] > y[bin])
+                bin = i;
+        if (bin >= numBins || y[bin] < threshold)
+        {
+            drawing = false;
+            continue;
+        }
+
+        auto value = values[bin];
+        float py;
+        if (showPhase)
+        {
+            value -= MathConstants<float>::twoPi * std::round (value / MathConstants<float>::twoPi);
+            py = h * (0.5f - value / MathConstants<float>::twoPi);
+        }
+        else
+            py = h * (0.5f - value / groupDelaySpan);
+
+        if (drawing && !(showPhase && std::abs (value - previous) > MathConstants<float>::pi))
+            p.lineTo (pixelGroupX[k], py);
+        else
+            p.startNewSubPath (pixelGroupX[k], py);
+        drawing = true;
+        previous = value;
+    }
+    g.setColour (getColourForChannel (channel).withAlpha (0.6f));
+    g.strokePath (p, PathStrokeType (1.0f));
+}
+
+inline void FftScope::paintHarmonicMeasurements (Graphics& g)
+{
+    // One line of results per channel in the top right corner (in the colour used for the channel's FFT)
+    g.setFont (Font (GUI_SIZE_F(0.45)));
+    const auto lblX = GUI_GAP_I(2);
+    const auto lblW = getWidth() - 2 * lblX;
+    const auto lblH = GUI_SIZE_I(0.55);
+    auto lblY = GUI_GAP_I(2);
+    for (auto ch = 0; ch < harmonicAnalyser->getNumChannels(); ++ch)
+    {
+        if (!harmonicAnalyser->copyMeasurement (measurement, ch))
+            continue;
+
+        const auto toDb = [] (const float ratio) { return String (Decibels::gainToDecibels (ratio, -200.0f), 1); };
+        auto txt = hertzToString (measurement.fundamentalFrequency, 2, true, true)
+                   + " @ " + String (measurement.fundamentalLevel, 1) + " dBFS"
+                   + "  THD " + String (measurement.thd * 100.0f, 4) + "% (" + toDb (measurement.thd) + " dB)"
+                   + "  THD+N " + String (measurement.thdPlusNoise * 100.0f, 4) + "% (" + toDb (measurement.thdPlusNoise) + " dB)"
+                   + "  SNR " + String (measurement.snr, 1) + " dB"
+                   + "  SINAD " + String (measurement.sinad, 1) + " dB";
+        g.setColour (getColourForChannel (ch));
+        g.drawText (txt, lblX, lblY, lblW, lblH, Justification::centredRight, false);
+        lblY += lblH;
+
+        // Level of each harmonic relative to the fundamental
+        txt.clear();
+        for (auto h = 1; h < measurement.numHarmonics; ++h)
+            txt << "  H" << (h + 1) << " " << String (measurement.harmonicLevels[h], 1);
+        if (txt.isNotEmpty())
+        {
+            g.drawText (txt + " dBc", lblX, lblY, lblW, lblH, Justification::centredRight, false);
+            lblY += lblH;
+        }
+    }
+}
+
+inline void FftScope::paintFftScale (Graphics& g) const
 {
     // To speed things up we make sure we stay within the graphics context so we can disable clipping at the component level
 
@@ -500,6 +703,19 @@ void FftScope<Order>::paintFftScale (Graphics& g) const
         const auto lblH = static_cast<int> (scaleY) + GUI_SIZE_I(0.6);
         //g.drawFittedText (dB, lblX, lblY, lblW, lblH, Justification::topLeft, 1, 1.0f);
         g.drawText (dBStr, lblX, lblY, lblW, lblH, Justification::topLeft, false);
+
+        // The phase overlay is scaled from the centre, so label it on the right against the same gridlines
+        if (phaseOverlay != PhaseOverlay::None && t > 0)
+        {
+            const auto fraction = 0.5f - static_cast<float> (t) / static_cast<float> (numTicks);
+            String overlayStr;
+            if (phaseOverlay == PhaseOverlay::Phase)
+                overlayStr = String (roundToInt (fraction * 360.0f)) + String (CharPointer_UTF8 ("\xc2\xb0"));
+            else
+                overlayStr = String (fraction * static_cast<float> (1000.0 * (1 << fftProcessor->getFftOrder()) / samplingFreq), 1) + " ms";
+            const auto overlayW = GUI_SIZE_I(1.6);
+            g.drawText (overlayStr, getWidth() - overlayW - GUI_SIZE_I(0.1), lblY, overlayW, GUI_SIZE_I(0.5), Justification::topRight, false);
+        }
     }
    
     // Plot frequency scale
@@ -526,8 +742,7 @@ void FftScope<Order>::paintFftScale (Graphics& g) const
 	}
 }
 
-template <int Order>
-inline float FftScope<Order>::toDbVFromLinear (const float linear) const
+inline float FftScope::toDbVFromLinear (const float linear) const
 {
     if (linear <= 0.0f)
         return dbMin;
@@ -536,40 +751,34 @@ inline float FftScope<Order>::toDbVFromLinear (const float linear) const
         return jmax (dbMin, fasterlog2 (linear) * 6.0206f);
 }
 
-template <int Order>
-inline float FftScope<Order>::toPxFromLinear (const float linear) const
+inline float FftScope::toPxFromLinear (const float linear) const
 {
     return toPxFromDbV (toDbVFromLinear (linear));
 }
 
-template <int Order>
-inline float FftScope<Order>::toPxFromDbV(const float dB) const
+inline float FftScope::toPxFromDbV(const float dB) const
 {
     return jmax (1.0f, (dB - dbMax) * yRatio) - 1.0f;
 }
 
-template <int Order>
-inline float FftScope<Order>::toDbVFromPx (const float yInPixels) const
+inline float FftScope::toDbVFromPx (const float yInPixels) const
 {
     return (yInPixels + 1.0f) * yRatioInv  + dbMax;
 }
 
-template <int Order>
-inline float FftScope<Order>::toHzFromPx (const float xInPixels) const
+inline float FftScope::toHzFromPx (const float xInPixels) const
 {
     //return powf(10.0f, xInPixels * xRatioInv + minLogFreq);
     return fastpow10 (xInPixels * xRatioInv + minLogFreq);
 }
 
-template <int Order>
-inline float FftScope<Order>::toPxFromHz (const float xInHz) const
+inline float FftScope::toPxFromHz (const float xInHz) const
 {
     // Only used occasionally so don't need performance
     return (log10 (xInHz) - minLogFreq) * xRatio;
 }
 
-template <int Order>
-String FftScope<Order>::hertzToString (const double frequencyInHz, const int numDecimals, const bool appendHz, const bool includeSpace) const
+inline String FftScope::hertzToString (const double frequencyInHz, const int numDecimals, const bool appendHz, const bool includeSpace)
 {
     String space(includeSpace ? " " : "");
     String units;
@@ -594,8 +803,7 @@ String FftScope<Order>::hertzToString (const double frequencyInHz, const int num
     return frequency + space + units;
 }
 
-template <int Order>
-Colour FftScope<Order>::getColourForChannel (const int channel)
+inline Colour FftScope::getColourForChannel (const int channel)
 {
     switch (channel % 6)
     {
@@ -609,8 +817,7 @@ Colour FftScope<Order>::getColourForChannel (const int channel)
     }
 }
 
-template <int Order>
-void FftScope<Order>::preCalculateVariables()
+inline void FftScope::preCalculateVariables()
 {
     const auto nyquist = static_cast<float> (samplingFreq * 0.5);
     if (maxFreq == 0.0f)
@@ -619,15 +826,74 @@ void FftScope<Order>::preCalculateVariables()
         maxFreq = jmin (maxFreq, nyquist);
     minLogFreq = log10 (minFreq);
     logFreqSpan = log10 (maxFreq) - minLogFreq;
-    const auto n = fftProcessor->getMaximumBlockSize() / 2;
     xRatio = static_cast<float> (getWidth()) / logFreqSpan;
     xRatioInv = 1.0f / xRatio;
-    
-    const auto binToHz = nyquist / static_cast<float> (n);
-    for (auto i = 1; i <= n; ++i)
-        // x[] will hold the x co-ordinate (in pixels) for each bin
-        x[i] = toPxFromHz (static_cast<float> (i) * binToHz);
+
+    if (numBinPositions > 0)
+        calculateBinPositions (binLayoutSize, binLayoutLevels);
 
     yRatio = static_cast<float> (getHeight()) / (dbMin - dbMax);
     yRatioInv = 1.0f / yRatio;
 }
+
+inline void FftScope::calculateBinPositions (const int fftSize, const int numLevels)
+{
+    // The group delay scale depends on the FFT size
+    if (phaseOverlay == PhaseOverlay::GroupDelay)
+        background.repaint();
+
+    const auto numBins = FftProcessor::getNumBins (fftSize, numLevels);
+    jassert (numBins > 1 && numBins <= FftProcessor::maxNumBins);
+    numBinPositions = numBins;
+    binLayoutSize = fftSize;
+    binLayoutLevels = numLevels;
+    const auto n = numBins - 1;
+
+    // x[] will hold the x co-ordinate (in pixels) for each bin (bins aren't evenly spaced in multi-resolution frames)
+    FftProcessor::getBinFrequencies (x.getData(), fftSize, numLevels, samplingFreq);
+    for (auto i = 1; i <= n; ++i)
+        x[i] = toPxFromHz (x[i]);
+
+    // Find first bin that is visible (important if minFreq is set higher than default)
+    firstBin = 1;
+    while (firstBin < n && x[firstBin] < 0.0f)
+        ++firstBin;
+
+    // Group the remaining bins so that bins falling within the same pixel column are aggregated (each group is plotted at the
+    // x co-ordinate of its last bin)
+    numPixelGroups = 0;
+    auto i = firstBin + 1;
+    while (i <= n)
+    {
+        const auto curX = static_cast<int> (x[i]); // x co-ordinate in pixels
+        if (curX >= getWidth())
+            break;
+        const auto nextX = curX + 1; // next pixel along on x-axis
+        pixelGroupStart[numPixelGroups] = i;
+        while (i < n && x[i + 1] < static_cast<float> (nextX))
+            ++i;
+        pixelGroupX[numPixelGroups] = x[i];
+        ++numPixelGroups;
+        ++i;
+    }
+    pixelGroupStart[numPixelGroups] = i;
+}
+
+inline float FftScope::sum (const float* data, const int num)
+{
+    // Sum the unaligned head & tail one at a time and the rest a SIMD register at a time
+    using SIMDFloat = dsp::SIMDRegister<float>;
+    auto total = 0.0f;
+    auto i = 0;
+    while (i < num && !SIMDFloat::isSIMDAligned (data + i))
+        total += data[i++];
+
+    auto accumulator = SIMDFloat::expand (0.0f);
+    for (; i + static_cast<int> (SIMDFloat::SIMDNumElements) <= num; i += static_cast<int> (SIMDFloat::SIMDNumElements))
+        accumulator += SIMDFloat::fromRawArray (data + i);
+    total += accumulator.sum();
+
+    for (; i < num; ++i)
+        total += data[i];
+    return total;
+}
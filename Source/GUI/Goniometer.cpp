@@ -54,11 +54,6 @@ Goniometer::~Goniometer ()
     // Remove listener callbacks so we don't leave anything hanging if we pop up an Goniometer then remove it
     if (removeListenerCallback) removeListenerCallback();
 }
-void Goniometer::paint (Graphics&)
-{
-    for (auto ch = 0; ch < audioScopeProcessor->getNumChannels(); ++ch)
-        audioScopeProcessor->copyFrame (buffer.getWritePointer(ch), ch);
-}
 void Goniometer::resized ()
 {
     background.setBounds (getLocalBounds());
@@ -66,9 +61,12 @@ void Goniometer::resized ()
 }
 void Goniometer::timerCallback()
 {
-    // Only repaint if a new data frame is ready (flag is set by a listener callback from the audio thread)
-    if (dataFrameReady.get())
+    // Only repaint if a new data frame is ready (flag is set by a listener callback from the audio thread) or the channels shown have
+    // changed (frames of channels that have been masked out aren't updated, so they mustn't be left on screen)
+    const auto channelMask = audioScopeProcessor != nullptr ? audioScopeProcessor->getChannelMask() : 0;
+    if (dataFrameReady.get() || channelMask != displayedChannelMask)
     {
+        displayedChannelMask = channelMask;
         repaint();
         dataFrameReady.set (false);
     }
@@ -81,7 +79,6 @@ void Goniometer::assignAudioScopeProcessor (AudioScopeProcessor* audioScopeProce
 void Goniometer::prepare()
 {
     jassert (audioScopeProcessor != nullptr); // audioScopeProcessor should be assigned & prepared first
-    buffer.setSize (audioScopeProcessor->getNumChannels(), audioScopeProcessor->getMaximumBlockSize());
     WeakReference<Goniometer> weakThis = this;
     removeListenerCallback = audioScopeProcessor->addListenerCallback ([this, weakThis]
     {
@@ -94,12 +91,20 @@ void Goniometer::paintWaveform (Graphics& g) const
 {
     // To speed things up we make sure we stay within the graphics context so we can disable clipping at the component level
 
-    if (audioScopeProcessor->getNumChannels() < 2)
+    // Use the first two analysed channels (ignoring extra channels), or show nothing if fewer than two are analysed
+    int channels[2] = { -1, -1 };
+    for (auto ch = 0, n = 0; ch < audioScopeProcessor->getNumChannels() && n < 2; ++ch)
+        if (audioScopeProcessor->isChannelEnabled (ch))
+            channels[n++] = ch;
+    if (channels[1] < 0)
         return;
 
-    // Only use first two channels (ignore extra channels)
-    const auto* x = buffer.getReadPointer (0);
-    const auto* y = buffer.getReadPointer (1);
+    // Read the latest frames in place
+    const auto frameX = audioScopeProcessor->leaseFrame (channels[0]);
+    const auto frameY = audioScopeProcessor->leaseFrame (channels[1]);
+    const auto* x = frameX->f;
+    const auto* y = frameY->f;
+    const auto numSamples = audioScopeProcessor->getMaximumBlockSize();
 
     const auto plotBoundsFloat = getPlotBounds().toFloat();
     const auto cx = plotBoundsFloat.getCentreX() - 0.5f;
@@ -109,7 +114,7 @@ void Goniometer::paintWaveform (Graphics& g) const
     g.setColour (Colours::yellow.withMultipliedAlpha (0.5f));
 
     // Iterate through samples
-    for (auto i = 0; i < buffer.getNumSamples(); i++)
+    for (auto i = 0; i < numSamples; i++)
     {
         // Convert cartesian to polar coordinate
         const auto amplitude = sqrt (x[i] * x[i] + y[i] * y[i]) + 1e-15f; // Anti-denormal float
@@ -19,7 +19,6 @@ public:
     Goniometer();
     ~Goniometer() override;
 
-    void paint (Graphics& g) override;
     void resized() override;
     
     // As the frame size for the audioScopeProcessor is set to 4096, updates arrive at ~11 Hz for a sample rate of 44.1 KHz.
@@ -58,12 +57,12 @@ private:
     Background background;
     Foreground foreground;
 	AudioScopeProcessor* audioScopeProcessor;
-    AudioBuffer<float> buffer;
     CriticalSection criticalSection;
     ListenerRemovalCallback removeListenerCallback = {};
     WeakReference<Goniometer>::Master masterReference;
     friend class WeakReference<Goniometer>;
     Atomic<bool> dataFrameReady;
+    uint64 displayedChannelMask = 0;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (Goniometer)
 };
\ No newline at end of file
@@ -0,0 +1,342 @@
+/*
+  ==============================================================================
+
+    ImpulseResponseScope.h
+    Created: 18 Oct 2026 1:39:43pm
+    Author:  Andrew
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "FftScope.h"
+#include "../Processing/SweepMeasurement.h"
+
+/**
+	Starts exponential sine sweep measurements & displays the results of a SweepMeasurement: the linear impulse response (normalised to
+	its peak) at the top & the magnitude responses of the linear part & each harmonic at the bottom. Harmonic responses are plotted
+	against the frequency that excited them (i.e. the sweep frequency), so the distortion at any frequency can be read off directly as
+	the gap between the linear response & each harmonic.
+
+	Each pixel column shows the bin nearest to its frequency (or the minimum & maximum of the samples it spans for the impulse response).
+*/
+class ImpulseResponseScope final : public Component, public Timer
+{
+public:
+
+    ImpulseResponseScope();
+    ~ImpulseResponseScope() override;
+
+    void paint (Graphics& g) override;
+    void resized() override;
+    void timerCallback() override;
+
+    void assignSweepMeasurement (SweepMeasurement* sweepMeasurementPtr);
+
+    // Must be called after SweepMeasurement:prepare() so that the AudioProbe listener can be set up properly
+    void prepare (const dsp::ProcessSpec& spec);
+
+    // Sets the text used to identify what is being measured
+    void setDescription (const String& text);
+
+    // Called when the measure button is clicked (by default this just starts the measurement)
+    std::function<void()> onMeasure;
+
+private:
+
+    void paintImpulseResponse (Graphics& g, const Rectangle<int>& area) const;
+    void paintMagnitudeResponses (Graphics& g, const Rectangle<int>& area) const;
+    void updateStatus();
+
+    static constexpr float dbMax = 12.0f;
+    static constexpr float dbMin = -108.0f;
+
+	SweepMeasurement* sweepMeasurement = nullptr;
+    std::unique_ptr<SweepMeasurement::Result> result{};
+    bool resultValid = false;
+    String description;
+
+    TextButton btnMeasure;
+    Label lblStatus;
+
+	double samplingFreq = 48000; // will be set correctly in prepare()
+
+    ListenerRemovalCallback removeListenerCallback = {};
+    WeakReference<ImpulseResponseScope>::Master masterReference;
+    friend class WeakReference<ImpulseResponseScope>;
+
+    Atomic<bool> dataFrameReady;
+
+    // Candidate frequencies for labelling the frequency axis
+    Array<float> gridFrequencies = { 20.0f, 50.0f, 125.0f, 250.0f, 500.0f, 1000.0f, 2000.0f, 4000.0f, 8000.0f, 16000.0f, 32000.0f, 64000.0f };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ImpulseResponseScope);
+};
+
+
+// ===========================================================================================
+// Implementation
+// ===========================================================================================
+
+inline ImpulseResponseScope::ImpulseResponseScope()
+{
+    this->setOpaque (true);
+    dataFrameReady.set (false);
+
+    btnMeasure.setButtonText ("Measure");
+    btnMeasure.setTooltip ("Play an exponential sine sweep through the processor & measure its impulse response & harmonic distortion (click again to cancel)");
+    btnMeasure.onClick = [this]
+    {
+        if (sweepMeasurement == nullptr)
+            return;
+        if (sweepMeasurement->getState() == SweepMeasurement::Idle)
+        {
+            if (onMeasure)
+                onMeasure();
+            else
+                sweepMeasurement->startMeasurement();
+        }
+        else
+            sweepMeasurement->cancelMeasurement();
+    };
+    addAndMakeVisible (btnMeasure);
+
+    lblStatus.setJustificationType (Justification::centredLeft);
+    lblStatus.setColour (Label::textColourId, Colours::white);
+    addAndMakeVisible (lblStatus);
+
+    startTimer (50);
+}
+
+inline ImpulseResponseScope::~ImpulseResponseScope()
+{
+    masterReference.clear();
+    // Remove listener callbacks so we don't leave anything hanging if we pop up an ImpulseResponseScope then remove it
+    if (removeListenerCallback) removeListenerCallback();
+}
+
+inline void ImpulseResponseScope::paint (Graphics& g)
+{
+    g.fillAll (Colours::black);
+
+    auto area = getLocalBounds().withTrimmedTop (GUI_BASE_SIZE_I);
+    const auto irArea = area.removeFromTop (area.getHeight() * 2 / 5);
+    paintImpulseResponse (g, irArea);
+    paintMagnitudeResponses (g, area);
+}
+
+inline void ImpulseResponseScope::resized()
+{
+    auto bar = getLocalBounds().removeFromTop (GUI_BASE_SIZE_I).reduced (GUI_GAP_I(1));
+    btnMeasure.setBounds (bar.removeFromLeft (GUI_SIZE_I(3)));
+    lblStatus.setBounds (bar.withTrimmedLeft (GUI_GAP_I(2)));
+}
+
+inline void ImpulseResponseScope::timerCallback()
+{
+    if (!isShowing() || sweepMeasurement == nullptr)
+        return;
+
+    updateStatus();
+
+    // Only draw if a new result is ready (flag is set by a listener callback from the analysis thread)
+    if (dataFrameReady.get())
+    {
+        dataFrameReady.set (false);
+        resultValid = sweepMeasurement->copyResult (*result);
+        updateStatus();
+        repaint();
+    }
+}
+
+inline void ImpulseResponseScope::assignSweepMeasurement (SweepMeasurement* sweepMeasurementPtr)
+{
+    jassert (sweepMeasurementPtr != nullptr);
+    sweepMeasurement = sweepMeasurementPtr;
+    result = std::make_unique<SweepMeasurement::Result>();
+}
+
+inline void ImpulseResponseScope::prepare (const dsp::ProcessSpec& spec)
+{
+    samplingFreq = spec.sampleRate;
+    resultValid = false;
+    updateStatus();
+    repaint();
+    WeakReference<ImpulseResponseScope> weakThis = this;
+    removeListenerCallback = sweepMeasurement->addListenerCallback ([this, weakThis]
+    {
+        // Check the WeakReference because the callback may live longer than this ImpulseResponseScope
+        if (weakThis)
+            dataFrameReady.set (true);
+    });
+}
+
+inline void ImpulseResponseScope::setDescription (const String& text)
+{
+    description = text;
+    updateStatus();
+}
+
+inline void ImpulseResponseScope::updateStatus()
+{
+    if (sweepMeasurement == nullptr)
+        return;
+
+    String status;
+    switch (sweepMeasurement->getState())
+    {
+        case SweepMeasurement::Preparing:
+            status = "Preparing sweep...";
+            break;
+        case SweepMeasurement::Requested:
+            status = "Waiting for " + description + " to start processing...";
+            break;
+        case SweepMeasurement::Playing:
+            status = "Sweeping " + description + "... " + String (roundToInt (sweepMeasurement->getProgress() * 100.0f)) + "%";
+            break;
+        case SweepMeasurement::Analysing:
+            status = "Analysing...";
+            break;
+        case SweepMeasurement::Idle:
+        default:
+            if (sweepMeasurement->hasCaptureOverflowed())
+                status = "Measurement abandoned: the analysis thread fell behind the audio";
+            else if (resultValid)
+                status = description + ": " + FftScope::hertzToString (result->startFrequency, 0, true, true) + " to "
+                    + FftScope::hertzToString (result->endFrequency, 0, true, true) + " sweep";
+            else
+                status = "Click measure to sweep " + description;
+            break;
+    }
+    btnMeasure.setButtonText (sweepMeasurement->getState() == SweepMeasurement::Idle ? "Measure" : "Cancel");
+    lblStatus.setText (status, dontSendNotification);
+}
+
+inline void ImpulseResponseScope::paintImpulseResponse (Graphics& g, const Rectangle<int>& area) const
+{
+    const auto axisColour = Colours::darkgrey.darker();
+    const auto textColour = Colours::grey.darker();
+    g.setColour (axisColour);
+    g.drawRect (area);
+    const auto centreY = static_cast<float> (area.getCentreY());
+    g.drawHorizontalLine (static_cast<int> (centreY), static_cast<float> (area.getX()), static_cast<float> (area.getRight()));
+    if (!resultValid || area.getWidth() <= 0)
+        return;
+
+    // Label the time axis in milliseconds (time zero is the peak)
+    g.setFont (Font (GUI_SIZE_I(0.4)));
+    const auto samplesPerPixel = static_cast<float> (result->numSamples) / static_cast<float> (area.getWidth());
+    const auto msPerPixel = samplesPerPixel * 1000.0f / static_cast<float> (result->sampleRate);
+    const auto zeroX = static_cast<float> (area.getX()) + static_cast<float> (SweepMeasurement::preRingSamples) / samplesPerPixel;
+    const auto msStep = std::pow (10.0f, std::ceil (std::log10 (msPerPixel * static_cast<float> (GUI_SIZE_I(2)))));
+    for (auto ms = 0.0f; zeroX + ms / msPerPixel < static_cast<float> (area.getRight()); ms += msStep)
+    {
+        const auto x = static_cast<int> (zeroX + ms / msPerPixel);
+        g.setColour (axisColour);
+        g.drawVerticalLine (x, static_cast<float> (area.getY()), static_cast<float> (area.getBottom()));
+        g.setColour (textColour);
+        g.drawText (String (ms, ms < 1.0f && ms > 0.0f ? 1 : 0) + "ms", x + GUI_SIZE_I(0.1), area.getBottom() - GUI_SIZE_I(0.6), GUI_SIZE_I(2), GUI_SIZE_I(0.5), Justification::topLeft, false);
+    }
+
+    // Plot the range of each pixel column, normalised to the peak
+    const auto range = FloatVectorOperations::findMinAndMax (result->impulseResponse, result->numSamples);
+    const auto peak = jmax (std::abs (range.getStart()), std::abs (range.getEnd()), 1.0e-12f);
+    const auto scale = 0.45f * static_cast<float> (area.getHeight()) / peak;
+    Path p;
+    p.preallocateSpace (area.getWidth() * 6);
+    for (auto px = 0; px < area.getWidth(); ++px)
+    {
+        const auto begin = static_cast<int> (static_cast<float> (px) * samplesPerPixel);
+        const auto end = jmin (result->numSamples, jmax (begin + 1, static_cast<int> (static_cast<float> (px + 1) * samplesPerPixel)));
+        const auto columnRange = FloatVectorOperations::findMinAndMax (result->impulseResponse + begin, end - begin);
+        const auto x = static_cast<float> (area.getX() + px);
+        if (px == 0)
+            p.startNewSubPath (x, centreY - columnRange.getEnd() * scale);
+        else
+            p.lineTo (x, centreY - columnRange.getEnd() * scale);
+        p.lineTo (x, centreY - columnRange.getStart() * scale);
+    }
+    g.setColour (FftScope::getColourForChannel (0));
+    g.strokePath (p, PathStrokeType (1.0f));
+}
+
+inline void ImpulseResponseScope::paintMagnitudeResponses (Graphics& g, const Rectangle<int>& area) const
+{
+    const auto axisColour = Colours::darkgrey.darker();
+    const auto textColour = Colours::grey.darker();
+    g.setColour (axisColour);
+    g.drawRect (area);
+    if (!resultValid || area.getWidth() <= 0)
+        return;
+
+    const auto minLogFreq = static_cast<float> (std::log10 (result->startFrequency));
+    const auto logFreqSpan = static_cast<float> (std::log10 (result->endFrequency)) - minLogFreq;
+    const auto toPxFromDb = [area] (const float dB)
+    {
+        return static_cast<float> (area.getY()) + static_cast<float> (area.getHeight()) * (dbMax - jlimit (dbMin, dbMax, dB)) / (dbMax - dbMin);
+    };
+
+    // Grid & scales (12dB steps)
+    g.setFont (Font (GUI_SIZE_I(0.4)));
+    for (auto dB = dbMax - 12.0f; dB > dbMin; dB -= 12.0f)
+    {
+        const auto y = static_cast<int> (toPxFromDb (dB));
+        g.setColour (axisColour);
+        g.drawHorizontalLine (y, static_cast<float> (area.getX()), static_cast<float> (area.getRight()));
+        g.setColour (textColour);
+        g.drawText (String (static_cast<int> (dB)), area.getX() + GUI_SIZE_I(0.1), y + GUI_SIZE_I(0.1), GUI_SIZE_I(1.1), GUI_SIZE_I(0.5), Justification::topLeft, false);
+    }
+    auto nextThreshX = area.getX() + GUI_BASE_SIZE_I;
+    for (auto f : gridFrequencies)
+    {
+        if (f < result->startFrequency || f > result->endFrequency)
+            continue;
+        const auto x = area.getX() + static_cast<int> (static_cast<float> (area.getWidth()) * (std::log10 (f) - minLogFreq) / logFreqSpan);
+        if (x >= nextThreshX)
+        {
+            g.setColour (axisColour);
+            g.drawVerticalLine (x, static_cast<float> (area.getY()), static_cast<float> (area.getBottom()));
+            g.setColour (textColour);
+            g.drawFittedText (FftScope::hertzToString (f, 0, false, false), x + GUI_SIZE_I(0.1), area.getBottom() - GUI_SIZE_I(0.6), GUI_BASE_SIZE_I, GUI_SIZE_I(0.5), Justification::topLeft, 1, 1.0f);
+            nextThreshX = x + GUI_BASE_SIZE_I;
+        }
+    }
+
+    // Plot each response against the frequency that excited it (the harmonics are drawn first so the linear response is on top)
+    const auto binsPerHz = static_cast<float> (SweepMeasurement::responseSize / result->sampleRate);
+    for (auto r = result->numResponses - 1; r >= 0; --r)
+    {
+        const auto harmonic = static_cast<float> (r + 1);
+        const auto* magnitude = result->magnitude[r];
+        Path p;
+        p.preallocateSpace (area.getWidth() * 3);
+        auto started = false;
+        for (auto px = 0; px < area.getWidth(); ++px)
+        {
+            const auto frequency = std::pow (10.0f, static_cast<float> (px) / static_cast<float> (area.getWidth()) * logFreqSpan + minLogFreq);
+            const auto bin = roundToInt (frequency * harmonic * binsPerHz);
+            if (bin >= SweepMeasurement::numResponseBins)
+                break;
+            const auto x = static_cast<float> (area.getX() + px);
+            const auto y = toPxFromDb (Decibels::gainToDecibels (magnitude[bin], dbMin - 1.0f));
+            if (started)
+                p.lineTo (x, y);
+            else
+                p.startNewSubPath (x, y);
+            started = true;
+        }
+        g.setColour (FftScope::getColourForChannel (r));
+        g.strokePath (p, PathStrokeType (r == 0 ? 1.5f : 1.0f));
+    }
+
+    // Legend
+    const auto lineHeight = GUI_SIZE_I(0.6);
+    auto textY = area.getY() + GUI_SIZE_I(0.1);
+    for (auto r = 0; r < result->numResponses; ++r)
+    {
+        g.setColour (FftScope::getColourForChannel (r));
+        g.drawText (r == 0 ? String ("Linear") : "H" + String (r + 1), area.getRight() - GUI_SIZE_I(2.1), textY, GUI_SIZE_I(2), lineHeight, Justification::centredRight, false);
+        textY += lineHeight;
+    }
+}
@@ -58,9 +58,9 @@ MainContentComponent::MainContentComponent (AudioDeviceManager& deviceManager)
 void MainContentComponent::prepareToPlay (int samplesPerBlockExpected, double sampleRate)
 {
     sampleCounter.set(0);
-    // Oscilloscope and FftScope use 4096 sample frames
-    // If we want to have a bigger scope buffer then we would need to devise a fancier hold mechanism inside the AnalyserComponent
-    holdSize.set (4096);
+    // Hold for long enough to fill the Oscilloscope and FftScope frames (the FFT size can be changed at runtime)
+    // (the oscilloscope's roll mode shows its history up to the hold as well, so the hold doesn't need to cover the history)
+    holdSize.set (analyserComponent->getFrameSize());
 
     const auto currentDevice = deviceManager.getCurrentAudioDevice();
 	const auto numInputChannels = static_cast<uint32> (currentDevice->getActiveInputChannels().countNumberOfSetBits());
@@ -80,6 +80,16 @@ void MainContentComponent::prepareToPlay (int samplesPerBlockExpected, double sa
     srcComponentB->prepare (spec);
     procComponentA->prepare (spec);
     procComponentB->prepare (spec);
+
+    // The processors' latencies can change while playing (see updateLatencyCompensation), so allow for the longest that can be measured
+    const auto latencyA = procComponentA->getLatencySamples();
+    const auto latencyB = procComponentB->getLatencySamples();
+    const auto maxLatency = jmax (ProcessorHarness::maxMeasurableLatency, latencyA, latencyB);
+    delayCompensatorA.prepare (spec, maxLatency);
+    delayCompensatorB.prepare (spec, maxLatency);
+    analyserComponent->setMaximumProcessorLatency (maxLatency);
+    updateLatencyCompensation();
+
     analyserComponent->prepare (spec);
     monitoringComponent->prepare (spec);
 }
@@ -103,24 +113,37 @@ void MainContentComponent::getNextAudioBlock (const AudioSourceChannelInfo& buff
     srcComponentB->process(dsp::ProcessContextReplacing<float> (srcBufferB));
 
     // Run audio through processors
+    updateLatencyCompensation();
+    auto tempBlock = tempBuffer.getSubBlock (0, static_cast<size_t> (bufferToFill.numSamples));
     if (procComponentA->isProcessorEnabled())
     {
-        routeSourcesAndProcess (procComponentA.get(), tempBuffer);
+        routeSourcesAndProcess (procComponentA.get(), tempBlock);
+        delayCompensatorA.process (tempBlock);
         outputBlock.copyFrom (tempBuffer);
         if (procComponentB->isProcessorEnabled()) // both active
         {
-            routeSourcesAndProcess (procComponentB.get(), tempBuffer);
+            routeSourcesAndProcess (procComponentB.get(), tempBlock);
+            delayCompensatorB.process (tempBlock);
             outputBlock.add (tempBuffer);
         }
     }
     else if (procComponentB->isProcessorEnabled()) // processor A inactive
     {
-        routeSourcesAndProcess (procComponentB.get(), tempBuffer);
+        routeSourcesAndProcess (procComponentB.get(), tempBlock);
+        delayCompensatorB.process (tempBlock);
         outputBlock.copyFrom (tempBuffer);
     }
     else // neither is active
         outputBlock.clear();
 
+    // Use a steady sine from either source as the stimulus for harmonic analysis
+    auto stimulusFrequency = 0.0;
+    if (srcComponentA->getMode() == SourceComponent::Mode::Synthesis)
+        stimulusFrequency = srcComponentA->getSynthesisTab()->getStimulusFrequency();
+    if (stimulusFrequency <= 0.0 && srcComponentB->getMode() == SourceComponent::Mode::Synthesis)
+        stimulusFrequency = srcComponentB->getSynthesisTab()->getStimulusFrequency();
+    analyserComponent->setStimulusFrequency (stimulusFrequency);
+
     // Run audio through analyser (note that the analyser isn't expected to alter the outputBlock)
     if (analyserComponent->isProcessing())
         analyserComponent->process (dsp::ProcessContextReplacing<float> (outputBlock));
@@ -149,6 +172,8 @@ void MainContentComponent::releaseResources()
     srcBufferA.clear();
     srcBufferB.clear();
     tempBuffer.clear();
+    delayCompensatorA.reset();
+    delayCompensatorB.reset();
 }
 void MainContentComponent::paint (Graphics& g)
 {
@@ -271,6 +296,36 @@ SourceComponent* MainContentComponent::getSourceComponentA()
 {
     return srcComponentA.get();
 }
+void MainContentComponent::updateLatencyCompensation()
+{
+    const auto maxLatency = delayCompensatorA.getMaximumDelay();
+    const auto latencyA = jmin (procComponentA->getLatencySamples(), maxLatency);
+    const auto latencyB = jmin (procComponentB->getLatencySamples(), maxLatency);
+    analyserComponent->setProcessorLatencies (latencyA, latencyB);
+
+    // The outputs only need aligning if they're summed (a processor on its own isn't delayed). The compensators cross-fade to a new
+    // delay, so a change doesn't cause a click or a gap.
+    const auto isEnabledA = procComponentA->isProcessorEnabled();
+    const auto isEnabledB = procComponentB->isProcessorEnabled();
+    auto delayA = 0;
+    auto delayB = 0;
+    if (isEnabledA && isEnabledB)
+    {
+        delayA = jmax (latencyA, latencyB) - latencyA;
+        delayB = jmax (latencyA, latencyB) - latencyB;
+    }
+
+    // A compensator isn't fed while its processor is disabled, so clear the audio left in it when the processor is enabled again
+    if (isEnabledA && !compensatorAWasEnabled)
+        delayCompensatorA.reset();
+    if (isEnabledB && !compensatorBWasEnabled)
+        delayCompensatorB.reset();
+    compensatorAWasEnabled = isEnabledA;
+    compensatorBWasEnabled = isEnabledB;
+
+    delayCompensatorA.setDelay (delayA);
+    delayCompensatorB.setDelay (delayB);
+}
 void MainContentComponent::routeSourcesAndProcess (ProcessorComponent* processor, dsp::AudioBlock<float>& temporaryBuffer)
 {
     // Route signal sources
@@ -285,10 +340,26 @@ void MainContentComponent::routeSourcesAndProcess (ProcessorComponent* processor
     else // Neither source is connected
         temporaryBuffer.clear(); 
     
+    // A sine sweep measurement replaces the input to the processor
+    const auto source = processor == procComponentA.get() ? AnalyserComponent::ProcessorA : AnalyserComponent::ProcessorB;
+    const auto measureImpulseResponse = analyserComponent->isMeasuringImpulseResponse (source);
+    if (measureImpulseResponse)
+        analyserComponent->renderSweep (temporaryBuffer);
+
+    // The signal going into the processor is the reference for measuring its transfer function
+    const auto measureTransferFunction = analyserComponent->isMeasuringTransferFunction (source);
+    if (measureTransferFunction)
+        analyserComponent->appendTransferFunctionReference (temporaryBuffer);
+
     // Perform processing
     processor->process (dsp::ProcessContextReplacing<float> (temporaryBuffer));
     
     // Invert processor output as appropriate
     if (processor->isInverted())
         temporaryBuffer.multiplyBy (-1.0f);
+
+    if (measureTransferFunction)
+        analyserComponent->appendTransferFunctionResponse (temporaryBuffer);
+    if (measureImpulseResponse)
+        analyserComponent->captureSweepResponse (temporaryBuffer);
 }
@@ -15,6 +15,7 @@
 #include "ProcessorComponent.h"
 #include "MonitoringComponent.h"
 #include "AnalyserComponent.h"
+#include "../Processing/DelayCompensator.h"
 
 class MainContentComponent final : public AudioAppComponent, public ChangeListener
 {
@@ -59,7 +60,14 @@ private:
     HeapBlock<char> srcBufferMemoryA{}, srcBufferMemoryB{}, tempBufferMemory{};
     dsp::AudioBlock<float> srcBufferA, srcBufferB, tempBuffer;
 
+    // Delays the output of the processor with less latency so that processors A & B are time aligned when summed
+    DelayCompensator delayCompensatorA, delayCompensatorB;
+    bool compensatorAWasEnabled = false, compensatorBWasEnabled = false;
+
     void routeSourcesAndProcess (ProcessorComponent* processor, dsp::AudioBlock<float>&);
 
+    /** Sets the compensating delays from the processors' current latencies (safe to call on the audio thread). */
+    void updateLatencyCompensation();
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MainContentComponent)
 };
\ No newline at end of file
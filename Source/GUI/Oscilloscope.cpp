@@ -55,11 +55,6 @@ Oscilloscope::~Oscilloscope ()
     // Remove listener callbacks so we don't leave anything hanging if we pop up an Oscilloscope then remove it
     if (removeListenerCallback) removeListenerCallback();
 }
-void Oscilloscope::paint (Graphics&)
-{
-    for (auto ch = 0; ch < audioScopeProcessor->getNumChannels(); ++ch)
-        audioScopeProcessor->copyFrame (buffer.getWritePointer(ch), ch);
-}
 void Oscilloscope::resized ()
 {
     preCalculateVariables();
@@ -70,9 +65,22 @@ void Oscilloscope::mouseDown (const MouseEvent&)
 {
     xMinAtLastMouseDown = getXMin();
     xMaxAtLastMouseDown = getXMax();
+    if (viewMode == ViewMode::Roll)
+        historyViewEndAtLastMouseDown = getHistoryViewEnd();
 }
 void Oscilloscope::mouseDrag (const MouseEvent& event)
 {   
+    if (viewMode == ViewMode::Roll)
+    {
+        // Pan back through the history (panning up to the latest sample resumes rolling)
+        const auto span = static_cast<double> (getHistorySpanSamples());
+        const auto delta = static_cast<int64> (static_cast<double> (event.getDistanceFromDragStartX()) * span / getWidth());
+        setHistoryViewEnd (historyViewEndAtLastMouseDown - delta);
+        background.repaint();
+        repaint();
+        return;
+    }
+
     // Pan according to horizontal mouse movement
     const auto span = xMaxAtLastMouseDown - xMinAtLastMouseDown;
     const auto delta = event.getDistanceFromDragStartX() * span / getWidth();
@@ -98,8 +106,11 @@ void Oscilloscope::mouseDoubleClick (const MouseEvent& /*event*/)
     setXMin (0);
     setXMax (defaultMaxXSamples);
     setMaxAmplitude (1.0f);
+    historySpan = defaultHistorySpan;
+    historyFollowsLatest = true;
     preCalculateVariables();
     background.repaint();
+    repaint();
 }
 void Oscilloscope::mouseMove (const MouseEvent& event)
 {
@@ -135,6 +146,18 @@ void Oscilloscope::mouseWheelMove (const MouseEvent& event, const MouseWheelDeta
         background.repaint();
         repaint();
     }
+    else if (viewMode == ViewMode::Roll)
+    {
+        // Zoom time axis by a factor, centred on current position (unless rolling, in which case the latest sample stays at the right)
+        const auto span = getHistorySpanSamples();
+        const auto fraction = static_cast<double> (event.x) / static_cast<double> (getWidth());
+        const auto zoomPos = getHistoryViewEnd() - span + static_cast<int64> (static_cast<double> (span) * fraction);
+        setHistorySpan (historySpan * std::pow (2.0, -static_cast<double> (wheel.deltaY) * 4.0));
+        if (!historyFollowsLatest)
+            setHistoryViewEnd (zoomPos + static_cast<int64> (static_cast<double> (getHistorySpanSamples()) * (1.0 - fraction)));
+        background.repaint();
+        repaint();
+    }
     else
     {
         // Zoom x axis, centred on current position
@@ -177,6 +200,24 @@ void Oscilloscope::mouseWheelMove (const MouseEvent& event, const MouseWheelDeta
 }
 void Oscilloscope::timerCallback()
 {
+    // Roll mode follows the history, which is written for every block regardless of triggering (frames are only published when a
+    // trigger is found), so repaint whenever the history has advanced
+    if (viewMode == ViewMode::Roll && audioScopeProcessor != nullptr)
+    {
+        const auto numSamplesWritten = audioScopeProcessor->getHistory().getNumSamplesWritten();
+        if (numSamplesWritten != historyWrittenAtLastPaint)
+        {
+            historyWrittenAtLastPaint = numSamplesWritten;
+
+            // The time scale is relative to the latest sample, so it moves if the history view isn't rolling
+            if (!historyFollowsLatest)
+                background.repaint();
+            repaint();
+        }
+        dataFrameReady.set (false);
+        return;
+    }
+
     // Only repaint if a new data frame is ready (flag is set by a listener callback from the audio thread)
     if (dataFrameReady.get())
     {
@@ -194,7 +235,6 @@ void Oscilloscope::assignAudioScopeProcessor (AudioScopeProcessor* audioScopePro
 void Oscilloscope::prepare()
 {
     jassert (audioScopeProcessor != nullptr); // audioScopeProcessor should be assigned & prepared first
-    buffer.setSize (audioScopeProcessor->getNumChannels(), audioScopeProcessor->getMaximumBlockSize());
     preCalculateVariables();
     WeakReference<Oscilloscope> weakThis = this;
     removeListenerCallback = audioScopeProcessor->addListenerCallback ([this, weakThis]
@@ -251,6 +291,25 @@ void Oscilloscope::setAggregationMethod (const AggregationMethod method)
 {
     aggregationMethod = method;
 }
+Oscilloscope::ViewMode Oscilloscope::getViewMode() const
+{
+    return viewMode;
+}
+void Oscilloscope::setViewMode (const ViewMode mode)
+{
+    viewMode = mode;
+    historyFollowsLatest = true;
+    background.repaint();
+    repaint();
+}
+double Oscilloscope::getHistorySpan() const
+{
+    return historySpan;
+}
+void Oscilloscope::setHistorySpan (const double spanInSeconds)
+{
+    historySpan = jlimit (0.001, 3600.0, spanInSeconds);
+}
 void Oscilloscope::setMouseMoveRepaintEnablement(const bool enableRepaints)
 {
     mouseMoveRepaintsEnabled = enableRepaints;
@@ -259,79 +318,74 @@ void Oscilloscope::paintWaveform (Graphics& g) const
 {
     // To speed things up we make sure we stay within the graphics context so we can disable clipping at the component level
     
-    for (auto ch = 0; ch < audioScopeProcessor->getNumChannels(); ++ch)
+    if (viewMode == ViewMode::Roll)
+        paintHistoryWaveform (g);
+    else
     {
-        auto* y = buffer.getReadPointer (ch);
+        for (auto ch = 0; ch < audioScopeProcessor->getNumChannels(); ++ch)
+        {
+            if (!audioScopeProcessor->isChannelEnabled (ch))
+                continue;
 
-        if (isnan (y[0]))
-            break;
+            // Read the latest frame in place (the lease stops the audio thread reusing it until we're done)
+            const auto frame = audioScopeProcessor->leaseFrame (ch);
+            auto* y = frame->f;
 
-        // Draw a line representing the wave data for this channel
-        Path p;
-        p.preallocateSpace ((getWidth() + 1) * 3);
-        p.startNewSubPath (0.0f, toPxFromAmp (y[minXSamples]));
+            if (isnan (y[0]))
+                break;
 
-        if (aggregationMethod == AggregationMethod::NearestSample)
-        {
-            // Iterate through pixels on x axis, plotting nearest sample
-            auto lastXInSamples = -1;
-            for (auto xPx = 1; xPx < getWidth(); xPx++)
-            {
-                const auto xInSamples = toTimeFromPx (static_cast<float> (xPx));
-                // Avoid stair-casing by omitting points where x sample hasn't advanced from last pixel
-                if (xInSamples != lastXInSamples)
-                    p.lineTo (static_cast<float> (xPx), toPxFromAmp (y[xInSamples]));
-                lastXInSamples = xInSamples;
-            }
-        }
-        else
-        {
-            // Start path at first value
-            auto i = minXSamples;
-            const auto limit = maxXSamples - 1; // Reduce by 1 because of way while loop is structured
-            auto curPx = toPxFromTime (i);
+            // Draw a line representing the wave data for this channel
+            Path p;
+            p.preallocateSpace ((getWidth() + 1) * 3);
+            p.startNewSubPath (0.0f, toPxFromAmp (y[minXSamples]));
 
-            // Iterate through samples, aggregating to pixels if sample interval is less than a pixel
-            while (i < limit)
+            if (aggregationMethod == AggregationMethod::NearestSample)
             {
-                const auto nextPx = curPx + 1;
-                if (aggregationMethod == AggregationMethod::Average)
+                // Iterate through pixels on x axis, plotting nearest sample
+                auto lastXInSamples = -1;
+                for (auto xPx = 1; xPx < getWidth(); xPx++)
                 {
-                    auto ySum = y[i];
-                    auto count = 1;
-                    while (i < limit && curPx < nextPx)
-                    {
-                        i++;
-                        curPx = toPxFromTime (i);
-                        ySum += y[i];
-                        count++;
-                    }
-                    i++;
-                    p.lineTo (curPx, toPxFromAmp (ySum / static_cast<float> (count)));
+                    const auto xInSamples = toTimeFromPx (static_cast<float> (xPx));
+                    // Avoid stair-casing by omitting points where x sample hasn't advanced from last pixel
+                    if (xInSamples != lastXInSamples)
+                        p.lineTo (static_cast<float> (xPx), toPxFromAmp (y[xInSamples]));
+                    lastXInSamples = xInSamples;
                 }
-                else //if (aggregationMethod == AggregationMethod::Maximum)
+            }
+            else
+            {
+                // Start path at first value
+                auto i = minXSamples;
+                const auto limit = maxXSamples - 1; // Reduce by 1 because of way while loop is structured
+                auto curPx = toPxFromTime (i);
+
+                // Iterate through groups of samples, aggregating to pixels if sample interval is less than a pixel. Each group is aggregated
+                // from the frame's pyramid, so the cost is per pixel rather than per sample
+                while (i < limit)
                 {
-                    auto yMax = y[i];
-                    auto yMaxAbs = std::abs(y[i]);
-
-                    while (i < limit && curPx < nextPx)
-                    {
-                        i++;
-                        curPx = toPxFromTime (i);
-                        if (std::abs(y[i]) > yMaxAbs)
-                        {
-                            yMax = y[i];
-                            yMaxAbs = std::abs(y[i]);
-                        }
-                    }
-                    i++;
-                    p.lineTo (curPx, toPxFromAmp (yMax));
+                    const auto last = findLastSampleInGroup (i, curPx + 1, limit);
+                    const auto value = aggregationMethod == AggregationMethod::Average
+                        ? AudioScopeProcessor::getSum (*frame.get(), i, last + 1) / static_cast<float> (last + 1 - i)
+                        : AudioScopeProcessor::getPeak (*frame.get(), i, last + 1);
+                    curPx = toPxFromTime (last);
+                    i = last + 1;
+                    p.lineTo (curPx, toPxFromAmp (value));
                 }
             }
+            const auto pst = PathStrokeType (1.0f);
+            g.setColour (getColourForChannel (ch));
+            g.strokePath(p, pst);
+
+            // Mark the trigger (found on the first enabled channel) with a line & a tick at the trigger level
+            const auto triggerIndex = frame->triggerIndex;
+            if (ch == audioScopeProcessor->getFirstEnabledChannel() && triggerIndex >= minXSamples && triggerIndex < maxXSamples)
+            {
+                const auto x = toPxFromTime (triggerIndex);
+                g.setColour (Colours::white.withAlpha (0.3f));
+                g.drawVerticalLine (roundToInt (x), 0.0f, static_cast<float> (getHeight()));
+                g.drawHorizontalLine (roundToInt (toPxFromAmp (audioScopeProcessor->getTriggerLevel())), x - GUI_GAP_F(2), x + GUI_GAP_F(2));
+            }
         }
-        const auto pst = PathStrokeType (1.0f);
-        g.setColour (getColourForChannel (ch));
-        g.strokePath(p, pst);
     }
 
     // Output mouse co-ordinates in Hz/linear amplitude
@@ -339,13 +393,15 @@ void Oscilloscope::paintWaveform (Graphics& g) const
     {
         g.setColour (Colours::white);
         g.setFont (Font (GUI_SIZE_F(0.5)));
-        const auto time = toTimeFromPx (static_cast<float> (currentX));
+        const auto timeStr = viewMode == ViewMode::Roll
+            ? getHistoryTimeText (getHistoryViewEnd() - getHistorySpanSamples() * (getWidth() - currentX) / jmax (1, getWidth()), 3)
+            : String (toTimeFromPx (static_cast<float> (currentX)));
 
         const auto yAmp = toAmpFromPx (static_cast<float> (currentY));
         const auto ampStr = String (yAmp, 3);
         const auto yAmpDb = Decibels::gainToDecibels (std::abs (yAmp), -100.0f);
         const auto ampStrDb = String (yAmpDb, 1) + " dB";
-        const auto txt =  String (time) + ", " + ampStr + " | " + ampStrDb;
+        const auto txt =  timeStr + ", " + ampStr + " | " + ampStrDb;
         const auto offset = GUI_GAP_I(2);
         auto lblX = currentX + offset;
         auto lblY = currentY + offset;
@@ -362,6 +418,70 @@ void Oscilloscope::paintWaveform (Graphics& g) const
         g.drawText (txt, lblX, lblY, lblW, lblH, lblJust, false);
     }
 }
+void Oscilloscope::paintHistoryWaveform (Graphics& g) const
+{
+    // Hold a lease so the history can't be reallocated while it's drawn (the lease is invalid while the history is being prepared)
+    const auto& history = audioScopeProcessor->getHistory();
+    const ScopeHistory::ReadLease lease (history);
+    if (!lease.isValid())
+        return;
+    if (!history.isEnabled())
+    {
+        g.setColour (Colours::grey);
+        g.setFont (Font (GUI_SIZE_F(0.5)));
+        g.drawText ("Set an oscilloscope history length (& restart audio) to use roll mode", getLocalBounds(), Justification::centred, false);
+        return;
+    }
+
+    const auto span = getHistorySpanSamples();
+    const auto viewStart = getHistoryViewEnd() - span;
+    const auto samplesPerPx = static_cast<double> (span) / static_cast<double> (jmax (1, getWidth()));
+    const auto numChannels = jmin (audioScopeProcessor->getNumChannels(), history.getNumChannels());
+
+    for (auto ch = 0; ch < numChannels; ++ch)
+    {
+        if (!audioScopeProcessor->isChannelEnabled (ch) || !history.isChannelRecorded (ch))
+            continue;
+
+        // Anything older than this may already have been overwritten (the view can start before the history)
+        const auto oldest = history.getOldestReadableSample();
+        Path p;
+        p.preallocateSpace ((getWidth() + 1) * 6);
+        auto started = false;
+        const auto addPoint = [&p, &started] (const float x, const float y)
+        {
+            if (started)
+                p.lineTo (x, y);
+            else
+                p.startNewSubPath (x, y);
+            started = true;
+        };
+
+        if (samplesPerPx > 1.0)
+        {
+            // Draw the min/max envelope of the samples under each pixel (the pyramid keeps this proportional to the width)
+            for (auto xPx = 0; xPx < getWidth(); ++xPx)
+            {
+                const auto start = viewStart + static_cast<int64> (static_cast<double> (xPx) * samplesPerPx);
+                const auto end = viewStart + static_cast<int64> (static_cast<double> (xPx + 1) * samplesPerPx);
+                if (start < oldest)
+                    continue;
+                const auto range = history.getMinMax (ch, start, end);
+                addPoint (static_cast<float> (xPx), toPxFromAmp (range.getEnd()));
+                p.lineTo (static_cast<float> (xPx), toPxFromAmp (range.getStart()));
+            }
+        }
+        else
+        {
+            // Zoomed in to less than a sample per pixel, so join the samples
+            for (auto t = jmax (viewStart, oldest); t < viewStart + span; ++t)
+                addPoint (static_cast<float> (static_cast<double> (t - viewStart) / samplesPerPx), toPxFromAmp (history.getSample (ch, t)));
+        }
+
+        g.setColour (getColourForChannel (ch));
+        g.strokePath (p, PathStrokeType (1.0f));
+    }
+}
 void Oscilloscope::paintScale (Graphics& g) const
 {
     // To speed things up we make sure we stay within the graphics context so we can disable clipping at the component level
@@ -415,6 +535,12 @@ void Oscilloscope::paintScale (Graphics& g) const
     else if (maxDivsX >= 2) numDivsX = 2;
     //else return;
 
+    if (viewMode == ViewMode::Roll)
+    {
+        paintHistoryScale (g, axisColour, textColour, numDivsX);
+        return;
+    }
+
     // Calculate scale and offset for x axis tick marks
     const auto spanX = maxXSamples - minXSamples;
     const auto scaleX = static_cast<float> (getWidth()) / static_cast<float> (spanX);
@@ -439,6 +565,87 @@ void Oscilloscope::paintScale (Graphics& g) const
         g.drawText (timeStr, lblX, lblY, lblW, lblH, Justification::topLeft, false);
     }
 }
+void Oscilloscope::paintHistoryScale (Graphics& g, const Colour axisColour, const Colour textColour, const int numDivsX) const
+{
+    const auto& history = audioScopeProcessor->getHistory();
+    const ScopeHistory::ReadLease lease (history);
+    if (!lease.isValid() || !history.isEnabled())
+        return;
+
+    // Place ticks at round numbers of seconds before the latest sample (steps of 1, 2 or 5 times a power of ten)
+    const auto sampleRate = history.getSampleRate();
+    const auto span = getHistorySpanSamples();
+    const auto viewEnd = getHistoryViewEnd();
+    const auto spanSeconds = static_cast<double> (span) / sampleRate;
+    const auto minStep = spanSeconds / static_cast<double> (numDivsX);
+    const auto decade = std::pow (10.0, std::floor (std::log10 (minStep)));
+    auto tickStep = decade * 10.0;
+    for (auto multiple : { 1.0, 2.0, 5.0 })
+    {
+        if (decade * multiple >= minStep)
+        {
+            tickStep = decade * multiple;
+            break;
+        }
+    }
+    const auto numDecimalPlaces = jmax (0, -static_cast<int> (std::floor (std::log10 (tickStep))));
+
+    // Labels are drawn to the left of each tick, so the latest sample is labelled at the right edge
+    const auto latestSeconds = static_cast<double> (history.getNumSamplesWritten()) / sampleRate;
+    const auto viewEndSeconds = static_cast<double> (viewEnd) / sampleRate;
+    for (auto tick = static_cast<int64> (std::ceil ((latestSeconds - viewEndSeconds) / tickStep)); ; ++tick)
+    {
+        const auto secondsBeforeLatest = static_cast<double> (tick) * tickStep;
+        const auto fraction = (viewEndSeconds - (latestSeconds - secondsBeforeLatest)) / spanSeconds;
+        if (fraction >= 1.0)
+            break;
+        const auto x = static_cast<int> (static_cast<double> (getWidth()) * (1.0 - fraction));
+        g.setColour (axisColour);
+        if (x < getWidth())
+            g.drawVerticalLine (x, 0.0f, static_cast<float> (getHeight()));
+        g.setColour (textColour);
+        const auto timeStr = tick == 0 ? String ("0 s") : "-" + String (secondsBeforeLatest, numDecimalPlaces) + " s";
+        const auto lblW = GUI_BASE_SIZE_I;
+        const auto lblX = x - lblW - GUI_SIZE_I(0.1);
+        const auto lblY = getHeight() - GUI_SIZE_I(0.6);
+        const auto lblH = GUI_SIZE_I(0.5);
+        g.drawText (timeStr, lblX, lblY, lblW, lblH, Justification::topRight, false);
+    }
+}
+int64 Oscilloscope::getHistorySpanSamples() const
+{
+    const auto& history = audioScopeProcessor->getHistory();
+    const ScopeHistory::ReadLease lease (history);
+    if (!lease.isValid())
+        return 128;
+    const auto span = static_cast<int64> (historySpan * history.getSampleRate());
+    return jlimit (int64 (128), jmax (int64 (128), history.getLength()), span);
+}
+int64 Oscilloscope::getHistoryViewEnd() const
+{
+    const auto latest = audioScopeProcessor->getHistory().getNumSamplesWritten();
+    return historyFollowsLatest ? latest : jmin (historyViewEnd, latest);
+}
+void Oscilloscope::setHistoryViewEnd (const int64 endSample)
+{
+    // Don't pan back beyond the start of the history
+    const auto& history = audioScopeProcessor->getHistory();
+    const ScopeHistory::ReadLease lease (history);
+    if (!lease.isValid())
+        return;
+    const auto latest = history.getNumSamplesWritten();
+    historyViewEnd = jmin (latest, jmax (history.getOldestReadableSample() + getHistorySpanSamples(), endSample));
+    historyFollowsLatest = historyViewEnd >= latest;
+}
+String Oscilloscope::getHistoryTimeText (const int64 sample, const int numDecimalPlaces) const
+{
+    const auto& history = audioScopeProcessor->getHistory();
+    const ScopeHistory::ReadLease lease (history);
+    if (!lease.isValid() || !history.isEnabled())
+        return {};
+    const auto secondsBeforeLatest = static_cast<double> (history.getNumSamplesWritten() - sample) / history.getSampleRate();
+    return String (-secondsBeforeLatest, numDecimalPlaces) + " s";
+}
 inline float Oscilloscope::toAmpFromPx (const float yInPixels) const
 {
     return amplitudeMax - yInPixels * yRatioInv;
@@ -447,6 +654,17 @@ inline float Oscilloscope::toPxFromAmp(const float amplitude) const
 {
     return (amplitudeMax - jlimit (-amplitudeMax, amplitudeMax, amplitude)) * yRatio;
 }
+int Oscilloscope::findLastSampleInGroup (const int firstSample, const float nextPx, const int limit) const
+{
+    // The group runs up to the first sample at or beyond the next pixel. Estimate it, then correct the estimate against
+    // toPxFromTime() so that rounding puts the boundaries in exactly the same place as stepping through every sample would
+    auto t = jmin (limit, jmax (firstSample + 1, minXSamples + static_cast<int> (std::ceil (nextPx * xRatioInv))));
+    while (t > firstSample + 1 && toPxFromTime (t - 1) >= nextPx)
+        --t;
+    while (t < limit && toPxFromTime (t) < nextPx)
+        ++t;
+    return t;
+}
 inline int Oscilloscope::toTimeFromPx (const float xInPixels) const
 {
     return static_cast<int> (xInPixels * xRatioInv) + minXSamples;
@@ -24,10 +24,16 @@ public:
         Average             // This tends to show even lower amplitudes for higher frequency content than the NearestSample method
     };
 
+    /** Defines what is shown on the time axis */
+    enum ViewMode
+    {
+        LatestBlock = 1,    // The latest block from the AudioScopeProcessor (time is shown in samples)
+        Roll                // The AudioScopeProcessor's history, scrolling as audio arrives (time is shown in seconds before the latest sample)
+    };
+
     Oscilloscope();
     ~Oscilloscope() override;
 
-    void paint (Graphics& g) override;
     void resized() override;
     void mouseDown (const MouseEvent& event) override;
     void mouseDrag (const MouseEvent& event) override;
@@ -36,8 +42,9 @@ public:
     void mouseExit (const MouseEvent& event) override;
     void mouseWheelMove (const MouseEvent& event, const MouseWheelDetails& wheel) override;
     
-    // As the frame size for the audioScopeProcessor is set to 4096, updates arrive at ~11 Hz for a sample rate of 44.1 KHz.
-    // Instead of repainting on a fixed timer we poll an atomic flag set from the audio thread to see if there is fresh data.
+    // As the frame size for the audioScopeProcessor is set to 4096, updates arrive at ~11 Hz for a sample rate of 44.1 KHz (or only
+    // when a trigger completes a frame if triggering is enabled). Instead of repainting on a fixed timer we poll an atomic flag set
+    // from the audio thread to see if there is fresh data.
     void timerCallback() override;
 
     void assignAudioScopeProcessor (AudioScopeProcessor* audioScopeProcessorPtr);
@@ -70,6 +77,18 @@ public:
     /** Set aggregation method for sub-pixel x values (otherwise initialised to maximum) */
     void setAggregationMethod (const AggregationMethod method);
 
+    /** Get the view mode */
+    ViewMode getViewMode() const;
+
+    /** Set the view mode (otherwise initialised to the latest block). Roll mode needs the AudioScopeProcessor to record history. */
+    void setViewMode (const ViewMode mode);
+
+    /** Get the length of history shown in roll mode in seconds */
+    double getHistorySpan() const;
+
+    /** Set the length of history shown in roll mode in seconds (limited to the length of the history when drawn) */
+    void setHistorySpan (const double spanInSeconds);
+
     /** Allows mouse moves over this component to trigger repaints. This enables cursor co-ordinates to be painted even if audio has been suspended. */
     void setMouseMoveRepaintEnablement (const bool enableRepaints);
 
@@ -94,12 +113,21 @@ private:
     };
 
     void paintWaveform (Graphics& g) const;
+    void paintHistoryWaveform (Graphics& g) const;
     void paintScale (Graphics& g) const;
+    void paintHistoryScale (Graphics& g, const Colour axisColour, const Colour textColour, const int numDivsX) const;
+
+    // The history view is defined by its length & the position of its right edge (which follows the latest sample unless panned)
+    int64 getHistorySpanSamples() const;
+    int64 getHistoryViewEnd() const;
+    void setHistoryViewEnd (const int64 endSample);
+    String getHistoryTimeText (const int64 sample, const int numDecimalPlaces) const;
 
     inline float toAmpFromPx (const float yInPixels) const;
     inline float toPxFromAmp (const float amplitude) const;
     inline int toTimeFromPx (const float xInPixels) const;
     inline float toPxFromTime (const int xInSamples) const;
+    int findLastSampleInGroup (const int firstSample, const float nextPx, const int limit) const;
 
     static Colour getColourForChannel (const int channel);
     void preCalculateVariables();
@@ -123,8 +151,14 @@ private:
     int xMinAtLastMouseDown = 0;
     int xMaxAtLastMouseDown = 0;
     const int defaultMaxXSamples = 2048 - 1;
+    ViewMode viewMode = ViewMode::LatestBlock;
+    double historySpan = defaultHistorySpan;
+    int64 historyViewEnd = 0;
+    bool historyFollowsLatest = true;
+    int64 historyViewEndAtLastMouseDown = 0;
+    int64 historyWrittenAtLastPaint = -1;
+    static constexpr double defaultHistorySpan = 10.0;
 
-    AudioBuffer<float> buffer;
     CriticalSection criticalSection;
 
     ListenerRemovalCallback removeListenerCallback = {};
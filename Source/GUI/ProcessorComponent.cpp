@@ -10,6 +10,7 @@
 
 #include "ProcessorComponent.h"
 #include "../Main.h"
+#include "../Processing/SimdProcessorHarness.h"
 
 ProcessorComponent::ProcessorComponent (const String& processorId, ProcessorHarness* processorToTest)
     :   keyName ("Processor" + processorId),
@@ -29,6 +30,8 @@ ProcessorComponent::ProcessorComponent (const String& processorId, ProcessorHarn
         config->setAttribute ("Disable", false);
         config->setAttribute ("Invert", false);
         config->setAttribute ("Mute", true);
+        config->setAttribute ("Simd", false);
+        config->setAttribute ("MeasureLatency", false);
     }
 
     addAndMakeVisible (lblTitle);
@@ -82,6 +85,33 @@ ProcessorComponent::ProcessorComponent (const String& processorId, ProcessorHarn
     btnMute.setToggleState (statusMute.get(), dontSendNotification);
     btnMute.onClick = [this] { statusMute = btnMute.getToggleState(); };
 
+    // Only processors with a SIMD path get a button to select it (they use the scalar path unless the user asks otherwise)
+    if (auto* simdHarness = dynamic_cast<SimdProcessorHarness*> (processorToTest))
+    {
+        addAndMakeVisible (btnSimd);
+        btnSimd.setButtonText (TRANS("SIMD"));
+        btnSimd.setTooltip (TRANS("Process groups of channels together using the processor's SIMD path (otherwise the scalar path is used)"));
+        btnSimd.setClickingTogglesState (true);
+        btnSimd.setColour (TextButton::buttonOnColourId, Colours::darkcyan);
+        simdHarness->setSimdProcessingEnabled (config->getBoolAttribute ("Simd", false));
+        btnSimd.setToggleState (simdHarness->isSimdProcessingEnabled(), dontSendNotification);
+        btnSimd.onClick = [this, simdHarness] { simdHarness->setSimdProcessingEnabled (btnSimd.getToggleState()); };
+    }
+
+    // Latency that the processor doesn't report is measured when it's prepared, but only used if the user asks for it (the measurement
+    // can't be relied upon for every processor, e.g. a linear phase filter's impulse response starts well before its latency)
+    addAndMakeVisible (btnLatency);
+    btnLatency.setClickingTogglesState (true);
+    btnLatency.setColour (TextButton::buttonOnColourId, Colours::darkcyan);
+    statusMeasureLatency.set (config->getBoolAttribute ("MeasureLatency", false));
+    btnLatency.setToggleState (statusMeasureLatency.get(), dontSendNotification);
+    btnLatency.onClick = [this]
+    {
+        statusMeasureLatency = btnLatency.getToggleState();
+        if (processor)
+            updateLatency();
+    };
+
     if (!processor)
     {
         disableProcessor();
@@ -98,6 +128,8 @@ ProcessorComponent::ProcessorComponent (const String& processorId, ProcessorHarn
     viewport.setScrollBarsShown (true, false);
     viewport.setViewedComponent (&controlArrayComponent);
     addAndMakeVisible (viewport);
+
+    startTimerHz (4);
 }
 ProcessorComponent::~ProcessorComponent()
 {
@@ -107,6 +139,8 @@ ProcessorComponent::~ProcessorComponent()
     config->setAttribute ("Disable", statusDisable.get());
     config->setAttribute ("Invert", statusInvert.get());
     config->setAttribute ("Mute", statusMute.get());
+    config->setAttribute ("Simd", btnSimd.getToggleState());
+    config->setAttribute ("MeasureLatency", statusMeasureLatency.get());
 
     // Save configuration to application properties
     auto* propertiesFile = DSPTestbenchApplication::getApp().appProperties.getUserSettings();
@@ -129,19 +163,20 @@ void ProcessorComponent::resized()
         Track (GUI_SIZE_PX(0.2)),   // Blank row
         Track (1_fr)                // Remainder used for viewport
     };
-    grid.templateColumns = { Track (GUI_SIZE_PX(3)), Track (GUI_SIZE_PX(1.5)), Track (1_fr), Track (GUI_SIZE_PX(1.8)), Track (GUI_SIZE_PX(1.8)), Track(GUI_BASE_GAP_PX), Track (GUI_SIZE_PX(2.2)), Track (GUI_SIZE_PX(2)), Track (GUI_SIZE_PX(1.7)) };
+    grid.templateColumns = { Track (GUI_SIZE_PX(3)), Track (GUI_SIZE_PX(1.5)), Track (1_fr), Track (GUI_SIZE_PX(1.8)), Track (GUI_SIZE_PX(1.8)), Track (GUI_SIZE_PX(1.8)), Track(GUI_BASE_GAP_PX), Track (GUI_SIZE_PX(2.2)), Track (GUI_SIZE_PX(2)), Track (GUI_SIZE_PX(1.7)) };
     grid.autoFlow = Grid::AutoFlow::row;
     grid.items.addArray({  
         GridItem (lblTitle).withArea ({}, GridItem::Span (2)),
-        GridItem(),
+        GridItem (btnLatency).withWidth (GUI_SIZE_F(2.2)).withJustifySelf (GridItem::JustifySelf::end),
+        GridItem (btnSimd),
         GridItem (btnSourceA),
         GridItem (btnSourceB),
         GridItem(),
         GridItem (btnDisable),
         GridItem (btnInvert),
         GridItem (btnMute),
-        GridItem().withArea ({}, GridItem::Span (9)), // Blank row
-        GridItem (viewport).withArea ({}, GridItem::Span (9))
+        GridItem().withArea ({}, GridItem::Span (10)), // Blank row
+        GridItem (viewport).withArea ({}, GridItem::Span (10))
     });
 
     grid.performLayout (getLocalBounds().reduced (GUI_GAP_I(2), GUI_GAP_I(2)));
@@ -162,10 +197,57 @@ float ProcessorComponent::getPreferredHeight() const
 
     return  jmin (height, maxHeight);
 }
+void ProcessorComponent::timerCallback()
+{
+    // The processor may report a different latency as its controls change (a measured latency only changes when it's prepared)
+    if (processor)
+        updateLatency();
+
+    const auto latency = latencySamples.get();
+    const auto isReported = latencyIsReported.get();
+    const auto isMeasured = statusMeasureLatency.get();
+    if (latency == displayedLatency && isReported == displayedLatencyIsReported && isMeasured == displayedLatencyIsMeasured)
+        return;
+
+    displayedLatency = latency;
+    displayedLatencyIsReported = isReported;
+    displayedLatencyIsMeasured = isMeasured;
+    btnLatency.setButtonText (String (latency) + " smp");
+    if (isReported)
+        btnLatency.setTooltip (String (latency) + " samples latency (reported by processor) - the output of each processor is delayed as needed to time align it with the other when both are enabled");
+    else if (isMeasured)
+        btnLatency.setTooltip (String (latency) + " samples latency (measured from the onset of the processor's impulse response when audio was last started, so restart audio to re-measure it after changing the controls) - the output of each processor is delayed as needed to time align it with the other when both are enabled. Click to stop measuring the latency.");
+    else
+        btnLatency.setTooltip ("The processor doesn't report its latency, so none is assumed. Click to use the latency measured (when audio was last started) from the onset of the processor's impulse response (which suits lookahead & minimum phase processors but not linear phase ones).");
+}
 void ProcessorComponent::prepare (const dsp::ProcessSpec& spec)
 {
     if (processor)
+    {
         processor->prepareHarness (spec);
+
+        // Measure the latency here, as it can't be measured while audio is running (it feeds an impulse through the processor)
+        if (processor->getLatencySamples() < 0)
+            processor->measureLatency();
+        updateLatency();
+    }
+}
+void ProcessorComponent::updateLatency()
+{
+    const auto reportedLatency = processor->getLatencySamples();
+    latencyIsReported.set (reportedLatency >= 0);
+    if (reportedLatency >= 0)
+    {
+        latencySamples.set (reportedLatency);
+    }
+    else if (statusMeasureLatency.get())
+    {
+        latencySamples.set (jmax (0, processor->getMeasuredLatencySamples()));
+    }
+    else
+    {
+        latencySamples.set (0);
+    }
 }
 void ProcessorComponent::process (const dsp::ProcessContextReplacing<float>& context)
 {
@@ -204,6 +286,11 @@ bool ProcessorComponent::isMuted() const noexcept
     // We use a local variable so method is safe to use for audio processing
     return statusMute.get();
 }
+int ProcessorComponent::getLatencySamples() const noexcept
+{
+    // We use a local variable so method is safe to use for audio processing
+    return latencySamples.get();
+}
 void ProcessorComponent::muteProcessor (const bool shouldBeMuted)
 {
     btnMute.setToggleState (shouldBeMuted, sendNotificationSync);
@@ -13,7 +13,7 @@
 #include "../JuceLibraryCode/JuceHeader.h"
 #include "../Processing/ProcessorHarness.h"
 
-class ProcessorComponent final : public Component, dsp::ProcessorBase
+class ProcessorComponent final : public Component, dsp::ProcessorBase, Timer
 {
 public:
     
@@ -23,6 +23,7 @@ public:
     void paint (Graphics& g) override;
     void resized() override;
     float getPreferredHeight() const;
+    void timerCallback() override;
 
     void prepare (const dsp::ProcessSpec& spec) override;
     void process (const dsp::ProcessContextReplacing<float>& context) override;
@@ -36,10 +37,18 @@ public:
     void muteProcessor (const bool shouldBeMuted = true);
     void disableProcessor (const bool shouldBeDisabled = true);
 
+    /** Returns the processor's latency in samples - either reported by the processor, or measured if the user has asked for it to be
+     *  measured (otherwise 0). */
+    int getLatencySamples() const noexcept;
+
     std::shared_ptr<ProcessorHarness> processor {};
 
 private:
-    
+
+    /** Updates latencySamples from the latency the processor reports, or else the latency measured when it was prepared if the user has
+     *  asked for it (otherwise 0). This doesn't measure anything, so it's safe to call while audio is running. */
+    void updateLatency();
+
     class ControlComponent : public Component
     {
     public:
@@ -81,14 +90,20 @@ private:
     TextButton btnDisable;
     TextButton btnInvert;
     TextButton btnMute;
-
-    // TODO - add variable delay so that signals can be time aligned?
+    TextButton btnSimd;
+    TextButton btnLatency;
 
     Atomic<bool> statusSourceA = true;
     Atomic<bool> statusSourceB = false;
     Atomic<bool> statusDisable = false;
     Atomic<bool> statusInvert = false;
     Atomic<bool> statusMute = false;
+    Atomic<bool> statusMeasureLatency = false;
+    Atomic<int> latencySamples = 0;
+    Atomic<bool> latencyIsReported = false;
+    int displayedLatency = -1;
+    bool displayedLatencyIsReported = false;
+    bool displayedLatencyIsMeasured = false;
 
     Viewport viewport;
     OwnedArray<ControlComponent> controlArray {};
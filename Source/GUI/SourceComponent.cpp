@@ -247,6 +247,8 @@ void SynthesisTab::prepare (const dsp::ProcessSpec& spec)
 }
 void SynthesisTab::process (const dsp::ProcessContextReplacing<float>& context)
 {
+    stimulusFrequency.set (currentWaveform == Waveform::Sine && !isSweepEnabled ? currentFrequency : 0.0);
+
     if (isSelectedWaveformOscillatorBased())
     {
         // Set oscillator frequency
@@ -318,6 +320,10 @@ void SynthesisTab::reset()
     stepFunction.reset();
     resetSweep();
 }
+double SynthesisTab::getStimulusFrequency() const
+{
+    return stimulusFrequency.get();
+}
 void SynthesisTab::timerCallback ()
 {
     jassert (isSweepEnabled);
@@ -62,6 +62,10 @@ public:
     void reset() override;    
     void timerCallback() override;
 
+    /** Returns the frequency of the sine being generated, or 0 if the waveform isn't a steady sine (e.g. if it's being swept).
+     *  This is updated by process() so it is safe to call from the audio thread. */
+    double getStimulusFrequency() const;
+
 private:
 
     String keyName;
@@ -94,6 +98,7 @@ private:
     double sweepDuration = 0.0;
     bool isSweepEnabled = false;
     SweepMode currentSweepMode = SweepMode::Wrap;
+    Atomic<double> stimulusFrequency = 0.0;
 
     bool isSelectedWaveformOscillatorBased() const;
     void waveformUpdated();
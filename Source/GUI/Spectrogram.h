@@ -0,0 +1,302 @@
+/*
+  ==============================================================================
+
+    Spectrogram.h
+    Created: 18 Oct 2026 1:27:55pm
+    Author:  Andrew
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "FftScope.h"
+
+/**
+	Scrolling time-frequency view of the frames computed by an FftProcessor (for the first channel). Time runs from left to right &
+	frequency is plotted on a log scale from bottom to top.
+
+	The history is held in an image that is used as a circular buffer, so each new frame only writes a single column of pixels (using
+	a precomputed mapping from pixel rows to bins & a precomputed colour map) rather than redrawing the whole history. The image is
+	blitted in two parts either side of the write position so that the oldest column always appears at the left.
+
+	One column is added for each frame received. If the FFT frame rate is higher than the timer rate then intermediate frames are skipped.
+*/
+class Spectrogram final : public Component, public Timer
+{
+public:
+
+    Spectrogram();
+    ~Spectrogram() override;
+
+    void paint (Graphics& g) override;
+    void resized() override;
+    void timerCallback() override;
+
+    void assignFftProcessor (FftProcessor* fftProcessorPtr);
+
+    // Must be called after FftProcessor:prepare() so that the AudioProbe listeners can be set up properly
+    void prepare (const dsp::ProcessSpec& spec);
+
+    // Set the dB values that map to the bottom & top of the colour map (defaults to -80dB to 0dB otherwise)
+    void setDbRange (const float minimumDb, const float maximumDb);
+
+    // Clear the history
+    void clear();
+
+private:
+
+    /** Writes the latest frame to the next column of the image. */
+    void addColumn (const int numBins);
+
+    /** Recalculates the range of bins that map to each pixel row. */
+    void calculateRowBins (const int fftSize, const int numLevels);
+
+    /** Recalculates the colour for each step in the colour map. */
+    void calculateColourMap();
+
+    inline float toPxFromHz (const float xInHz) const;
+    inline float toHzFromPx (const float yInPixels) const;
+
+    static constexpr int colourMapSize = 256;
+
+	FftProcessor* fftProcessor = nullptr;
+    std::unique_ptr<FftProcessor::FftFrame> frame{};
+    Image image{};
+    int writeColumn = 0; // Column of the image to write the next frame to (the oldest column of the history)
+
+    // Range of bins aggregated into each pixel row (row 0 is at the top). Where bins are further apart than a pixel the nearest bin
+    // is used. These are recalculated when the size or the layout of the frame changes.
+    HeapBlock<float> binFrequencies;
+    HeapBlock<int> rowBinStart;
+    HeapBlock<int> rowBinEnd;
+    int rowLayoutSize = 0;
+    int rowLayoutLevels = 0;
+
+    PixelARGB colourMap [colourMapSize];
+	double samplingFreq = 48000; // will be set correctly in prepare()
+    float dbMax = 0.0f;
+    float dbMin = -80.0f;
+    float minFreq = 10.0f;
+    float minLogFreq = 0.0f;
+    float logFreqSpan = 0.0f;
+
+    ListenerRemovalCallback removeListenerCallback = {};
+    WeakReference<Spectrogram>::Master masterReference;
+    friend class WeakReference<Spectrogram>;
+
+    Atomic<bool> dataFrameReady;
+
+    // Candidate frequencies for labelling the frequency axis
+    Array<float> gridFrequencies = { 20.0f, 50.0f, 125.0f, 250.0f, 500.0f, 1000.0f, 2000.0f, 4000.0f, 8000.0f, 16000.0f, 32000.0f, 64000.0f };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (Spectrogram);
+};
+
+
+// ===========================================================================================
+// Implementation
+// ===========================================================================================
+
+inline Spectrogram::Spectrogram()
+{
+    this->setOpaque (true);
+    calculateColourMap();
+    dataFrameReady.set (false);
+    startTimer (5);
+}
+
+inline Spectrogram::~Spectrogram()
+{
+    masterReference.clear();
+    // Remove listener callbacks so we don't leave anything hanging if we pop up a Spectrogram then remove it
+    if (removeListenerCallback) removeListenerCallback();
+}
+
+inline void Spectrogram::paint (Graphics& g)
+{
+    if (!image.isValid() || logFreqSpan <= 0.0f)
+    {
+        g.fillAll (Colours::black);
+        return;
+    }
+
+    // Draw the oldest part of the history (from the write position onwards) at the left, followed by the newest part
+    const auto w = image.getWidth();
+    const auto h = image.getHeight();
+    const auto oldestWidth = w - writeColumn;
+    g.drawImage (image, 0, 0, oldestWidth, h, writeColumn, 0, oldestWidth, h);
+    if (writeColumn > 0)
+        g.drawImage (image, oldestWidth, 0, writeColumn, h, 0, 0, writeColumn, h);
+
+    // Label the frequency axis
+    g.setColour (Colours::grey);
+    g.setFont (Font (GUI_SIZE_I(0.4)));
+    auto nextThreshY = h - GUI_SIZE_I(0.5);
+    for (auto f : gridFrequencies)
+    {
+        const auto scaleY = static_cast<int> (toPxFromHz (f));
+        if (f < minFreq || f > samplingFreq * 0.5 || scaleY > nextThreshY)
+            continue;
+        g.drawText (FftScope::hertzToString (f, 0, false, false), GUI_SIZE_I(0.1), scaleY - GUI_SIZE_I(0.25), GUI_BASE_SIZE_I, GUI_SIZE_I(0.5), Justification::centredLeft, false);
+        nextThreshY = scaleY - GUI_BASE_SIZE_I;
+    }
+}
+
+inline void Spectrogram::resized()
+{
+    // The history is cleared when the size changes
+    if (getWidth() > 0 && getHeight() > 0)
+        image = Image (Image::ARGB, getWidth(), getHeight(), false);
+    else
+        image = Image();
+    clear();
+
+    rowBinStart.allocate (static_cast<size_t> (jmax (1, getHeight())), true);
+    rowBinEnd.allocate (static_cast<size_t> (jmax (1, getHeight())), true);
+    if (rowLayoutSize > 0)
+        calculateRowBins (rowLayoutSize, rowLayoutLevels);
+}
+
+inline void Spectrogram::timerCallback()
+{
+    // Only draw if a new data frame is ready (flag is set by a listener callback from the analysis thread)
+    if (dataFrameReady.get())
+    {
+        dataFrameReady.set (false);
+        if (!isShowing() || !image.isValid() || fftProcessor->getNumChannels() == 0)
+            return;
+
+        // The spectrogram shows the first channel that is being analysed
+        const auto channel = fftProcessor->getFirstEnabledChannel();
+        if (channel < 0)
+            return;
+        const auto numBins = fftProcessor->copyFrequencyFrame (*frame, channel);
+        if (numBins == 0)
+            return;
+
+        addColumn (numBins);
+        repaint();
+    }
+}
+
+inline void Spectrogram::assignFftProcessor (FftProcessor* fftProcessorPtr)
+{
+    jassert (fftProcessorPtr != nullptr);
+    fftProcessor = fftProcessorPtr;
+    binFrequencies.allocate (FftProcessor::maxNumBins, true);
+    frame = std::make_unique<FftProcessor::FftFrame>();
+}
+
+inline void Spectrogram::prepare (const dsp::ProcessSpec& spec)
+{
+    samplingFreq = spec.sampleRate;
+    minLogFreq = log10 (minFreq);
+    logFreqSpan = static_cast<float> (log10 (samplingFreq * 0.5)) - minLogFreq;
+    rowLayoutSize = 0;
+    rowLayoutLevels = 0;
+    clear();
+    WeakReference<Spectrogram> weakThis = this;
+    removeListenerCallback = fftProcessor->addListenerCallback ([this, weakThis]
+    {
+        // Check the WeakReference because the callback may live longer than this Spectrogram
+        if (weakThis)
+            dataFrameReady.set (true);
+    });
+}
+
+inline void Spectrogram::setDbRange (const float minimumDb, const float maximumDb)
+{
+    jassert (minimumDb < maximumDb);
+    dbMin = minimumDb;
+    dbMax = maximumDb;
+    clear();
+}
+
+inline void Spectrogram::clear()
+{
+    if (image.isValid())
+        image.clear (image.getBounds(), Colours::black);
+    writeColumn = 0;
+    repaint();
+}
+
+inline void Spectrogram::addColumn (const int numBins)
+{
+    if (frame->fftSize != rowLayoutSize || frame->numLevels != rowLayoutLevels)
+        calculateRowBins (frame->fftSize, frame->numLevels);
+
+    const auto* y = frame->f;
+    const auto colourScale = static_cast<float> (colourMapSize - 1) / (dbMax - dbMin);
+    const Image::BitmapData bitmap (image, writeColumn, 0, 1, image.getHeight(), Image::BitmapData::writeOnly);
+    for (auto row = 0; row < image.getHeight(); ++row)
+    {
+        const auto begin = rowBinStart[row];
+        const auto count = rowBinEnd[row] - begin;
+        auto index = 0;
+        if (count > 0 && begin + count <= numBins)
+        {
+            // Aggregate with maximum so that tones don't fade as they get narrower than a pixel
+            const auto linear = count == 1 ? y[begin] : FloatVectorOperations::findMaximum (y + begin, count);
+            if (linear > 0.0f)
+                index = jlimit (0, colourMapSize - 1, static_cast<int> ((fasterlog2 (linear) * 6.0206f - dbMin) * colourScale));
+        }
+        *reinterpret_cast<PixelARGB*> (bitmap.getPixelPointer (0, row)) = colourMap[index];
+    }
+
+    if (++writeColumn >= image.getWidth())
+        writeColumn = 0;
+}
+
+inline void Spectrogram::calculateRowBins (const int fftSize, const int numLevels)
+{
+    rowLayoutSize = fftSize;
+    rowLayoutLevels = numLevels;
+    const auto numBins = FftProcessor::getNumBins (fftSize, numLevels);
+    FftProcessor::getBinFrequencies (binFrequencies.getData(), fftSize, numLevels, samplingFreq);
+
+    // Each row covers the bins from the frequency at its lower edge up to (but not including) the frequency at its upper edge
+    const auto* first = binFrequencies.getData();
+    const auto* last = first + numBins;
+    const auto h = getHeight();
+    for (auto row = 0; row < h; ++row)
+    {
+        const auto lowerEdge = toHzFromPx (static_cast<float> (row + 1));
+        const auto upperEdge = toHzFromPx (static_cast<float> (row));
+        auto begin = static_cast<int> (std::lower_bound (first, last, lowerEdge) - first);
+        auto end = static_cast<int> (std::lower_bound (first, last, upperEdge) - first);
+        if (begin == end)
+        {
+            // No bins fall within this row, so use the bin that is nearest to the centre of the row
+            const auto centre = toHzFromPx (static_cast<float> (row) + 0.5f);
+            if (begin > 0 && (begin == numBins || centre - first[begin - 1] < first[begin] - centre))
+                --begin;
+            end = begin + 1;
+        }
+        rowBinStart[row] = begin;
+        rowBinEnd[row] = end;
+    }
+}
+
+inline void Spectrogram::calculateColourMap()
+{
+    // Black through blue, magenta, red & yellow to white
+    const Colour steps[] = { Colours::black, Colour (0xff000080), Colour (0xff8000a0), Colours::red, Colours::yellow, Colours::white };
+    const auto numSegments = numElementsInArray (steps) - 1;
+    for (auto i = 0; i < colourMapSize; ++i)
+    {
+        const auto position = static_cast<float> (i * numSegments) / static_cast<float> (colourMapSize - 1);
+        const auto segment = jmin (numSegments - 1, static_cast<int> (position));
+        colourMap[i] = steps[segment].interpolatedWith (steps[segment + 1], position - static_cast<float> (segment)).getPixelARGB();
+    }
+}
+
+inline float Spectrogram::toPxFromHz (const float xInHz) const
+{
+    return static_cast<float> (getHeight()) * (1.0f - (log10 (xInHz) - minLogFreq) / logFreqSpan);
+}
+
+inline float Spectrogram::toHzFromPx (const float yInPixels) const
+{
+    return std::pow (10.0f, (1.0f - yInPixels / static_cast<float> (getHeight())) * logFreqSpan + minLogFreq);
+}
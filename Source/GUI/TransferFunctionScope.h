@@ -0,0 +1,323 @@
+/*
+  ==============================================================================
+
+    TransferFunctionScope.h
+    Created: 18 Oct 2026 1:35:19pm
+    Author:  Andrew
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "FftScope.h"
+#include "../Processing/TransferFunctionAnalyser.h"
+
+/**
+	Displays the measurements of a TransferFunctionAnalyser against a log frequency scale: the magnitude (against the dB scale on the
+	left), the phase (against the degrees scale on the right) & the coherence (from 0 at the bottom to 1 at the top). The magnitude &
+	phase are drawn dimmed where the coherence is low because the estimate isn't reliable there.
+
+	Each pixel column shows the bin nearest to its centre frequency. The mapping from columns to bins is recalculated on resize.
+*/
+class TransferFunctionScope final : public Component, public Timer
+{
+public:
+
+    TransferFunctionScope();
+    ~TransferFunctionScope() override;
+
+    void paint (Graphics& g) override;
+    void resized() override;
+    void timerCallback() override;
+
+    void assignTransferFunctionAnalyser (TransferFunctionAnalyser* analyserPtr);
+
+    // Must be called after TransferFunctionAnalyser:prepare() so that the AudioProbe listener can be set up properly
+    void prepare (const dsp::ProcessSpec& spec);
+
+    // Sets the text shown in the top left corner to identify what is being measured
+    void setDescription (const String& text);
+
+private:
+
+    /** Recalculates the bin shown in each pixel column. */
+    void calculateColumnBins();
+
+    /** Draws the grid & scales. */
+    void paintScale (Graphics& g) const;
+
+    inline float toPxFromHz (const float xInHz) const;
+    inline float toHzFromPx (const float xInPixels) const;
+    inline float toPxFromDb (const float dB) const;
+    inline float toPxFromRadians (const float radians) const;
+
+    static constexpr float dbMax = 24.0f;
+    static constexpr float dbMin = -24.0f;
+    static constexpr float coherenceThreshold = 0.5f; // Below this the magnitude & phase are drawn dimmed
+
+	TransferFunctionAnalyser* transferFunctionAnalyser = nullptr;
+    std::unique_ptr<TransferFunctionAnalyser::TransferFunctionFrame> frame{};
+    bool frameValid = false;
+    HeapBlock<int> columnBins;
+    String description;
+
+	double samplingFreq = 48000; // will be set correctly in prepare()
+    float minFreq = 10.0f;
+    float minLogFreq = 0.0f;
+    float logFreqSpan = 0.0f;
+
+    ListenerRemovalCallback removeListenerCallback = {};
+    WeakReference<TransferFunctionScope>::Master masterReference;
+    friend class WeakReference<TransferFunctionScope>;
+
+    Atomic<bool> dataFrameReady;
+
+    // Candidate frequencies for labelling the frequency axis
+    Array<float> gridFrequencies = { 20.0f, 50.0f, 125.0f, 250.0f, 500.0f, 1000.0f, 2000.0f, 4000.0f, 8000.0f, 16000.0f, 32000.0f, 64000.0f };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (TransferFunctionScope);
+};
+
+
+// ===========================================================================================
+// Implementation
+// ===========================================================================================
+
+inline TransferFunctionScope::TransferFunctionScope()
+{
+    this->setOpaque (true);
+    dataFrameReady.set (false);
+    startTimer (20);
+}
+
+inline TransferFunctionScope::~TransferFunctionScope()
+{
+    masterReference.clear();
+    // Remove listener callbacks so we don't leave anything hanging if we pop up a TransferFunctionScope then remove it
+    if (removeListenerCallback) removeListenerCallback();
+}
+
+inline void TransferFunctionScope::paint (Graphics& g)
+{
+    paintScale (g);
+    if (!frameValid || logFreqSpan <= 0.0f || getWidth() <= 0)
+        return;
+
+    const auto w = getWidth();
+    const auto magnitudeColour = Colours::green;
+    const auto phaseColour = Colours::cyan;
+    const auto coherenceColour = Colours::grey;
+
+    // Coherence is drawn first so the other traces sit on top of it
+    Path coherence;
+    coherence.preallocateSpace (w * 3);
+    const auto h = static_cast<float> (getHeight());
+    for (auto px = 0; px < w; ++px)
+    {
+        const auto y = h * (1.0f - frame->coherence[columnBins[px]]);
+        if (px == 0)
+            coherence.startNewSubPath (0.0f, y);
+        else
+            coherence.lineTo (static_cast<float> (px), y);
+    }
+    g.setColour (coherenceColour);
+    g.strokePath (coherence, PathStrokeType (1.0f));
+
+    // Magnitude & phase are split into reliable & unreliable paths (by coherence) & phase wraps are not joined up
+    Path magnitude[2];
+    Path phase[2];
+    auto previousReliable = -1;
+    auto previousPhase = 0.0f;
+    for (auto px = 0; px < w; ++px)
+    {
+        const auto bin = columnBins[px];
+        const auto reliable = frame->coherence[bin] >= coherenceThreshold ? 1 : 0;
+        const auto x = static_cast<float> (px);
+        const auto magY = toPxFromDb (Decibels::gainToDecibels (frame->magnitude[bin], dbMin - 1.0f));
+        const auto phaseY = toPxFromRadians (frame->phase[bin]);
+        const auto wrapped = std::abs (frame->phase[bin] - previousPhase) > MathConstants<float>::pi;
+        if (reliable != previousReliable)
+        {
+            // Join the new segment to the end of the previous one so the traces are continuous
+            if (px > 0)
+            {
+                magnitude[reliable].startNewSubPath (x - 1.0f, toPxFromDb (Decibels::gainToDecibels (frame->magnitude[columnBins[px - 1]], dbMin - 1.0f)));
+                magnitude[reliable].lineTo (x, magY);
+            }
+            else
+                magnitude[reliable].startNewSubPath (x, magY);
+            phase[reliable].startNewSubPath (x, phaseY);
+        }
+        else
+        {
+            magnitude[reliable].lineTo (x, magY);
+            if (wrapped)
+                phase[reliable].startNewSubPath (x, phaseY);
+            else
+                phase[reliable].lineTo (x, phaseY);
+        }
+        previousReliable = reliable;
+        previousPhase = frame->phase[bin];
+    }
+    const auto pst = PathStrokeType (1.0f);
+    g.setColour (phaseColour.withAlpha (0.3f));
+    g.strokePath (phase[0], pst);
+    g.setColour (phaseColour);
+    g.strokePath (phase[1], pst);
+    g.setColour (magnitudeColour.withAlpha (0.3f));
+    g.strokePath (magnitude[0], pst);
+    g.setColour (magnitudeColour);
+    g.strokePath (magnitude[1], PathStrokeType (1.5f));
+
+    // Legend
+    g.setFont (Font (GUI_SIZE_I(0.5)));
+    const auto lineHeight = GUI_SIZE_I(0.6);
+    auto textY = GUI_SIZE_I(0.1);
+    const auto textX = GUI_SIZE_I(1.2);
+    const auto textW = GUI_SIZE_I(8);
+    g.setColour (Colours::white);
+    g.drawText (description + " (" + String (frame->numFramesAveraged) + " averages)", textX, textY, textW, lineHeight, Justification::centredLeft, false);
+    textY += lineHeight;
+    g.setColour (magnitudeColour);
+    g.drawText ("Magnitude (dB)", textX, textY, textW, lineHeight, Justification::centredLeft, false);
+    textY += lineHeight;
+    g.setColour (phaseColour);
+    g.drawText ("Phase (degrees)", textX, textY, textW, lineHeight, Justification::centredLeft, false);
+    textY += lineHeight;
+    g.setColour (coherenceColour);
+    g.drawText ("Coherence", textX, textY, textW, lineHeight, Justification::centredLeft, false);
+}
+
+inline void TransferFunctionScope::resized()
+{
+    columnBins.allocate (static_cast<size_t> (jmax (1, getWidth())), true);
+    calculateColumnBins();
+}
+
+inline void TransferFunctionScope::timerCallback()
+{
+    // Only draw if a new measurement is ready (flag is set by a listener callback from the analysis thread)
+    if (dataFrameReady.get())
+    {
+        dataFrameReady.set (false);
+        if (!isShowing())
+            return;
+
+        frameValid = transferFunctionAnalyser->copyFrame (*frame);
+        repaint();
+    }
+}
+
+inline void TransferFunctionScope::assignTransferFunctionAnalyser (TransferFunctionAnalyser* analyserPtr)
+{
+    jassert (analyserPtr != nullptr);
+    transferFunctionAnalyser = analyserPtr;
+    frame = std::make_unique<TransferFunctionAnalyser::TransferFunctionFrame>();
+}
+
+inline void TransferFunctionScope::prepare (const dsp::ProcessSpec& spec)
+{
+    samplingFreq = spec.sampleRate;
+    minLogFreq = log10 (minFreq);
+    logFreqSpan = static_cast<float> (log10 (samplingFreq * 0.5)) - minLogFreq;
+    frameValid = false;
+    calculateColumnBins();
+    repaint();
+    WeakReference<TransferFunctionScope> weakThis = this;
+    removeListenerCallback = transferFunctionAnalyser->addListenerCallback ([this, weakThis]
+    {
+        // Check the WeakReference because the callback may live longer than this TransferFunctionScope
+        if (weakThis)
+            dataFrameReady.set (true);
+    });
+}
+
+inline void TransferFunctionScope::setDescription (const String& text)
+{
+    description = text;
+    frameValid = false;
+    repaint();
+}
+
+inline void TransferFunctionScope::calculateColumnBins()
+{
+    if (logFreqSpan <= 0.0f)
+        return;
+
+    const auto binsPerHz = static_cast<float> (TransferFunctionAnalyser::fftSize / samplingFreq);
+    for (auto px = 0; px < getWidth(); ++px)
+        columnBins[px] = jlimit (1, TransferFunctionAnalyser::numBins - 1, roundToInt (toHzFromPx (static_cast<float> (px) + 0.5f) * binsPerHz));
+}
+
+inline void TransferFunctionScope::paintScale (Graphics& g) const
+{
+    g.setColour (Colours::black);
+    g.fillRect (getLocalBounds());
+
+    const auto axisColour = Colours::darkgrey.darker();
+    const auto textColour = Colours::grey.darker();
+
+    g.setColour (axisColour);
+    g.drawRect (getLocalBounds().toFloat());
+    if (logFreqSpan <= 0.0f)
+        return;
+
+    g.setFont (Font (GUI_SIZE_I(0.4)));
+
+    // Plot dB scale on the left & phase scale on the right (the same gridlines serve both: 8 divisions of 6dB & 45 degrees)
+    const auto numTicks = 8;
+    const auto w = getWidth();
+    for (auto t = 1; t < numTicks; ++t)
+    {
+        const auto scaleY = static_cast<float> (getHeight()) / static_cast<float> (numTicks) * static_cast<float> (t);
+        g.setColour (axisColour);
+        g.drawHorizontalLine (static_cast<int> (scaleY), 0.0f, static_cast<float> (w));
+        g.setColour (textColour);
+        const auto dB = dbMax - (dbMax - dbMin) * static_cast<float> (t) / static_cast<float> (numTicks);
+        const auto degrees = 180 - 360 * t / numTicks;
+        const auto lblY = static_cast<int> (scaleY) + GUI_SIZE_I(0.1);
+        g.drawText (String (static_cast<int> (dB)), GUI_SIZE_I(0.1), lblY, GUI_SIZE_I(1.1), GUI_SIZE_I(0.5), Justification::topLeft, false);
+        g.drawText (String (degrees), w - GUI_SIZE_I(1.2), lblY, GUI_SIZE_I(1.1), GUI_SIZE_I(0.5), Justification::topRight, false);
+    }
+
+    // Plot frequency scale
+    auto nextThreshX = GUI_BASE_SIZE_I;
+    const auto h = static_cast<float> (getHeight());
+    const auto ty = getHeight() - GUI_SIZE_I(0.6);
+    for (auto f : gridFrequencies)
+    {
+        if (f < minFreq || f > samplingFreq * 0.5)
+            continue;
+        const auto scaleX = static_cast<int> (toPxFromHz (f));
+        // Only draw if we have enough separation
+        if (scaleX >= nextThreshX)
+        {
+            g.setColour (axisColour);
+            g.drawVerticalLine (scaleX, 0.0f, h);
+            g.setColour (textColour);
+            g.drawFittedText (FftScope::hertzToString (f, 0, false, false), scaleX + GUI_SIZE_I(0.1), ty, GUI_BASE_SIZE_I, GUI_SIZE_I(0.5), Justification::topLeft, 1, 1.0f);
+            nextThreshX = scaleX + GUI_BASE_SIZE_I;
+        }
+    }
+}
+
+inline float TransferFunctionScope::toPxFromHz (const float xInHz) const
+{
+    return static_cast<float> (getWidth()) * (log10 (xInHz) - minLogFreq) / logFreqSpan;
+}
+
+inline float TransferFunctionScope::toHzFromPx (const float xInPixels) const
+{
+    return std::pow (10.0f, xInPixels / static_cast<float> (getWidth()) * logFreqSpan + minLogFreq);
+}
+
+inline float TransferFunctionScope::toPxFromDb (const float dB) const
+{
+    return static_cast<float> (getHeight()) * (dbMax - jlimit (dbMin, dbMax, dB)) / (dbMax - dbMin);
+}
+
+inline float TransferFunctionScope::toPxFromRadians (const float radians) const
+{
+    return static_cast<float> (getHeight()) * (0.5f - radians / MathConstants<float>::twoPi);
+}
@@ -0,0 +1,326 @@
+/*
+  ==============================================================================
+
+    ZoomFftScope.h
+    Created: 18 Oct 2026 1:49:09pm
+    Author:  Andrew
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "FftScope.h"
+#include "../Processing/ZoomFftProcessor.h"
+
+/**
+	Displays the frames of a ZoomFftProcessor on a linear frequency axis, with controls for the centre frequency & the span along the
+	top. Double clicking on the plot moves the centre frequency to the frequency that was clicked.
+
+	Where bins are closer together than a pixel, each pixel column shows the loudest bin it spans (so narrow tones aren't lost).
+*/
+class ZoomFftScope final : public Component, public Timer
+{
+public:
+
+    ZoomFftScope();
+    ~ZoomFftScope() override;
+
+    void paint (Graphics& g) override;
+    void resized() override;
+    void mouseDoubleClick (const MouseEvent& event) override;
+    void timerCallback() override;
+
+    void assignZoomFftProcessor (ZoomFftProcessor* zoomFftProcessorPtr);
+
+    // Must be called after ZoomFftProcessor:prepare() so that the AudioProbe listener can be set up properly
+    void prepare (const dsp::ProcessSpec& spec);
+
+private:
+
+    /** Returns the area in which the spectrum is plotted. */
+    Rectangle<int> getPlotArea() const;
+
+    /** Updates the span options & the range of the centre frequency to suit the sample rate. */
+    void updateControls();
+
+    void updateStatus();
+
+    /** Formats a frequency for display, keeping the decimals below 1kHz (unlike FftScope::hertzToString, as the bins may be much
+     *  narrower than 1Hz). */
+    static String hertzToString (const double frequencyInHz, const int numDecimals);
+
+    static constexpr float dbMax = 0.0f;
+    static constexpr float dbMin = -140.0f;
+
+	ZoomFftProcessor* zoomFftProcessor = nullptr;
+    std::unique_ptr<ZoomFftProcessor::ZoomFrame> frame{};
+
+    Label lblCentre;
+    Slider sldCentre { Slider::IncDecButtons, Slider::TextBoxLeft };
+    ComboBox cmbSpan;
+    Label lblStatus;
+
+	double samplingFreq = 48000; // will be set correctly in prepare()
+
+    ListenerRemovalCallback removeListenerCallback = {};
+    WeakReference<ZoomFftScope>::Master masterReference;
+    friend class WeakReference<ZoomFftScope>;
+
+    Atomic<bool> dataFrameReady;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ZoomFftScope);
+};
+
+
+// ===========================================================================================
+// Implementation
+// ===========================================================================================
+
+inline ZoomFftScope::ZoomFftScope()
+{
+    this->setOpaque (true);
+    dataFrameReady.set (false);
+
+    lblCentre.setText ("Centre", dontSendNotification);
+    lblCentre.setJustificationType (Justification::centredRight);
+    lblCentre.setColour (Label::textColourId, Colours::white);
+    addAndMakeVisible (lblCentre);
+
+    sldCentre.setTooltip ("Frequency at the centre of the zoomed band (you can also double click on the plot to centre it on a frequency)");
+    sldCentre.setTextValueSuffix (" Hz");
+    sldCentre.setIncDecButtonsMode (Slider::incDecButtonsDraggable_Horizontal);
+    sldCentre.onValueChange = [this]
+    {
+        if (zoomFftProcessor != nullptr)
+            zoomFftProcessor->setCentreFrequency (sldCentre.getValue());
+        updateStatus();
+    };
+    addAndMakeVisible (sldCentre);
+
+    cmbSpan.setTooltip ("Span of the zoomed band. Narrower spans have finer resolution, but each frame takes longer to collect.");
+    cmbSpan.onChange = [this]
+    {
+        if (zoomFftProcessor != nullptr && cmbSpan.getSelectedId() > 0)
+            zoomFftProcessor->setZoomOrder (cmbSpan.getSelectedId());
+        updateStatus();
+        repaint();
+    };
+    addAndMakeVisible (cmbSpan);
+
+    lblStatus.setJustificationType (Justification::centredLeft);
+    lblStatus.setColour (Label::textColourId, Colours::white);
+    addAndMakeVisible (lblStatus);
+
+    startTimer (50);
+}
+
+inline ZoomFftScope::~ZoomFftScope()
+{
+    masterReference.clear();
+    // Remove listener callbacks so we don't leave anything hanging if we pop up a ZoomFftScope then remove it
+    if (removeListenerCallback) removeListenerCallback();
+}
+
+inline void ZoomFftScope::paint (Graphics& g)
+{
+    g.fillAll (Colours::black);
+
+    const auto area = getPlotArea();
+    const auto axisColour = Colours::darkgrey.darker();
+    const auto textColour = Colours::grey.darker();
+    g.setColour (axisColour);
+    g.drawRect (area);
+    if (zoomFftProcessor == nullptr || area.getWidth() <= 0)
+        return;
+
+    const auto toPxFromDb = [area] (const float dB)
+    {
+        return static_cast<float> (area.getY()) + static_cast<float> (area.getHeight()) * (dbMax - jlimit (dbMin, dbMax, dB)) / (dbMax - dbMin);
+    };
+
+    // Level grid (20dB steps)
+    g.setFont (Font (GUI_SIZE_I(0.4)));
+    for (auto dB = dbMax - 20.0f; dB > dbMin; dB -= 20.0f)
+    {
+        const auto y = static_cast<int> (toPxFromDb (dB));
+        g.setColour (axisColour);
+        g.drawHorizontalLine (y, static_cast<float> (area.getX()), static_cast<float> (area.getRight()));
+        g.setColour (textColour);
+        g.drawText (String (static_cast<int> (dB)), area.getX() + GUI_SIZE_I(0.1), y + GUI_SIZE_I(0.1), GUI_SIZE_I(1.1), GUI_SIZE_I(0.5), Justification::topLeft, false);
+    }
+
+    // Frequency grid in 1, 2, 5 steps, labelled relative to the centre frequency
+    const auto centre = sldCentre.getValue();
+    const auto span = ZoomFftProcessor::getSpan (zoomFftProcessor->getZoomOrder(), samplingFreq);
+    const auto hzPerPixel = span / static_cast<double> (area.getWidth());
+    const auto toPxFromHz = [area, centre, hzPerPixel] (const double hz)
+    {
+        return static_cast<float> (area.getCentreX()) + static_cast<float> ((hz - centre) / hzPerPixel);
+    };
+    const auto minStep = hzPerPixel * static_cast<double> (GUI_SIZE_I(2.5));
+    auto step = std::pow (10.0, std::floor (std::log10 (minStep)));
+    if (step * 2.0 >= minStep)
+        step *= 2.0;
+    else if (step * 5.0 >= minStep)
+        step *= 5.0;
+    else
+        step *= 10.0;
+    const auto stepDecimals = jmax (0, -static_cast<int> (std::floor (std::log10 (step))));
+    const auto numSteps = static_cast<int> (std::floor (span * 0.5 / step));
+    for (auto i = -numSteps; i <= numSteps; ++i)
+    {
+        const auto offset = static_cast<double> (i) * step;
+        const auto x = static_cast<int> (toPxFromHz (centre + offset));
+        g.setColour (i == 0 ? Colours::darkgrey : axisColour);
+        g.drawVerticalLine (x, static_cast<float> (area.getY()), static_cast<float> (area.getBottom()));
+        g.setColour (textColour);
+        const auto text = i == 0 ? hertzToString (centre, 2)
+                                 : (i > 0 ? "+" : "-") + hertzToString (std::abs (offset), stepDecimals);
+        g.drawText (text, x + GUI_SIZE_I(0.1), area.getBottom() - GUI_SIZE_I(0.6), GUI_SIZE_I(2.2), GUI_SIZE_I(0.5), Justification::topLeft, false);
+    }
+
+    // Plot each channel (using the loudest bin in each pixel column)
+    for (auto ch = 0; ch < zoomFftProcessor->getNumChannels(); ++ch)
+    {
+        if (!zoomFftProcessor->copyFrame (*frame, ch))
+            continue;
+
+        const auto firstBinHz = frame->centreFrequency - frame->binWidth * static_cast<double> (ZoomFftProcessor::numBins / 2);
+        const auto binsPerPixel = hzPerPixel / frame->binWidth;
+        const auto firstBin = ((centre - span * 0.5) - firstBinHz) / frame->binWidth;
+        Path p;
+        p.preallocateSpace (area.getWidth() * 3);
+        auto started = false;
+        for (auto px = 0; px < area.getWidth(); ++px)
+        {
+            const auto begin = jmax (0, roundToInt (firstBin + static_cast<double> (px) * binsPerPixel));
+            const auto end = jmin (ZoomFftProcessor::numBins, jmax (begin + 1, roundToInt (firstBin + static_cast<double> (px + 1) * binsPerPixel)));
+            if (begin >= end)
+            {
+                started = false;
+                continue;
+            }
+            const auto amplitude = FloatVectorOperations::findMaximum (frame->amplitude + begin, end - begin);
+            const auto x = static_cast<float> (area.getX() + px);
+            const auto y = toPxFromDb (Decibels::gainToDecibels (amplitude, dbMin - 1.0f));
+            if (started)
+                p.lineTo (x, y);
+            else
+                p.startNewSubPath (x, y);
+            started = true;
+        }
+        g.setColour (FftScope::getColourForChannel (ch));
+        g.strokePath (p, PathStrokeType (1.0f));
+    }
+}
+
+inline void ZoomFftScope::resized()
+{
+    auto bar = getLocalBounds().removeFromTop (GUI_BASE_SIZE_I).reduced (GUI_GAP_I(1));
+    lblCentre.setBounds (bar.removeFromLeft (GUI_SIZE_I(1.6)));
+    sldCentre.setBounds (bar.removeFromLeft (GUI_SIZE_I(4.5)));
+    bar.removeFromLeft (GUI_GAP_I(2));
+    cmbSpan.setBounds (bar.removeFromLeft (GUI_SIZE_I(3.5)));
+    lblStatus.setBounds (bar.withTrimmedLeft (GUI_GAP_I(2)));
+}
+
+inline void ZoomFftScope::mouseDoubleClick (const MouseEvent& event)
+{
+    const auto area = getPlotArea();
+    if (zoomFftProcessor == nullptr || !area.contains (event.getPosition()))
+        return;
+
+    const auto span = ZoomFftProcessor::getSpan (zoomFftProcessor->getZoomOrder(), samplingFreq);
+    const auto offset = static_cast<double> (event.x - area.getCentreX()) * span / static_cast<double> (area.getWidth());
+    sldCentre.setValue (sldCentre.getValue() + offset);
+}
+
+inline void ZoomFftScope::timerCallback()
+{
+    if (!isShowing() || zoomFftProcessor == nullptr)
+        return;
+
+    updateStatus();
+
+    // Only repaint if a new frame is ready (flag is set by a listener callback from the analysis thread)
+    if (dataFrameReady.get())
+    {
+        dataFrameReady.set (false);
+        repaint();
+    }
+}
+
+inline void ZoomFftScope::assignZoomFftProcessor (ZoomFftProcessor* zoomFftProcessorPtr)
+{
+    jassert (zoomFftProcessorPtr != nullptr);
+    zoomFftProcessor = zoomFftProcessorPtr;
+    frame = std::make_unique<ZoomFftProcessor::ZoomFrame>();
+    updateControls();
+}
+
+inline void ZoomFftScope::prepare (const dsp::ProcessSpec& spec)
+{
+    samplingFreq = spec.sampleRate;
+    updateControls();
+    updateStatus();
+    repaint();
+    WeakReference<ZoomFftScope> weakThis = this;
+    removeListenerCallback = zoomFftProcessor->addListenerCallback ([this, weakThis]
+    {
+        // Check the WeakReference because the callback may live longer than this ZoomFftScope
+        if (weakThis)
+            dataFrameReady.set (true);
+    });
+}
+
+inline Rectangle<int> ZoomFftScope::getPlotArea() const
+{
+    return getLocalBounds().withTrimmedTop (GUI_BASE_SIZE_I);
+}
+
+inline void ZoomFftScope::updateControls()
+{
+    if (zoomFftProcessor == nullptr)
+        return;
+
+    // Each span is listed with its resolution (the IDs are the zoom orders)
+    const auto zoomOrder = zoomFftProcessor->getZoomOrder();
+    cmbSpan.clear (dontSendNotification);
+    for (auto order = ZoomFftProcessor::minZoomOrder; order <= ZoomFftProcessor::maxZoomOrder; ++order)
+    {
+        const auto span = ZoomFftProcessor::getSpan (order, samplingFreq);
+        cmbSpan.addItem (hertzToString (span, 1) + " span", order);
+    }
+    cmbSpan.setSelectedId (zoomOrder, dontSendNotification);
+
+    // The centre can be anywhere from DC to Nyquist (half the span is shown either side of it, mirrored beyond DC & Nyquist)
+    const auto nyquist = samplingFreq * 0.5;
+    sldCentre.setRange (0.0, nyquist, 0.01);
+    sldCentre.setValue (jmin (zoomFftProcessor->getCentreFrequency(), nyquist), dontSendNotification);
+    sldCentre.setIncDecButtonsMode (Slider::incDecButtonsDraggable_Horizontal);
+    sldCentre.setNumDecimalPlacesToDisplay (2);
+    repaint();
+}
+
+inline void ZoomFftScope::updateStatus()
+{
+    if (zoomFftProcessor == nullptr)
+        return;
+
+    const auto zoomOrder = zoomFftProcessor->getZoomOrder();
+    const auto binWidth = samplingFreq / static_cast<double> (ZoomFftProcessor::fftSize << zoomOrder);
+    const auto frameSeconds = static_cast<double> (ZoomFftProcessor::fftSize << zoomOrder) / samplingFreq;
+    auto status = hertzToString (binWidth, 3) + " resolution, " + String (frameSeconds, 1) + " s frames";
+    const auto fill = zoomFftProcessor->getFillProportion();
+    if (fill < 1.0f)
+        status += " (collecting " + String (roundToInt (fill * 100.0f)) + "%)";
+    lblStatus.setText (status, dontSendNotification);
+}
+
+inline String ZoomFftScope::hertzToString (const double frequencyInHz, const int numDecimals)
+{
+    if (frequencyInHz < 1000.0)
+        return String (frequencyInHz, numDecimals) + " Hz";
+    return FftScope::hertzToString (frequencyInHz, jmax (2, numDecimals), true, true);
+}
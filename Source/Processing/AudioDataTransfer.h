@@ -11,7 +11,7 @@
 #pragma once
 
 #include "../JuceLibraryCode/JuceHeader.h"
-#include <list>
+#include <atomic>
 
 /*  
 	This file contains utility classes designed for data transfer applications involving real time audio.
@@ -22,14 +22,15 @@
 		- AudioProcessor makes latest data available for GUI (AudioProbe)
 			- GUI polls probe when it feels like
 			- GUI is notified when there has been a change
-		-	AudioProcessor streams all data to GUI (AudioProcessorStreamingProbe, not provided)
-			-	Can't see where this would be needed except something like AutoTune's graph - normally you'd process everything you need
-				in the AudioProcessor and let the GUI sample what it needs
-			-	Would require a separate queue for each observer
+		-	AudioProcessor streams all data to GUI or worker threads (AudioStreamingProbe)
+			-	Needed where every sample matters (e.g. recorders, exporters & analysis that mustn't miss anything) - otherwise
+				process everything you need in the AudioProcessor and let the GUI sample what it needs
+			-	Requires a separate queue for each consumer (so a slow consumer can't hold up the others)
 		- Trivial cases
 			- Atomic data types
-	-	AudioProcessor to Processing Thread
+	-	AudioProcessor to Processing Thread (FrameQueue)
 		-	Not recommended for plugins (you can miss the cache and the host will be trying to spread lots of plugins across cores anyhow)
+		-	Useful in a standalone app for moving expensive analysis (e.g. FFTs) off the audio thread
 	
 	Synchronous use cases:
 	---------------------
@@ -44,15 +45,152 @@
 	- Single writer is assumed (i.e. in AudioProcessor)
 	- Multiple observers/listeners assumed (need to be able to handle zero or more AudioProcessorEditors)
 	- Don't need to copy data in (as write index doesn't need to be advanced until ready)
+	- Readers must detect frames overwritten while they copy them (sequence numbers) & retry, as the writer must never wait for them
 	- Need to copy out data in blocks (don't allow pointers or references as this may result in data tearing if accessing routines iterate slowly)
+	- Listeners must be added & removed without locks or allocation while the writer calls them (ListenerRegistry)
     - Each observer needs it's own pre-allocated buffer to copy the data into (observer creates this itself so memory allocation not triggered on realtime thread)
 
 */
 
 
-/** These definitions improve readability for our lambda-based listener/callback implementation. */
-using ListenerCallback = std::function<void()>;
-using ListenerRemovalCallback = std::function<void()>;
+/** These definitions improve readability for our lambda-based listener/callback implementation. The callbacks are stored in place
+ *  (so adding a listener never allocates), which limits the size of a lambda's captures (a pointer & a WeakReference fit easily). */
+using ListenerCallback = dsp::FixedSizeFunction<32, void()>;
+using ListenerRemovalCallback = dsp::FixedSizeFunction<32, void()>;
+
+
+/**
+*   A fixed-capacity registry of listener callbacks which can be added & removed on one thread while they are called on another (i.e.
+*   the audio thread) without locks or allocation.
+*
+*   Each slot has an atomic state holding a generation count & a status. A slot is claimed by moving it from free to reserved, filled
+*   and then published as ready. The audio thread marks a ready slot as calling while it runs the callback, so a listener that is
+*   being removed waits (on the removing thread, never the audio thread) for the call to finish before its callback is destroyed.
+*   Removal is identified by slot & generation, so removing a listener twice or after its slot has been reused does nothing.
+*/
+class ListenerRegistry
+{
+public:
+
+    /** Maximum number of listeners that can be registered at once. */
+    static constexpr int capacity = 8;
+
+    /** Identifies a registered listener. */
+    struct Handle
+    {
+        int slot = -1;      // -1 if the listener couldn't be registered
+        uint32 generation = 0;
+    };
+
+    ListenerRegistry() = default;
+
+    /** Registers a callback (don't call this on the audio thread). Returns an invalid handle if the registry is full. */
+    Handle add (ListenerCallback&& callback)
+    {
+        for (auto slot = 0; slot < capacity; ++slot)
+        {
+            auto& slotState = states[slot];
+            auto expected = slotState.load (std::memory_order_relaxed);
+            if (getStatus (expected) != free)
+                continue;
+
+            const auto generation = getGeneration (expected) + 1;
+            if (slotState.compare_exchange_strong (expected, makeState (generation, reserved), std::memory_order_acquire))
+            {
+                callbacks[slot] = std::move (callback);
+                slotState.store (makeState (generation, ready), std::memory_order_release);
+                return { slot, generation };
+            }
+        }
+
+        // If this asserts then there are more listeners than the registry can hold
+        jassertfalse;
+        return {};
+    }
+
+    /** De-registers a callback (don't call this on the audio thread). If the callback is being called, this waits for it to return. */
+    void remove (const Handle handle)
+    {
+        if (handle.slot < 0 || handle.slot >= capacity)
+            return;
+
+        auto& slotState = states[handle.slot];
+        for (;;)
+        {
+            auto expected = makeState (handle.generation, ready);
+            if (slotState.compare_exchange_weak (expected, makeState (handle.generation, reserved), std::memory_order_acquire))
+                break;
+
+            // Nothing to do if the listener has already gone (the slot may even have been reused)
+            if (getGeneration (expected) != handle.generation || getStatus (expected) == free)
+                return;
+
+            // Wait for the audio thread to finish calling it
+            if (getStatus (expected) == calling)
+                Thread::yield();
+        }
+
+        callbacks[handle.slot] = nullptr;
+        slotState.store (makeState (handle.generation, free), std::memory_order_release);
+    }
+
+    /** Calls every registered callback (this is intended for the audio thread & never blocks). */
+    void callAll()
+    {
+        for (auto slot = 0; slot < capacity; ++slot)
+        {
+            auto& slotState = states[slot];
+            auto expected = slotState.load (std::memory_order_relaxed);
+            if (getStatus (expected) != ready)
+                continue;
+
+            const auto generation = getGeneration (expected);
+            if (slotState.compare_exchange_strong (expected, makeState (generation, calling), std::memory_order_acquire))
+            {
+                if (callbacks[slot])
+                    callbacks[slot]();
+                slotState.store (makeState (generation, ready), std::memory_order_release);
+            }
+        }
+    }
+
+    /** Returns true if any callbacks are registered. */
+    [[nodiscard]] bool isEmpty() const
+    {
+        for (auto& slotState : states)
+        {
+            const auto status = getStatus (slotState.load (std::memory_order_relaxed));
+            if (status == ready || status == calling)
+                return false;
+        }
+        return true;
+    }
+
+private:
+
+    /** The status of a slot is held in the bottom two bits of its state & the generation in the rest. */
+    enum Status : uint32
+    {
+        free = 0,
+        reserved,   // Being filled or emptied
+        ready,
+        calling     // Being called by the audio thread
+    };
+
+    static uint32 makeState (const uint32 generation, const Status status) { return (generation << 2) | status; }
+    static uint32 getGeneration (const uint32 state) { return state >> 2; }
+    static Status getStatus (const uint32 state) { return static_cast<Status> (state & 3); }
+
+    std::atomic<uint32> states[capacity] {};
+    ListenerCallback callbacks[capacity];
+
+public:
+    // Declare non-copyable, non-movable
+    ListenerRegistry (const ListenerRegistry&) = delete;
+    ListenerRegistry& operator= (const ListenerRegistry&) = delete;
+    ListenerRegistry (ListenerRegistry&& other) = delete;
+    ListenerRegistry& operator=(ListenerRegistry&& other) = delete;
+};
 
 
 /**
@@ -65,9 +203,14 @@ using ListenerRemovalCallback = std::function<void()>;
 *   suits them. There is no guarantee that all written frames will be read by an observer, they simply sample whatever is
 *   there at the time. Optionally, an observer can register as a listener so that it is notified whenever data has been written.
 *
-*   Data is written one frame at a time. It is also copied out one frame at a time by observers. The use of a copy method
-*   for reading minimises the risk of data tearing. Tearing can only occur if the write method overwrites the read
-*   position during the non-atomic copy operation. Hence the risk is a function of the queue length.
+*   Data is written one frame at a time. It is also copied out one frame at a time by observers. Each frame in the queue has a
+*   sequence number which the writer makes odd while it writes the frame, so an observer can tell if the frame it copied was
+*   overwritten during the copy (i.e. it's a seqlock). A torn copy is simply retried, so observers always get a complete frame
+*   whatever the frame size or number of observers - the length of the queue only affects how often retries are needed.
+*
+*   Observers can also lease the latest frame (see leaseFrame) to read it in place without copying it. A leased frame is pinned by a
+*   reference count & the writer skips over it to the next free frame, so it can't change while it's being read. If every frame
+*   other than the latest is leased then the new frame is dropped (the writer never waits), so keep leases short (e.g. for a paint).
 *  
 *   The FrameType used for the data frame must be of fixed size at compile time. For example:
 *  
@@ -75,23 +218,36 @@ using ListenerRemovalCallback = std::function<void()>;
 *	{
 *		alignas(16) float f[1024];
 *	};
+*
+*   If only the start of each frame is ever used (e.g. a header followed by the bins of the current FFT size in an array sized for the
+*   largest), then the probe can be given a smaller frame size so that it only allocates what's used (see the constructor).
 */
 template <class FrameType>
 class AudioProbe
 {
 public:
 
-    /* Constructor. Optionally specify the length of the queue. */
-	explicit AudioProbe(const int queueLengthInFrames = 3	/**< Number of frames in queue. Higher values have lower risk of data tearing. */)
-        : numFramesInQueue (queueLengthInFrames),
+    static constexpr int defaultQueueLength = 3;
+
+    /* Constructor. Optionally specify the length of the queue & the number of bytes of each frame that are used (frames are copied in
+     * & out as raw bytes, so a frame size smaller than the FrameType can be used if nothing beyond it is ever read or written). */
+	explicit AudioProbe(const int queueLengthInFrames = defaultQueueLength	/**< Number of frames in queue (at least 2). Higher values make read retries less likely. */,
+                        const size_t frameSizeInBytes = sizeof (FrameType))
+        : numFramesInQueue (jmax (2, queueLengthInFrames)),
         writeIndex (1),
         readIndex (0),
-        frameSize (sizeof (FrameType))
+        frameSize (static_cast<int> (jmin (frameSizeInBytes, sizeof (FrameType)))),
+        frameStride ((static_cast<size_t> (frameSize) + alignof (FrameType) - 1) / alignof (FrameType) * alignof (FrameType))
     {
-        // Allocate memory for queue
-		writeQueue.allocate (numFramesInQueue, false);
-        // Intialise frame at read position
-		writeQueue[readIndex] = FrameType ();
+        static_assert (std::is_trivially_copyable<FrameType>::value, "Frames are copied as raw bytes");
+        jassert (queueLengthInFrames >= 2);
+        jassert (frameSizeInBytes > 0 && frameSizeInBytes <= sizeof (FrameType));
+
+        // Allocate memory for queue & a sequence number for each frame (zeroed, so no frame is being written). The frames are zeroed
+        // in place, which initialises the frame at the read position without building a (possibly large) temporary.
+		writeQueue.allocate (frameStride * static_cast<size_t> (numFramesInQueue), true);
+        sequences.allocate (numFramesInQueue, true);
+        leaseCounts.allocate (numFramesInQueue, true);
     }
 
     /* 
@@ -104,26 +260,117 @@ public:
 	    masterReference.clear();
 	}
 
+    /** A read-only view of a leased frame, which the writer won't reuse until the lease is released (or destroyed). A lease must not
+     *  outlive the probe it came from. */
+    class ReadLease
+    {
+    public:
+        ReadLease() = default;
+        ReadLease (ReadLease&& other) noexcept
+            : probe (std::exchange (other.probe, nullptr)),
+              slot (other.slot)
+        { }
+        ReadLease& operator= (ReadLease&& other) noexcept
+        {
+            release();
+            probe = std::exchange (other.probe, nullptr);
+            slot = other.slot;
+            return *this;
+        }
+        ~ReadLease()
+        {
+            release();
+        }
+
+        /** Returns the leased frame (or nullptr if the lease is empty). */
+        [[nodiscard]] const FrameType* get() const noexcept
+        {
+            return probe != nullptr ? probe->getFrame (slot) : nullptr;
+        }
+
+        const FrameType* operator->() const noexcept { return get(); }
+        explicit operator bool() const noexcept { return probe != nullptr; }
+
+        /** Releases the frame back to the writer (the lease is empty afterwards). */
+        void release() noexcept
+        {
+            if (probe != nullptr)
+                probe->leaseCounts[slot].fetch_sub (1, std::memory_order_release);
+            probe = nullptr;
+        }
+
+    private:
+        friend class AudioProbe;
+        ReadLease (AudioProbe* leasedProbe, const int leasedSlot) noexcept
+            : probe (leasedProbe),
+              slot (leasedSlot)
+        { }
+
+        AudioProbe* probe = nullptr;
+        int slot = 0;
+
+        JUCE_DECLARE_NON_COPYABLE (ReadLease)
+    };
+
     /** Writes a data frame to the queue and will thus overwrite anything altered using getWritePointer(). */
     void writeFrame (const FrameType* source)
     {
-        jassert (writeIndex != readIndex);
-        std::memcpy (&writeQueue[writeIndex], source, frameSize);
+        if (!beginWrite())
+            return;
+        std::memcpy (getFrame (writeIndex), source, static_cast<size_t> (frameSize));
+        finishedWrite();
+    }
+
+    /** Writes the first numBytes of a data frame to the queue. This is useful if the FrameType has a variable amount of valid data
+     *  (e.g. a header specifying the length followed by a maximum sized array) as it avoids copying the unused portion. */
+    void writeFrame (const FrameType* source, const size_t numBytes)
+    {
+        jassert (numBytes <= static_cast<size_t> (frameSize));
+        if (!beginWrite())
+            return;
+        std::memcpy (getFrame (writeIndex), source, jmin (numBytes, static_cast<size_t> (frameSize)));
         finishedWrite();
     }
 
 	/** Copies current data frame at read index into the destination.
-	*	Direct access to the current data frame isn't allowed as any non atomic access risks data tearing. By using a lock-free queue
-	*	and copying out in one operation, the risk of data tearing is extremely low (an assertion will throw if this does happen).
-	*	Observers/listeners should pre-allocate a member variable of ElementType to copy into if performance is critical. */
+	*	Direct access to the current data frame isn't allowed as the writer may reuse it at any time. The copy is checked against the
+	*	frame's sequence number & is retried if the frame was overwritten during the copy, so the destination always holds a complete
+	*	frame. Observers/listeners should pre-allocate a member variable of ElementType to copy into if performance is critical. */
     void copyFrame (FrameType* destination)
     {
-        jassert (writeIndex != readIndex);
-        std::memcpy (destination, &writeQueue[readIndex], frameSize);
+        readConsistentFrame (destination, static_cast<size_t> (frameSize));
+    }
+
+    /** Copies the first numBytes of the current data frame at read index into the destination (see the equivalent writeFrame()). */
+    void copyFrame (FrameType* destination, const size_t numBytes)
+    {
+        jassert (numBytes <= static_cast<size_t> (frameSize));
+        readConsistentFrame (destination, jmin (numBytes, static_cast<size_t> (frameSize)));
+    }
+
+    /** Leases the current data frame so that it can be read in place (i.e. without a copy). The frame stays pinned until the lease is
+     *  released, so release it as soon as you've finished with it. The lease can't be empty & this never waits for the writer. */
+    ReadLease leaseFrame()
+    {
+        for (;;)
+        {
+            // Pin the latest frame, then check that the writer hadn't already started to reuse it (the writer marks the frame before
+            // checking its lease count, so either the writer sees the lease or we see the mark)
+            const auto index = readIndex.load (std::memory_order_acquire);
+            leaseCounts[index].fetch_add (1, std::memory_order_seq_cst);
+            if ((sequences[index].load (std::memory_order_seq_cst) & 1) == 0)
+            {
+                frameWasRead.store (true, std::memory_order_relaxed);
+                return ReadLease (this, index);
+            }
+            leaseCounts[index].fetch_sub (1, std::memory_order_release);
+            numReadRetries.fetch_add (1, std::memory_order_relaxed);
+        }
     }
 
 	/**
-	 *  Allows a listener to add a lambda function as a callback. This function is called on the audio thread so it should not
+	 *  Allows a listener to add a lambda function as a callback (at most ListenerRegistry::capacity per probe). Listeners can be added
+	 *  & removed while the audio thread is writing frames. The callback is called on the audio thread so it should not
 	 *  perform any allocations, acquire any locks or do anything else which might cause blocking. So either use an atomic flag as
 	 *  a semaphore or implement a lock-free function call queue for signalling back to other threads. The callback should also
 	 *  make sure that it's owner still exists before it attempts to do anything (e.g. check a WeakReference to itself).
@@ -134,12 +381,12 @@ public:
     ListenerRemovalCallback addListenerCallback (ListenerCallback &&listenerCallback)
     {
         WeakReference<AudioProbe<FrameType>> weakThis = this;
-        auto thisListener = listenerCallbacks.emplace (listenerCallbacks.begin(), listenerCallback);
-        return [this, weakThis, thisListener] ()
+        const auto handle = listeners.add (std::move (listenerCallback));
+        return [this, weakThis, handle] ()
         {
             // Check the WeakReference because the callback may live longer than this AudioProbe
             if (weakThis)
-                listenerCallbacks.erase (thisListener);
+                listeners.remove (handle);
         };
     }
 
@@ -151,33 +398,118 @@ public:
     */
     [[nodiscard]] inline bool hasListeners() const
 	{
-		return !listenerCallbacks.empty();
+		return !listeners.isEmpty();
 	}
 
+    /** Returns the number of times a copy had to be retried because the writer reused the frame while it was being copied (summed
+     *  over all observers). A steadily rising count means the queue is too short for how long the observers take to copy a frame. */
+    [[nodiscard]] uint32 getNumReadRetries() const
+    {
+        return numReadRetries.load (std::memory_order_relaxed);
+    }
+
+    /** Returns the number of frames that were replaced by a newer frame before any observer copied them (or that couldn't be written
+     *  because every other frame was leased). Observers that poll the probe will normally miss frames, but a listener that copies every
+     *  frame it's notified of shouldn't. */
+    [[nodiscard]] uint32 getNumDroppedFrames() const
+    {
+        return numDroppedFrames.load (std::memory_order_relaxed);
+    }
+
 private:
 
+    /** Returns the frame at the index in the queue. */
+    FrameType* getFrame (const int index) const noexcept
+    {
+        return reinterpret_cast<FrameType*> (writeQueue.getData() + frameStride * static_cast<size_t> (index));
+    }
+
+    /** This is called before the writer starts writing a data frame. It finds a frame which isn't the latest & isn't leased, & marks it
+     *  as being written with an odd sequence number. Returns false (counting a dropped frame) if every frame is in use. */
+    bool beginWrite()
+    {
+        const auto latest = readIndex.load (std::memory_order_relaxed);
+        for (auto attempt = 0; attempt < numFramesInQueue; ++attempt)
+        {
+            if (writeIndex != latest)
+            {
+                auto& sequence = sequences[writeIndex];
+                const auto sequenceBefore = sequence.load (std::memory_order_relaxed);
+                sequence.store (sequenceBefore + 1, std::memory_order_seq_cst);
+                if (leaseCounts[writeIndex].load (std::memory_order_seq_cst) == 0)
+                {
+                    // Make sure the odd sequence number is visible before any of the frame data is
+                    std::atomic_thread_fence (std::memory_order_release);
+                    return true;
+                }
+
+                // The frame is leased, so put its sequence number back (nothing has been written to it) & try the next one
+                sequence.store (sequenceBefore, std::memory_order_release);
+            }
+            if (++writeIndex == numFramesInQueue)
+                writeIndex = 0;
+        }
+
+        numDroppedFrames.fetch_add (1, std::memory_order_relaxed);
+        return false;
+    }
+
 	/** This is called when the writer has completed writing a data frame. */
     void finishedWrite()
     {
-        jassert (writeIndex != readIndex);
-        readIndex = writeIndex;
+        auto& sequence = sequences[writeIndex];
+        sequence.store (sequence.load (std::memory_order_relaxed) + 1, std::memory_order_release);
+
+        // The frame being replaced counts as dropped if nobody copied it
+        if (!frameWasRead.exchange (false, std::memory_order_relaxed))
+            numDroppedFrames.fetch_add (1, std::memory_order_relaxed);
+
+        readIndex.store (writeIndex, std::memory_order_release);
         writeIndex++;
         if (writeIndex == numFramesInQueue)
             writeIndex = 0;
         
         // Perform registered callbacks
-        for (auto &&callback : listenerCallbacks)
+        listeners.callAll();
+    }
+
+    /** Copies the latest frame, retrying until a copy is made which the writer didn't touch (i.e. a seqlock read). The writer never
+     *  waits for the readers, so readers can't hold up the audio thread however large the frame is or however many of them there are. */
+    void readConsistentFrame (FrameType* destination, const size_t numBytes)
+    {
+        for (;;)
         {
-            if (callback)
-                callback();
+            const auto index = readIndex.load (std::memory_order_acquire);
+            auto& sequence = sequences[index];
+            const auto sequenceBefore = sequence.load (std::memory_order_acquire);
+            if ((sequenceBefore & 1) == 0)
+            {
+                std::memcpy (destination, getFrame (index), numBytes);
+
+                // Make sure the copy is complete before the sequence number is checked again
+                std::atomic_thread_fence (std::memory_order_acquire);
+                if (sequence.load (std::memory_order_relaxed) == sequenceBefore)
+                {
+                    frameWasRead.store (true, std::memory_order_relaxed);
+                    return;
+                }
+            }
+            numReadRetries.fetch_add (1, std::memory_order_relaxed);
         }
     }
 
     const int numFramesInQueue; // In units of frame size
-    int writeIndex, readIndex;  // In units of frame size
-    int frameSize;              // In bytes
-    std::list<ListenerCallback> listenerCallbacks{};
-	HeapBlock <FrameType> writeQueue;
+    int writeIndex;             // In units of frame size (only used by the writer, which skips leased frames)
+    std::atomic<int> readIndex; // In units of frame size (the latest complete frame)
+    int frameSize;              // In bytes (the number of bytes of each frame that are used)
+    size_t frameStride;         // In bytes (the frame size rounded up to the alignment of the FrameType)
+    ListenerRegistry listeners;
+	HeapBlock <char> writeQueue;
+    HeapBlock <std::atomic<uint32>> sequences;  // One per frame, odd while the frame is being written
+    HeapBlock <std::atomic<int>> leaseCounts;   // One per frame, the number of leases pinning the frame
+    std::atomic<bool> frameWasRead { true };    // The initial frame isn't counted as dropped
+    std::atomic<uint32> numReadRetries { 0 };
+    std::atomic<uint32> numDroppedFrames { 0 };
 
     typename WeakReference<AudioProbe<FrameType>>::Master masterReference;
     friend class WeakReference<AudioProbe<FrameType>>;
@@ -194,7 +526,14 @@ public:
 *	This abstract class is used to provide the capability to stream data to elsewhere in a real time audio process at
 *   a fixed block size which is independent of the block size of the source stream. Derivations need to implement the
 *	performProcessing() method. It is assumed that processing will take place on the same thread as AudioProcessor::processBlock(),
-*	there is no consideration given to thread safety.
+*	there is no consideration given to thread safety (other than for requestCurrentBlockSize() and setHopSize()).
+*
+*   By default, blocks don't overlap (i.e. the hop size is equal to the block size). If a smaller hop size is set, then
+*   performProcessing() is called every time another hop's worth of data has arrived. Incoming data is written to an internal ring
+*   of twice the maximum block size, so the most recent block is always contiguous & derivations read it in place (oldest sample
+*   first, see getBlockReadPointer()). When blocks don't overlap & the incoming data lines up with the fixed block size, the block
+*   is processed straight from the incoming data without being copied at all. Use appendBlock() to keep the channels in lockstep
+*   so that they can all be processed in one call (see performMultichannelProcessing()). All memory is allocated in prepare().
 *	 
 *	Note that this class only operates on float based audio data.
 */
@@ -205,7 +544,9 @@ public:
     /** We set a maximum block size at construction but allow later modification to a smaller size if necessary. */
     explicit FixedBlockProcessor (const int maximumBlockSize)
         : maxBlockSize (maximumBlockSize),
-          currentBlockSize (maximumBlockSize)
+          currentBlockSize (maximumBlockSize),
+          requestedBlockSize (maximumBlockSize),
+          hopSize (maximumBlockSize)
     { }
 
 	virtual ~FixedBlockProcessor() = default;
@@ -228,15 +569,27 @@ public:
 	/** Sets the current block size used. Current size is initialised to maximum size. If you set a smaller size,
 	 *  then performProcessing() will be called when the smaller, current block size is reached. If the size is reduced
 	 *  while there is already data in the buffer, then that data will be cleared and will not be processed.
+	 *  This must be called on the same thread as appendData() - use requestCurrentBlockSize() from other threads.
 	 */
     void modifyCurrentBlockSize (const int size		/**< This block size must be <= to the maximum, larger values will be truncated to max. */)
     {
         jassert (size > 0);
         jassert (size <= maxBlockSize);
         currentBlockSize = jmin (size, maxBlockSize);
+        requestedBlockSize.set (currentBlockSize);
         resetFrame();
     }
 
+    /** Requests a change to the current block size from another thread. The change is applied by the next call to appendData(), so
+     *  it always takes place at a block boundary (any partially filled block is discarded, as per modifyCurrentBlockSize()).
+     */
+    void requestCurrentBlockSize (const int size		/**< This block size must be <= to the maximum, larger values will be truncated to max. */)
+    {
+        jassert (size > 0);
+        jassert (size <= maxBlockSize);
+        requestedBlockSize.set (jlimit (1, maxBlockSize, size));
+    }
+
 	/** Gets the maximum block size. */
     [[nodiscard]] int getMaximumBlockSize() const
     {
@@ -249,11 +602,77 @@ public:
         return currentBlockSize;
     }
 
+    /** Sets the number of samples between the start of successive blocks (i.e. blocks overlap by the block size less the hop size).
+     *  This may be called from another thread, the new hop size is picked up by the next call to appendData(). If the hop size is
+     *  larger than the current block size, then the current block size is used as the hop size.
+     */
+    void setHopSize (const int size     /**< This hop size must be > 0 and <= the maximum block size, other values will be truncated. */)
+    {
+        jassert (size > 0);
+        jassert (size <= maxBlockSize);
+        hopSize.set (jlimit (1, maxBlockSize, size));
+    }
+
+    /** Gets the hop size (limited to the current block size). */
+    [[nodiscard]] int getHopSize() const
+    {
+        return jmin (hopSize.get(), currentBlockSize);
+    }
+
+    /** Sets which channels are processed, where bit n enables channel n (so only the first 64 channels can be enabled). Data appended
+     *  to a disabled channel is discarded without being copied, so a high channel count costs little when only a few channels are
+     *  needed. A channel that is re-enabled starts afresh. This may be called from another thread. */
+    void setChannelMask (const uint64 mask)
+    {
+        channelMask.set (mask);
+    }
+
+    /** Gets the mask of enabled channels. */
+    [[nodiscard]] uint64 getChannelMask() const
+    {
+        return channelMask.get();
+    }
+
+    /** Returns true if data appended to the channel is processed. */
+    [[nodiscard]] bool isChannelEnabled (const int channel) const
+    {
+        return channel >= 0 && channel < 64 && (getEnabledChannels() & (uint64 (1) << channel)) != 0;
+    }
+
+    /** Returns the number of enabled channels. */
+    [[nodiscard]] int getNumEnabledChannels() const
+    {
+        return countNumberOfBits (getEnabledChannels());
+    }
+
+    /** Returns the first enabled channel (or -1 if none are enabled). */
+    [[nodiscard]] int getFirstEnabledChannel() const
+    {
+        const auto enabled = getEnabledChannels();
+        return enabled == 0 ? -1 : countNumberOfBits ((enabled & (~enabled + 1)) - 1);
+    }
+
+    /** Returns the last enabled channel (or -1 if none are enabled). Channels are processed in order, so a frame for this channel marks
+     *  the end of a block of frames. */
+    [[nodiscard]] int getLastEnabledChannel() const
+    {
+        const auto enabled = getEnabledChannels();
+        if (enabled == 0)
+            return -1;
+        const auto high = static_cast<uint32> (enabled >> 32);
+        return high != 0 ? 32 + findHighestSetBit (high) : findHighestSetBit (static_cast<uint32> (enabled));
+    }
+
     /** Resets the current write to the start of the frame (for each channel). */
     void resetFrame()
     {
         for (auto ch = 0 ; ch < numChannels; ++ch)
+        {
             currentIndex[ch] = 0;
+            samplesSinceLastBlock[ch] = 0;
+            samplesInRing[ch] = 0;
+            blockPointers[ch] = nullptr;
+        }
     }
 
 	/** Appends data to the buffer. */
@@ -267,70 +686,207 @@ public:
         jassert (channel >= 0 && channel < numChannels);
         jassert (numSamples > 0);   // If this assert fires then you probably haven't called prepare()
 
+        if (requestedBlockSize.get() != currentBlockSize)
+            modifyCurrentBlockSize (requestedBlockSize.get());
+
+        if (!isChannelEnabled (channel))
+        {
+            // Forget the channel's partial block so that it starts afresh if it's re-enabled
+            currentIndex[channel] = 0;
+            samplesSinceLastBlock[channel] = 0;
+            samplesInRing[channel] = 0;
+            return;
+        }
+
         if (data != nullptr)
         {
-            if (currentIndex[channel] + numSamples < currentBlockSize)
-            {
-                // Data can't fill the channel buffer, so write what we have
-                buffer.copyFrom (channel, currentIndex[channel], data, numSamples);
-                currentIndex[channel] += numSamples;
-            }
-            else
+            const auto hop = getHopSize();
+            auto dataOffset = 0;
+
+            // If the hop size has been reduced, then treat the next sample as the end of a hop
+            samplesSinceLastBlock[channel] = jmin (samplesSinceLastBlock[channel], hop - 1);
+
+            while (dataOffset < numSamples)
             {
-                // We have more data than can fit in the channel buffer
-                auto samplesRemaining = numSamples;
-                auto dataOffset = 0;
-
-                // Write remainder of channel buffer and process
-                const auto rem = currentBlockSize - currentIndex[channel];
-                buffer.copyFrom (channel, currentIndex[channel], data, rem);
-                performProcessing (channel);
-                currentIndex[channel] = 0;
-                samplesRemaining -= rem;
-                dataOffset += rem;
-
-                // Loop full blocks (processing as we go)
-                while (samplesRemaining >= currentBlockSize)
+                // Whole blocks that line up with the start of a non-overlapping block are processed in place
+                if (canProcessInPlace (channel, numSamples - dataOffset, hop))
                 {
-                    buffer.copyFrom (channel, currentIndex[channel], data + dataOffset, currentBlockSize);
+                    processInPlace (channel, data + dataOffset);
                     performProcessing (channel);
-                    samplesRemaining -= currentBlockSize;
                     dataOffset += currentBlockSize;
+                    continue;
                 }
 
-                if (samplesRemaining > 0)
-                {
-                    // Write remainder of input
-                    buffer.copyFrom (channel, currentIndex[channel], data + dataOffset, samplesRemaining);
-                    currentIndex[channel] = samplesRemaining;
-                }
+                // Otherwise write up to the end of the hop
+                const auto n = jmin (numSamples - dataOffset, hop - samplesSinceLastBlock[channel]);
+                if (writeToRing (channel, data + dataOffset, n, hop))
+                    performProcessing (channel);
+                dataOffset += n;
             }
         }
     }
 
+    /** Appends a block of every channel (which must have the number of channels given to prepare()). The channels are kept in lockstep, so
+     *  all the enabled channels complete their blocks together & are processed by one call to performMultichannelProcessing(). Don't mix
+     *  this with appendData() on the same processor (as appendData() lets the channels drift apart). */
+    void appendBlock (const dsp::AudioBlock<const float>& block)
+    {
+        jassert (numChannels > 0);  // If this assert fires then you probably haven't called prepare()
+        jassert (static_cast<int> (block.getNumChannels()) == numChannels);
+
+        if (requestedBlockSize.get() != currentBlockSize)
+            modifyCurrentBlockSize (requestedBlockSize.get());
+
+        const auto numSamples = static_cast<int> (block.getNumSamples());
+        const auto numBlockChannels = jmin (numChannels, static_cast<int> (block.getNumChannels()));
+        const auto hop = getHopSize();
+        auto dataOffset = 0;
+
+        // The channels are in lockstep, so the position in the hop is the same for every channel
+        for (auto ch = 0; ch < numChannels; ++ch)
+            samplesSinceLastBlock[ch] = jmin (samplesSinceLastBlock[ch], hop - 1);
+
+        while (dataOffset < numSamples)
+        {
+            const auto remaining = numSamples - dataOffset;
+            if (canProcessInPlace (0, remaining, hop))
+            {
+                for (auto ch = 0; ch < numChannels; ++ch)
+                    processInPlace (ch, ch < numBlockChannels && isChannelEnabled (ch) ? block.getChannelPointer (static_cast<size_t> (ch)) + dataOffset : nullptr);
+                performMultichannelProcessing();
+                dataOffset += currentBlockSize;
+                continue;
+            }
+
+            // Disabled channels are kept in step without copying anything (so they have nothing to process)
+            const auto n = jmin (remaining, hop - samplesSinceLastBlock[0]);
+            auto anyBlockReady = false;
+            for (auto ch = 0; ch < numChannels; ++ch)
+            {
+                const auto* data = ch < numBlockChannels && isChannelEnabled (ch) ? block.getChannelPointer (static_cast<size_t> (ch)) + dataOffset : nullptr;
+                anyBlockReady = writeToRing (ch, data, n, hop) || anyBlockReady;
+            }
+            if (anyBlockReady)
+                performMultichannelProcessing();
+            dataOffset += n;
+        }
+    }
+
 	/** Abstract function which is called whenever the fixed size buffer has been filled. */
 	virtual void performProcessing (const int channel	/**< Channel for which processing is to be performed */ ) = 0;
+
+    /** Called by appendBlock() when the channels complete a block together. By default, this calls performProcessing() for each channel
+     *  that has a block (in channel order), but derivations can override it to process all the channels at once. */
+    virtual void performMultichannelProcessing()
+    {
+        for (auto ch = 0; ch < numChannels; ++ch)
+            if (blockPointers[ch] != nullptr)
+                performProcessing (ch);
+    }
    
 protected:
 
-	/** Internal buffer */
-	AudioSampleBuffer buffer;
+    /** Returns the most recent block for the channel (oldest sample first & getCurrentBlockSize() samples long). Only call this from
+     *  performProcessing() or performMultichannelProcessing() - the block may be the caller's own data, processed in place, in which
+     *  case it is only valid until appendData() or appendBlock() returns. Returns nullptr if the channel has no block. */
+    [[nodiscard]] const float* getBlockReadPointer (const int channel) const
+    {
+        jassert (channel >= 0 && channel < numChannels);
+        return blockPointers[channel];
+    }
 
-	/** Used to hold current position in buffer (per channel) */
+	/** Used to hold current write position in the ring (per channel) */
     HeapBlock<int> currentIndex { };
 
 private:
 
-	/** Resizes buffer - this always allocates sufficient memory to hold the maximum block size. */
+	/** Resizes buffers - this always allocates sufficient memory to hold the maximum block size. */
     void resizeBuffer()
     {
-        buffer.setSize (numChannels, maxBlockSize, false, true, true);
+        ring.setSize (numChannels, ringSize(), false, true, true);
         currentIndex.allocate (numChannels, true);
+        samplesSinceLastBlock.allocate (numChannels, true);
+        samplesInRing.allocate (numChannels, true);
+        blockPointers.allocate (numChannels, true);
+    }
+
+    /** The ring is twice the maximum block size, so the most recent block is always contiguous & the samples still needed only have
+     *  to be moved back to the start once the end is reached (i.e. at most once per block, however much the blocks overlap). */
+    int ringSize() const
+    {
+        return 2 * maxBlockSize;
+    }
+
+    /** Returns the channel mask limited to the channels that exist. */
+    uint64 getEnabledChannels() const
+    {
+        return numChannels >= 64 ? channelMask.get() : channelMask.get() & ((uint64 (1) << numChannels) - 1);
+    }
+
+    /** Returns true if the next block can be processed straight from the source data, which is the case when blocks don't overlap, the
+     *  channel is at the start of a block & there is at least a whole block of data left. */
+    bool canProcessInPlace (const int channel, const int numSamplesRemaining, const int hop) const
+    {
+        return hop == currentBlockSize && samplesSinceLastBlock[channel] == 0 && numSamplesRemaining >= currentBlockSize;
+    }
+
+    /** Uses a whole block of source data in place of the ring (or marks the channel as having no block if data is nullptr). Nothing
+     *  from before this block is needed for later blocks, so the ring is emptied. */
+    void processInPlace (const int channel, const float* data)
+    {
+        currentIndex[channel] = 0;
+        samplesInRing[channel] = 0;
+        blockPointers[channel] = data;
+    }
+
+    /** Writes up to the end of the hop into the channel's ring (or just advances the position if data is nullptr, in which case the
+     *  channel has nothing to process). Returns true if a new block is ready for the channel. */
+    bool writeToRing (const int channel, const float* data, const int numSamples, const int hop)
+    {
+        jassert (samplesSinceLastBlock[channel] + numSamples <= hop);
+        auto* ringData = ring.getWritePointer (channel);
+
+        // Move the samples which will be part of the next block back to the start if there isn't room for the rest of the hop
+        if (currentIndex[channel] + numSamples > ringSize())
+        {
+            const auto numToKeep = jmin (samplesInRing[channel], jmax (0, currentBlockSize - (hop - samplesSinceLastBlock[channel])));
+            FloatVectorOperations::copy (ringData, ringData + currentIndex[channel] - numToKeep, numToKeep);
+            currentIndex[channel] = numToKeep;
+            samplesInRing[channel] = numToKeep;
+        }
+
+        if (data != nullptr)
+        {
+            FloatVectorOperations::copy (ringData + currentIndex[channel], data, numSamples);
+            samplesInRing[channel] = jmin (samplesInRing[channel] + numSamples, currentBlockSize);
+        }
+        else
+        {
+            samplesInRing[channel] = 0;
+        }
+        currentIndex[channel] += numSamples;
+        samplesSinceLastBlock[channel] += numSamples;
+
+        if (samplesSinceLastBlock[channel] < hop)
+            return false;
+
+        // Only process once we have a full block
+        samplesSinceLastBlock[channel] = 0;
+        const auto blockReady = samplesInRing[channel] == currentBlockSize;
+        blockPointers[channel] = blockReady ? ringData + currentIndex[channel] - currentBlockSize : nullptr;
+        return blockReady;
     }
 
 	int numChannels = 0;
     int maxBlockSize = 0;
 	int currentBlockSize = 0;
+    Atomic<int> requestedBlockSize;
+    Atomic<int> hopSize;
+    Atomic<uint64> channelMask { ~uint64 (0) };
+    AudioSampleBuffer ring;
+    HeapBlock<int> samplesSinceLastBlock { };
+    HeapBlock<int> samplesInRing { };
+    HeapBlock<const float*> blockPointers { };  // The most recent block of each channel (in the ring or the source data)
 
 public:
     // Declare non-copyable, non-movable
@@ -338,4 +894,335 @@ public:
     FixedBlockProcessor& operator= (const FixedBlockProcessor&) = delete;
     FixedBlockProcessor (FixedBlockProcessor&& other) = delete;
     FixedBlockProcessor& operator=(FixedBlockProcessor&& other) = delete;
+};
+
+/**
+*   A lock-free, single producer / single consumer queue of frames of float data. This is designed to pass frames of audio from the audio
+*   thread to a worker thread (e.g. so that expensive analysis doesn't cause spikes in the audio callback). Each frame is tagged with an
+*   integer (e.g. the channel number) so that a single queue can be shared by several channels, & can carry the hop size it was
+*   produced with (so the consumer doesn't read settings that the producer may be changing). Frames can be of any length up to the
+*   maximum frame size (only the samples in use are copied).
+*
+*   All memory is allocated in prepare(). If the consumer falls behind and the queue is full, then push() drops the frame rather than
+*   blocking the producer (the number of dropped frames is counted).
+*
+*   The producer doesn't wake the consumer (signalling a WaitableEvent takes a lock, which mustn't happen on the audio thread), so the
+*   consumer polls the queue. It should wait for getConsumerPollInterval() between polls, which backs off while no frames arrive (e.g.
+*   while the analysis is switched off) so that idle consumers hardly ever wake.
+*/
+class FrameQueue
+{
+public:
+
+    /** How often a busy consumer thread should poll the queue (short enough that a queue of a few frames per channel doesn't fill between polls). */
+    static constexpr int consumerPollIntervalMs = 2;
+
+    /** How often an idle consumer thread should poll the queue (the first frame after a pause may wait this long). */
+    static constexpr int idleConsumerPollIntervalMs = 100;
+
+    /** How long the queue must have been empty before the consumer counts as idle. */
+    static constexpr int consumerIdleTimeoutMs = 250;
+
+    /** Returns how long a consumer should wait before polling again, given the time the last frame was popped (in the units of
+     *  Time::getMillisecondCounter). */
+    static int getConsumerPollInterval (const uint32 lastFrameTimeMs)
+    {
+        return Time::getMillisecondCounter() - lastFrameTimeMs < static_cast<uint32> (consumerIdleTimeoutMs) ? consumerPollIntervalMs
+                                                                                                             : idleConsumerPollIntervalMs;
+    }
+
+    FrameQueue() = default;
+    ~FrameQueue() = default;
+
+    /** Allocates the queue. This must not be called while either the producer or consumer is active. */
+    void prepare (const int maximumFrameSizeInSamples, const int capacityInFrames)
+    {
+        jassert (maximumFrameSizeInSamples > 0);
+        jassert (capacityInFrames > 0);
+        maxFrameSize = maximumFrameSizeInSamples;
+        fifo.setTotalSize (capacityInFrames + 1); // AbstractFifo always keeps one slot free
+        frames.allocate (static_cast<size_t> (fifo.getTotalSize() * maxFrameSize), true);
+        tags.allocate (static_cast<size_t> (fifo.getTotalSize()), true);
+        hopSizes.allocate (static_cast<size_t> (fifo.getTotalSize()), true);
+        lengths.allocate (static_cast<size_t> (fifo.getTotalSize()), true);
+        reset();
+    }
+
+    /** Clears the queue. This must not be called while either the producer or consumer is active. */
+    void reset()
+    {
+        fifo.reset();
+        droppedFrames.set (0);
+    }
+
+    /** Copies a frame into the queue (called by the producer). Returns false if the queue was full, in which case the frame is dropped. */
+    bool push (const float* frame, const int numSamples, const int tag, const int hopSize = 0)
+    {
+        jassert (numSamples > 0 && numSamples <= maxFrameSize);
+
+        int start1, size1, start2, size2;
+        fifo.prepareToWrite (1, start1, size1, start2, size2);
+        if (size1 == 0)
+        {
+            droppedFrames.set (droppedFrames.get() + 1);
+            return false;
+        }
+        lengths[start1] = jmin (numSamples, maxFrameSize);
+        FloatVectorOperations::copy (frames.getData() + start1 * maxFrameSize, frame, lengths[start1]);
+        tags[start1] = tag;
+        hopSizes[start1] = hopSize;
+        fifo.finishedWrite (1);
+        return true;
+    }
+
+    /** Copies the oldest frame out of the queue (called by the consumer). The destination must be able to hold the maximum frame size.
+     *  Returns false if the queue was empty. */
+    bool pop (float* destination, int& numSamples, int& tag)
+    {
+        int hopSize = 0;
+        return pop (destination, numSamples, tag, hopSize);
+    }
+
+    /** As above, but also gets the hop size that the frame was pushed with. */
+    bool pop (float* destination, int& numSamples, int& tag, int& hopSize)
+    {
+        int start1, size1, start2, size2;
+        fifo.prepareToRead (1, start1, size1, start2, size2);
+        if (size1 == 0)
+            return false;
+        numSamples = lengths[start1];
+        FloatVectorOperations::copy (destination, frames.getData() + start1 * maxFrameSize, numSamples);
+        tag = tags[start1];
+        hopSize = hopSizes[start1];
+        fifo.finishedRead (1);
+        return true;
+    }
+
+    /** Gets the number of frames that have been dropped since the queue was last reset. */
+    [[nodiscard]] int getNumDroppedFrames() const
+    {
+        return droppedFrames.get();
+    }
+
+private:
+
+    AbstractFifo fifo { 1 };
+    HeapBlock<float> frames { };
+    HeapBlock<int> tags { };
+    HeapBlock<int> hopSizes { };
+    HeapBlock<int> lengths { };
+    int maxFrameSize = 0;
+    Atomic<int> droppedFrames = 0;
+
+public:
+    // Declare non-copyable, non-movable
+    FrameQueue (const FrameQueue&) = delete;
+    FrameQueue& operator= (const FrameQueue&) = delete;
+    FrameQueue (FrameQueue&& other) = delete;
+    FrameQueue& operator=(FrameQueue&& other) = delete;
+};
+
+/**
+*   A lossless, multi-consumer stream of multi-channel audio from the audio thread. Unlike AudioProbe (where observers sample whatever
+*   frame happens to be there), every sample written is delivered to every consumer. Each consumer has its own single producer / single
+*   consumer ring & read cursor, so consumers read at their own pace in blocks of whatever size suits them (e.g. a recorder writing to
+*   disk or an analysis worker) & a slow consumer doesn't affect the others.
+*
+*   All memory is allocated in prepare() (for up to maxNumConsumers consumers). Consumers are added & removed on other threads while
+*   the audio thread is writing, using the same slot states as ListenerRegistry. If a consumer falls behind and its ring can't hold
+*   a whole block, then the block is skipped for that consumer (so channels stay aligned) & the lost samples are counted. Listeners
+*   can be notified after each block is written (e.g. to flag new data for the GUI), but they must not take locks (so they mustn't
+*   wake a worker thread) - worker threads should poll getNumReady instead.
+*/
+class AudioStreamingProbe
+{
+public:
+
+    AudioStreamingProbe() = default;
+
+    ~AudioStreamingProbe()
+    {
+        masterReference.clear();
+    }
+
+    /** Allocates a ring of capacityInSamples for each possible consumer. This must not be called while the stream is being written or
+     *  read, & any existing consumers are removed. */
+    void prepare (const int numChannelsToStream, const int capacityInSamples, const int maxNumConsumers = 4)
+    {
+        jassert (numChannelsToStream > 0);
+        jassert (capacityInSamples > 0);
+        jassert (maxNumConsumers > 0);
+        numChannels = numChannelsToStream;
+        consumers.clear();
+        for (auto i = 0; i < maxNumConsumers; ++i)
+        {
+            auto* consumer = consumers.add (new Consumer());
+            consumer->fifo.setTotalSize (capacityInSamples + 1); // AbstractFifo always keeps one slot free
+            consumer->ring.setSize (numChannels, consumer->fifo.getTotalSize());
+        }
+    }
+
+    /** Gets the number of channels streamed. */
+    [[nodiscard]] int getNumChannels() const
+    {
+        return numChannels;
+    }
+
+    /** Adds a consumer (don't call this on the audio thread). Returns the consumer's ID, or -1 if there are no free slots. The consumer
+     *  receives every sample written from now on. */
+    int addConsumer()
+    {
+        for (auto id = 0; id < consumers.size(); ++id)
+        {
+            auto& state = consumers[id]->state;
+            auto expected = static_cast<uint32> (free);
+            if (state.compare_exchange_strong (expected, reserved, std::memory_order_acquire))
+            {
+                // The audio thread doesn't touch a reserved slot, so the ring can be reset
+                consumers[id]->fifo.reset();
+                consumers[id]->lostSamples.set (0);
+                state.store (active, std::memory_order_release);
+                return id;
+            }
+        }
+
+        // If this asserts then there are more consumers than were allowed for in prepare()
+        jassertfalse;
+        return -1;
+    }
+
+    /** Removes a consumer (don't call this on the audio thread). If a block is being written to the consumer, this waits for it to finish. */
+    void removeConsumer (const int consumerId)
+    {
+        if (!isPositiveAndBelow (consumerId, consumers.size()))
+            return;
+
+        auto& state = consumers[consumerId]->state;
+        for (;;)
+        {
+            auto expected = static_cast<uint32> (active);
+            if (state.compare_exchange_weak (expected, free, std::memory_order_acq_rel))
+                return;
+            if (expected == free)
+                return;
+
+            // Wait for the audio thread to finish writing to it
+            Thread::yield();
+        }
+    }
+
+    /** Writes a block to every consumer (called on the audio thread). The block must have the number of channels given to prepare(). */
+    void writeBlock (const dsp::AudioBlock<float>& block)
+    {
+        jassert (static_cast<int> (block.getNumChannels()) == numChannels);
+        const auto numSamples = static_cast<int> (block.getNumSamples());
+        const auto numChannelsToWrite = jmin (numChannels, static_cast<int> (block.getNumChannels()));
+
+        for (auto* consumer : consumers)
+        {
+            auto expected = static_cast<uint32> (active);
+            if (!consumer->state.compare_exchange_strong (expected, writing, std::memory_order_acquire))
+                continue;
+
+            if (consumer->fifo.getFreeSpace() < numSamples)
+            {
+                consumer->lostSamples.set (consumer->lostSamples.get() + numSamples);
+            }
+            else
+            {
+                int start1, size1, start2, size2;
+                consumer->fifo.prepareToWrite (numSamples, start1, size1, start2, size2);
+                for (auto ch = 0; ch < numChannelsToWrite; ++ch)
+                {
+                    const auto* source = block.getChannelPointer (static_cast<size_t> (ch));
+                    consumer->ring.copyFrom (ch, start1, source, size1);
+                    consumer->ring.copyFrom (ch, start2, source + size1, size2);
+                }
+                consumer->fifo.finishedWrite (size1 + size2);
+            }
+            consumer->state.store (active, std::memory_order_release);
+        }
+
+        listeners.callAll();
+    }
+
+    /** Returns the number of samples waiting to be read by the consumer. */
+    [[nodiscard]] int getNumReady (const int consumerId) const
+    {
+        return isPositiveAndBelow (consumerId, consumers.size()) ? consumers[consumerId]->fifo.getNumReady() : 0;
+    }
+
+    /** Reads up to numSamples of every channel into destination (starting at destStartSample) & advances the consumer's cursor (called
+     *  by the consumer). The destination must have at least as many channels as the stream. Returns the number of samples read. */
+    int read (const int consumerId, AudioSampleBuffer& destination, const int destStartSample, const int numSamples)
+    {
+        if (!isPositiveAndBelow (consumerId, consumers.size()))
+            return 0;
+
+        jassert (destination.getNumChannels() >= numChannels);
+        jassert (destStartSample + numSamples <= destination.getNumSamples());
+        auto* consumer = consumers[consumerId];
+        int start1, size1, start2, size2;
+        consumer->fifo.prepareToRead (numSamples, start1, size1, start2, size2);
+        for (auto ch = 0; ch < jmin (numChannels, destination.getNumChannels()); ++ch)
+        {
+            destination.copyFrom (ch, destStartSample, consumer->ring, ch, start1, size1);
+            destination.copyFrom (ch, destStartSample + size1, consumer->ring, ch, start2, size2);
+        }
+        consumer->fifo.finishedRead (size1 + size2);
+        return size1 + size2;
+    }
+
+    /** Gets the number of samples (per channel) the consumer has lost because its ring was full when a block was written. */
+    [[nodiscard]] int64 getNumLostSamples (const int consumerId) const
+    {
+        return isPositiveAndBelow (consumerId, consumers.size()) ? consumers[consumerId]->lostSamples.get() : 0;
+    }
+
+    /** Allows a listener to add a lambda function as a callback which is called on the audio thread after each block is written (see
+     *  AudioProbe::addListenerCallback). */
+    ListenerRemovalCallback addListenerCallback (ListenerCallback&& listenerCallback)
+    {
+        WeakReference<AudioStreamingProbe> weakThis = this;
+        const auto handle = listeners.add (std::move (listenerCallback));
+        return [this, weakThis, handle] ()
+        {
+            // Check the WeakReference because the callback may live longer than this AudioStreamingProbe
+            if (weakThis)
+                listeners.remove (handle);
+        };
+    }
+
+private:
+
+    /** The state of a consumer's slot. */
+    enum Status : uint32
+    {
+        free = 0,
+        reserved,   // Being reset for a new consumer
+        active,
+        writing     // Being written by the audio thread
+    };
+
+    struct Consumer
+    {
+        AbstractFifo fifo { 1 };
+        AudioSampleBuffer ring;
+        std::atomic<uint32> state { free };
+        Atomic<int64> lostSamples = 0;
+    };
+
+    OwnedArray<Consumer> consumers;
+    ListenerRegistry listeners;
+    int numChannels = 0;
+
+    WeakReference<AudioStreamingProbe>::Master masterReference;
+    friend class WeakReference<AudioStreamingProbe>;
+
+public:
+    // Declare non-copyable, non-movable
+    AudioStreamingProbe (const AudioStreamingProbe&) = delete;
+    AudioStreamingProbe& operator= (const AudioStreamingProbe&) = delete;
+    AudioStreamingProbe (AudioStreamingProbe&& other) = delete;
+    AudioStreamingProbe& operator=(AudioStreamingProbe&& other) = delete;
 };
\ No newline at end of file
@@ -11,11 +11,26 @@
 #pragma once
 
 #include "AudioDataTransfer.h"
+#include "ScopeHistory.h"
 
 /**
 	This class inherits from FixedBlockProcessor so that it can run on the audio processing thread and allow an audio scope
 	to be delivered data at a fixed block size, regardless of the block sized used by the audio device or host. An AudioProbe object
 	is then used to make the processed data available for use on other threads.
+
+	Only the enabled channels are copied (see FixedBlockProcessor::setChannelMask), so a scope can show a few channels of a high channel
+	count interface cheaply. Listeners are notified once the last enabled channel has been written.
+
+	Each frame also carries a min/max/mean pyramid of the samples (each level halves the number of values), so a scope can aggregate
+	any range of samples by visiting a couple of values per level instead of every sample (see getPeak & getSum).
+
+	If a history length has been set, the enabled channels are also recorded into a ScopeHistory so that a scope can roll through
+	(or zoom & pan across) seconds to minutes of audio.
+
+	By default every block is published (free run). If a trigger mode is set, the first enabled channel is searched for the trigger on
+	the audio thread & only windows around a trigger are published (starting a pre-trigger length before the trigger), so periodic
+	signals stay still & listeners are only notified when there is a new window worth painting. Triggering needs the channels to be
+	appended in lockstep (see FixedBlockProcessor::appendBlock).
 */
 class AudioScopeProcessor final : public FixedBlockProcessor
 {
@@ -23,21 +38,47 @@ private:
     static const int frame_size = 4096;
 
 public:
+    /** Number of levels in the pyramid (the top level has a single value covering the whole frame). */
+    static constexpr int numPyramidLevels = 12;
+
     struct OscilloscopeFrame final
     {
 	    alignas(16) float f[frame_size];
+        alignas(16) float peak[frame_size];    // Value with the largest magnitude in each cell of each level (the first one if tied)
+        alignas(16) float sum[frame_size];     // Sum of each cell of each level
+        int triggerIndex;                      // Index of the trigger in f (-1 if the frame wasn't triggered)
+    };
+
+    /** Defines when frames are published */
+    enum TriggerMode
+    {
+        FreeRun = 1,        // Every block is published
+        RisingEdge,         // The signal rises through the trigger level
+        FallingEdge,        // The signal falls through the trigger level
+        Level               // The magnitude of the signal rises through the trigger level (i.e. an edge of either polarity)
     };
 
+    /** Returns the sample in [startSample, endSample) with the largest magnitude (keeping its sign), or the first such sample if there
+     *  is a tie, visiting O(log n) values of the pyramid. */
+    static float getPeak (const OscilloscopeFrame& frame, const int startSample, const int endSample);
+
+    /** Returns the sum of the samples in [startSample, endSample), visiting O(log n) values of the pyramid. */
+    static float getSum (const OscilloscopeFrame& frame, const int startSample, const int endSample);
+
     explicit AudioScopeProcessor();
     ~AudioScopeProcessor() override = default;
 
     void prepare (const dsp::ProcessSpec& spec) override;
     void performProcessing (const int channel) override;
+    void performMultichannelProcessing() override;
 
-    /** Copy frame of audio data */
+    /** Copy frame of audio data (the samples only, without the pyramid) */
     void copyFrame (float* dest, const int channel) const;
 
-    /** Allows a listener to add a lambda function as a callback to the AudioProbe assigned to the last channel.
+    /** Leases the latest frame of audio data so that it can be read in place, without a copy (see AudioProbe::leaseFrame). */
+    AudioProbe<OscilloscopeFrame>::ReadLease leaseFrame (const int channel) const;
+
+    /** Allows a listener to add a lambda function as a callback which is called after the last enabled channel has been written.
      *  Listener callbacks are cleared each time prepare() is called on this class, so they must be added after this.
      *  
      *  Returns a function which allows the listener to de-register it's callback. The listener must remove any references
@@ -45,9 +86,79 @@ public:
      */
     ListenerRemovalCallback addListenerCallback (ListenerCallback&& listenerCallback) const;
 
+    /** Sets the length of history to record for each enabled channel (zero, the default, disables the history). The memory is allocated
+     *  by prepare() for the channels enabled at that point, so this takes effect the next time the processor is prepared. */
+    void setHistoryLength (const float lengthInSeconds);
+    float getHistoryLength() const;
+
+    /** Returns the history recorded since the processor was last prepared (see ScopeHistory). */
+    const ScopeHistory& getHistory() const;
+
+    /** Sets the trigger mode (otherwise initialised to free run). */
+    void setTriggerMode (const TriggerMode mode);
+    TriggerMode getTriggerMode() const;
+
+    /** Sets the trigger level (as a linear amplitude). The signal has to move away from the level by a small hysteresis (5% of the level,
+     *  or 0.001 if greater) before the trigger re-arms, so noise around the level doesn't cause false triggers. */
+    void setTriggerLevel (const float level);
+    float getTriggerLevel() const;
+
+    /** Sets whether an untriggered frame is published if no trigger has been found for a quarter of a second (or two frames if
+     *  longer), so that the scope shows something when the signal doesn't reach the trigger level. */
+    void setAutoTrigger (const bool shouldAutoTrigger);
+    bool isAutoTriggerEnabled() const;
+
+    /** Sets the number of samples before the trigger in a triggered frame. */
+    void setPreTriggerLength (const int numSamples);
+    int getPreTriggerLength() const;
+
 
 private:
+    /** Returns the index in OscilloscopeFrame::peak & sum of the first cell of a level of the pyramid (level 1 has cells of two
+     *  samples, level 2 of four samples & so on). */
+    static constexpr int getPyramidOffset (const int level) { return frame_size - (frame_size >> (level - 1)); }
+
+    /** Calls function (level, cell) for each cell of the pyramid which makes up [startSample, endSample), in order (level 0 is a sample). */
+    template <typename Function>
+    static void forEachPyramidCell (const int startSample, const int endSample, Function&& function);
+
+    /** Builds the pyramid over the samples in the frame. */
+    static void buildPyramid (OscilloscopeFrame& frame);
+
+    /** Searches the new samples for triggers & publishes each completed window (see performMultichannelProcessing). */
+    void performTriggeredProcessing (const TriggerMode mode);
+
+    /** Returns true if the sample completes a trigger, tracking whether the trigger is armed. */
+    bool detectTrigger (const float sample, const TriggerMode mode, const float level);
+
+    /** Publishes a frame of every enabled channel from the capture ring, starting at an absolute position in the stream. */
+    void publishCapturedFrame (const int64 startPosition, const int triggerIndex);
+
+    /** Builds the pyramid over the output frame & writes it to the channel's probe. */
+    void publishFrame (const int channel);
+
+    void notifyListeners();
+
     OwnedArray <AudioProbe <OscilloscopeFrame>> audioProbes{};
+    std::unique_ptr<OscilloscopeFrame> outputFrame{};
+    ScopeHistory history;
+    Atomic<float> historyLength { 0.0f };
+    std::unique_ptr<AudioProbe<int>> notificationProbe{}; // Only used to notify listeners (holds the number of frames written)
+    int numFramesWritten = 0;
+
+    Atomic<int> triggerMode { FreeRun };
+    Atomic<float> triggerLevel { 0.0f };
+    Atomic<bool> autoTrigger { true };
+    Atomic<int> preTriggerLength { frame_size / 16 };
+
+    // Trigger state (only used on the audio thread)
+    AudioBuffer<float> captureRing;     // The most recent samples of each enabled channel (two frames, so a window is always available)
+    int64 capturePosition = 0;          // Number of samples written to the capture ring since the trigger mode was changed
+    int64 pendingTrigger = -1;          // Position of a trigger whose window hasn't been completed (or -1)
+    int64 lastPublishedPosition = 0;    // Position of the end of the last frame published
+    int autoTriggerTimeout = 0;
+    TriggerMode lastTriggerMode = FreeRun;
+    bool triggerArmed = false;
 
 public:
     // Declare non-copyable, non-movable
@@ -75,16 +186,290 @@ inline void AudioScopeProcessor::prepare (const dsp::ProcessSpec& spec)
     // Add probes for each channel to transfer audio data to the GUI
     for (auto ch = 0; ch < static_cast<int>(spec.numChannels); ++ch)
         audioProbes.add (new AudioProbe<OscilloscopeFrame>());
+    notificationProbe = std::make_unique<AudioProbe<int>>();
+    outputFrame = std::make_unique<OscilloscopeFrame>();
+    outputFrame->triggerIndex = -1;
+    captureRing.setSize (static_cast<int> (spec.numChannels), 2 * frame_size);
+    captureRing.clear();
+    capturePosition = 0;
+    pendingTrigger = -1;
+    lastPublishedPosition = 0;
+    autoTriggerTimeout = jmax (2 * frame_size, roundToInt (spec.sampleRate * 0.25));
+    lastTriggerMode = FreeRun;
+    triggerArmed = false;
+    history.prepare (spec, getChannelMask(), static_cast<double> (historyLength.get()), getMaximumBlockSize());
 }
 
 inline void AudioScopeProcessor::performProcessing (const int channel)
 {
-    audioProbes[channel]->writeFrame (reinterpret_cast<const OscilloscopeFrame*> (buffer.getReadPointer (channel)));
+    // Build the pyramid on the new block (the block may be read in place from the source data, so only copy the samples in the
+    // current block - any samples beyond it are left over from the last block, as the scope may show the maximum block size)
+    FloatVectorOperations::copy (outputFrame->f, getBlockReadPointer (channel), getCurrentBlockSize());
+    outputFrame->triggerIndex = -1;
+    publishFrame (channel);
+
+    // Only the last hop of the block is new, so only record that into the history
+    const auto numNewSamples = jmin (getHopSize(), getCurrentBlockSize());
+    history.writeChannel (channel, getBlockReadPointer (channel) + getCurrentBlockSize() - numNewSamples, numNewSamples);
+
+    if (channel == getLastEnabledChannel())
+    {
+        history.advance (numNewSamples);
+        notifyListeners();
+    }
+}
+
+inline void AudioScopeProcessor::performMultichannelProcessing()
+{
+    // Start searching afresh whenever the trigger mode changes
+    const auto mode = static_cast<TriggerMode> (triggerMode.get());
+    if (mode != lastTriggerMode)
+    {
+        lastTriggerMode = mode;
+        capturePosition = 0;
+        pendingTrigger = -1;
+        lastPublishedPosition = 0;
+        triggerArmed = false;
+    }
+
+    if (mode == FreeRun)
+        FixedBlockProcessor::performMultichannelProcessing();
+    else
+        performTriggeredProcessing (mode);
+}
+
+inline void AudioScopeProcessor::performTriggeredProcessing (const TriggerMode mode)
+{
+    // Record the new samples of each enabled channel (a window can start in an earlier block & end in a later one)
+    const auto numNewSamples = jmin (getHopSize(), getCurrentBlockSize());
+    const auto ringSize = captureRing.getNumSamples();
+    const auto ringStart = static_cast<int> (capturePosition % ringSize);
+    const auto numBeforeWrap = jmin (numNewSamples, ringSize - ringStart);
+    for (auto ch = 0; ch < getNumChannels(); ++ch)
+    {
+        const auto* block = getBlockReadPointer (ch);
+        if (block == nullptr)
+            continue;
+        const auto* newSamples = block + getCurrentBlockSize() - numNewSamples;
+        captureRing.copyFrom (ch, ringStart, newSamples, numBeforeWrap);
+        captureRing.copyFrom (ch, 0, newSamples + numBeforeWrap, numNewSamples - numBeforeWrap);
+        history.writeChannel (ch, newSamples, numNewSamples);
+    }
+    history.advance (numNewSamples);
+
+    const auto start = capturePosition;
+    capturePosition += numNewSamples;
+
+    // Search the first enabled channel, publishing each window as soon as its last sample has arrived (triggers found while a window
+    // is pending are ignored, so the search resumes once the window has been published)
+    const auto triggerChannel = getFirstEnabledChannel();
+    if (triggerChannel < 0 || getBlockReadPointer (triggerChannel) == nullptr)
+        return;
+    const auto* source = getBlockReadPointer (triggerChannel) + getCurrentBlockSize() - numNewSamples;
+    const auto level = triggerLevel.get();
+    const auto preTrigger = static_cast<int64> (preTriggerLength.get());
+    for (auto i = 0; i < numNewSamples; ++i)
+    {
+        const auto position = start + i;
+        if (detectTrigger (source[i], mode, level) && pendingTrigger < 0)
+            pendingTrigger = position;
+
+        if (pendingTrigger >= 0)
+        {
+            const auto windowStart = jmax (int64 (0), pendingTrigger - preTrigger);
+            if (position + 1 == windowStart + frame_size)
+            {
+                publishCapturedFrame (windowStart, static_cast<int> (pendingTrigger - windowStart));
+                pendingTrigger = -1;
+            }
+        }
+    }
+
+    // Without a trigger for a while, auto mode publishes the latest samples (untriggered) so the scope doesn't look dead
+    if (autoTrigger.get() && pendingTrigger < 0 && capturePosition >= frame_size && capturePosition - lastPublishedPosition >= autoTriggerTimeout)
+        publishCapturedFrame (capturePosition - frame_size, -1);
+}
+
+inline bool AudioScopeProcessor::detectTrigger (const float sample, const TriggerMode mode, const float level)
+{
+    // Flip the falling edge & take the magnitude for the level mode, so each is a rising edge through the threshold. The trigger only
+    // re-arms once the signal has dropped below the threshold by the hysteresis
+    const auto value = mode == Level ? std::abs (sample) : (mode == FallingEdge ? -sample : sample);
+    const auto threshold = mode == Level ? std::abs (level) : (mode == FallingEdge ? -level : level);
+    const auto hysteresis = jmax (0.001f, std::abs (level) * 0.05f);
+    if (value < threshold - hysteresis)
+    {
+        triggerArmed = true;
+        return false;
+    }
+    if (triggerArmed && value >= threshold)
+    {
+        triggerArmed = false;
+        return true;
+    }
+    return false;
+}
+
+inline void AudioScopeProcessor::publishCapturedFrame (const int64 startPosition, const int triggerIndex)
+{
+    jassert (capturePosition - startPosition <= captureRing.getNumSamples());
+
+    const auto ringSize = captureRing.getNumSamples();
+    const auto ringStart = static_cast<int> (startPosition % ringSize);
+    const auto numBeforeWrap = jmin (frame_size, ringSize - ringStart);
+    for (auto ch = 0; ch < getNumChannels(); ++ch)
+    {
+        if (!isChannelEnabled (ch))
+            continue;
+        const auto* ring = captureRing.getReadPointer (ch);
+        FloatVectorOperations::copy (outputFrame->f, ring + ringStart, numBeforeWrap);
+        FloatVectorOperations::copy (outputFrame->f + numBeforeWrap, ring, frame_size - numBeforeWrap);
+        outputFrame->triggerIndex = triggerIndex;
+        publishFrame (ch);
+    }
+    lastPublishedPosition = startPosition + frame_size;
+    notifyListeners();
+}
+
+inline void AudioScopeProcessor::publishFrame (const int channel)
+{
+    buildPyramid (*outputFrame);
+    audioProbes[channel]->writeFrame (outputFrame.get());
+}
+
+inline void AudioScopeProcessor::notifyListeners()
+{
+    ++numFramesWritten;
+    notificationProbe->writeFrame (&numFramesWritten);
 }
 
 inline void AudioScopeProcessor::copyFrame (float* dest, const int channel) const
 {
-    audioProbes[channel]->copyFrame (reinterpret_cast<OscilloscopeFrame*>(dest));
+    audioProbes[channel]->copyFrame (reinterpret_cast<OscilloscopeFrame*>(dest), sizeof (float) * frame_size);
+}
+
+inline void AudioScopeProcessor::setHistoryLength (const float lengthInSeconds)
+{
+    historyLength.set (jmax (0.0f, lengthInSeconds));
+}
+
+inline float AudioScopeProcessor::getHistoryLength() const
+{
+    return historyLength.get();
+}
+
+inline const ScopeHistory& AudioScopeProcessor::getHistory() const
+{
+    return history;
+}
+
+inline void AudioScopeProcessor::setTriggerMode (const TriggerMode mode)
+{
+    triggerMode.set (mode);
+}
+
+inline AudioScopeProcessor::TriggerMode AudioScopeProcessor::getTriggerMode() const
+{
+    return static_cast<TriggerMode> (triggerMode.get());
+}
+
+inline void AudioScopeProcessor::setTriggerLevel (const float level)
+{
+    triggerLevel.set (level);
+}
+
+inline float AudioScopeProcessor::getTriggerLevel() const
+{
+    return triggerLevel.get();
+}
+
+inline void AudioScopeProcessor::setAutoTrigger (const bool shouldAutoTrigger)
+{
+    autoTrigger.set (shouldAutoTrigger);
+}
+
+inline bool AudioScopeProcessor::isAutoTriggerEnabled() const
+{
+    return autoTrigger.get();
+}
+
+inline void AudioScopeProcessor::setPreTriggerLength (const int numSamples)
+{
+    preTriggerLength.set (jlimit (0, frame_size - 1, numSamples));
+}
+
+inline int AudioScopeProcessor::getPreTriggerLength() const
+{
+    return preTriggerLength.get();
+}
+
+inline float AudioScopeProcessor::getPeak (const OscilloscopeFrame& frame, const int startSample, const int endSample)
+{
+    auto peak = 0.0f;
+    auto peakAbs = -1.0f;
+    forEachPyramidCell (startSample, endSample, [&] (const int level, const int cell)
+    {
+        const auto value = level == 0 ? frame.f[cell] : frame.peak[getPyramidOffset (level) + cell];
+        if (std::abs (value) > peakAbs)
+        {
+            peak = value;
+            peakAbs = std::abs (value);
+        }
+    });
+    return peak;
+}
+
+inline float AudioScopeProcessor::getSum (const OscilloscopeFrame& frame, const int startSample, const int endSample)
+{
+    auto sum = 0.0f;
+    forEachPyramidCell (startSample, endSample, [&] (const int level, const int cell)
+    {
+        sum += level == 0 ? frame.f[cell] : frame.sum[getPyramidOffset (level) + cell];
+    });
+    return sum;
+}
+
+template <typename Function>
+void AudioScopeProcessor::forEachPyramidCell (const int startSample, const int endSample, Function&& function)
+{
+    jassert (startSample >= 0 && endSample <= frame_size);
+
+    // Take the largest aligned cell that starts at the current sample & fits in the range (at most two cells per level are visited)
+    auto start = jmax (0, startSample);
+    const auto end = jmin (frame_size, endSample);
+    while (start < end)
+    {
+        auto level = 0;
+        while (level < numPyramidLevels && (start & ((2 << level) - 1)) == 0 && start + (2 << level) <= end)
+            ++level;
+        function (level, start >> level);
+        start += 1 << level;
+    }
+}
+
+inline void AudioScopeProcessor::buildPyramid (OscilloscopeFrame& frame)
+{
+    for (auto level = 1; level <= numPyramidLevels; ++level)
+    {
+        // Each cell combines a pair of cells from the level below (the first of the pair wins a tie, so ties go to the earliest sample)
+        const auto* belowPeak = level == 1 ? frame.f : frame.peak + getPyramidOffset (level - 1);
+        const auto* belowSum = level == 1 ? frame.f : frame.sum + getPyramidOffset (level - 1);
+        auto* peak = frame.peak + getPyramidOffset (level);
+        auto* sum = frame.sum + getPyramidOffset (level);
+        const auto numCells = frame_size >> level;
+        for (auto cell = 0; cell < numCells; ++cell)
+        {
+            const auto first = belowPeak[2 * cell];
+            const auto second = belowPeak[2 * cell + 1];
+            peak[cell] = std::abs (second) > std::abs (first) ? second : first;
+            sum[cell] = belowSum[2 * cell] + belowSum[2 * cell + 1];
+        }
+    }
+}
+
+inline AudioProbe<AudioScopeProcessor::OscilloscopeFrame>::ReadLease AudioScopeProcessor::leaseFrame (const int channel) const
+{
+    return audioProbes[channel]->leaseFrame();
 }
 
 inline ListenerRemovalCallback AudioScopeProcessor::addListenerCallback (ListenerCallback&& listenerCallback) const
@@ -92,8 +477,8 @@ inline ListenerRemovalCallback AudioScopeProcessor::addListenerCallback (Listene
     // If this asserts then you're trying to add the listener before the AudioProbes are set up
     jassert (getNumChannels()>0);
 
-    if (audioProbes.size() == getNumChannels() && audioProbes[getNumChannels() - 1])
-        return audioProbes[getNumChannels() - 1]->addListenerCallback (std::forward<ListenerCallback> (listenerCallback));
+    if (notificationProbe != nullptr)
+        return notificationProbe->addListenerCallback (std::forward<ListenerCallback> (listenerCallback));
 
     return {};
 }
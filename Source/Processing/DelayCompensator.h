@@ -0,0 +1,131 @@
+/*
+  ==============================================================================
+
+    DelayCompensator.h
+    Created: 18 Oct 2026 1:09:36pm
+    Author:  Andrew
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+
+/**
+	Multichannel ring buffer delay used to time align the outputs of processors that have different latencies.
+	All memory is allocated in prepare() so that setDelay() and process() are safe to call on the audio thread. The input is always
+	written to the ring (even with no delay), so when the delay changes the next block can cross-fade from the old read position to
+	the new one rather than jumping or going silent.
+*/
+class DelayCompensator final
+{
+public:
+    DelayCompensator() = default;
+    ~DelayCompensator() = default;
+
+    /** Allocates enough memory to delay blocks of up to spec.maximumBlockSize samples by up to maximumDelaySamples. */
+    void prepare (const dsp::ProcessSpec& spec, const int maximumDelaySamples)
+    {
+        jassert (maximumDelaySamples >= 0);
+        maxDelay = maximumDelaySamples;
+        bufferSize = nextPowerOfTwo (maximumDelaySamples + static_cast<int> (spec.maximumBlockSize));
+        buffer.setSize (static_cast<int> (spec.numChannels), bufferSize);
+        fadeBuffer.setSize (1, static_cast<int> (spec.maximumBlockSize));
+        reset();
+    }
+
+    /** Clears the delayed audio. */
+    void reset()
+    {
+        buffer.clear();
+        writeIndex = 0;
+        previousDelay = delay;
+    }
+
+    /** Sets the delay in samples (this is limited to the maximum delay specified in prepare). The next block processed cross-fades
+     *  from the old delay to the new one. */
+    void setDelay (const int delaySamples)
+    {
+        jassert (delaySamples <= maxDelay);
+        delay = jlimit (0, maxDelay, delaySamples);
+    }
+
+    [[nodiscard]] int getDelay() const noexcept
+    {
+        return delay;
+    }
+
+    [[nodiscard]] int getMaximumDelay() const noexcept
+    {
+        return maxDelay;
+    }
+
+    /** Delays the block in place. */
+    void process (const dsp::AudioBlock<float>& block)
+    {
+        const auto numSamples = static_cast<int> (block.getNumSamples());
+        const auto numChannels = jmin (static_cast<int> (block.getNumChannels()), buffer.getNumChannels());
+        jassert (numSamples + jmax (delay, previousDelay) <= bufferSize);
+        jassert (numSamples <= fadeBuffer.getNumSamples());
+
+        const auto isFading = delay != previousDelay && numSamples <= fadeBuffer.getNumSamples();
+        const auto readIndex = (writeIndex - delay + bufferSize) & (bufferSize - 1);
+        const auto previousReadIndex = (writeIndex - previousDelay + bufferSize) & (bufferSize - 1);
+        for (auto ch = 0; ch < numChannels; ++ch)
+        {
+            auto* data = block.getChannelPointer (static_cast<size_t> (ch));
+            auto* ring = buffer.getWritePointer (ch);
+            copyIntoRing (ring, writeIndex, data, numSamples);
+            if (isFading)
+            {
+                // Cross-fade linearly from the old delay to the new one over the block
+                auto* previous = fadeBuffer.getWritePointer (0);
+                copyFromRing (previous, ring, previousReadIndex, numSamples);
+                copyFromRing (data, ring, readIndex, numSamples);
+                for (auto i = 0; i < numSamples; ++i)
+                {
+                    const auto proportion = static_cast<float> (i + 1) / static_cast<float> (numSamples);
+                    data[i] = previous[i] + (data[i] - previous[i]) * proportion;
+                }
+            }
+            else if (delay > 0)
+            {
+                copyFromRing (data, ring, readIndex, numSamples);
+            }
+        }
+        writeIndex = (writeIndex + numSamples) & (bufferSize - 1);
+        previousDelay = delay;
+    }
+
+private:
+
+    void copyIntoRing (float* ring, const int index, const float* src, const int numSamples) const
+    {
+        const auto firstPart = jmin (numSamples, bufferSize - index);
+        FloatVectorOperations::copy (ring + index, src, firstPart);
+        FloatVectorOperations::copy (ring, src + firstPart, numSamples - firstPart);
+    }
+
+    void copyFromRing (float* dest, const float* ring, const int index, const int numSamples) const
+    {
+        const auto firstPart = jmin (numSamples, bufferSize - index);
+        FloatVectorOperations::copy (dest, ring + index, firstPart);
+        FloatVectorOperations::copy (dest + firstPart, ring, numSamples - firstPart);
+    }
+
+    AudioSampleBuffer buffer{};
+    AudioSampleBuffer fadeBuffer{};
+    int bufferSize = 1;
+    int writeIndex = 0;
+    int delay = 0;
+    int previousDelay = 0;      // The delay used for the last block processed
+    int maxDelay = 0;
+
+public:
+    // Declare non-copyable, non-movable
+    DelayCompensator (const DelayCompensator&) = delete;
+    DelayCompensator& operator= (const DelayCompensator&) = delete;
+    DelayCompensator (DelayCompensator&& other) = delete;
+    DelayCompensator& operator= (DelayCompensator&& other) = delete;
+};
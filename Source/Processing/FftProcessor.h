@@ -11,56 +11,268 @@
 #pragma once
 
 #include "AudioDataTransfer.h"
+#include "HalfBandDecimator.h"
 
 /**
-	This class inherits from FixedBlockProcessor so that it can run on the audio processing thread and allow a FFT to
-	be computed on a fixed block size, regardless of the block sized used by the audio device or host. An AudioProbe object
-	is then used to make the processed data available for use on other threads.
+	This class inherits from FixedBlockProcessor so that it can run on the audio processing thread and collect blocks of a fixed
+	size, regardless of the block sized used by the audio device or host. Each block is pushed through a FrameQueue to a worker
+	thread which computes the FFT (so the audio thread isn't burdened with it). AudioProbe objects are then used to make the
+	processed data available for use on other threads.
+
+    The FFT size can be changed at runtime (see setFftOrder). A plan (i.e. a dsp::FFT object & a table for every window) is built for
+    every supported size on construction, so changing size or window never allocates. A change of size takes effect at the next block
+    boundary & a change of window takes effect at the next FFT frame.
+
+    Successive FFT frames can overlap (see setOverlap) which increases the update rate without needing a larger FFT.
+
+    Frames can be averaged in power (see setAveraging), either linearly over a number of frames (i.e. Welch's method) or exponentially.
+    The output can be either the amplitude of each bin or the power spectral density (see setPowerSpectralDensityEnabled).
+
+    In multi-resolution mode (see setResolutionLevels) the block is also fed through a cascade of half-band decimators, and an FFT of
+    the same size is computed at each decimated rate. The top octaves come from the undecimated FFT & each further level contributes
+    the octave below, so every level doubles the resolution of the bottom octave without needing a larger FFT. The results are
+    stitched together into one frame (in ascending frequency order) so bins are no longer evenly spaced - use getBinFrequencies to
+    find the frequency of each bin. Deeper levels update less often (each level halves the rate) & span a longer stretch of audio.
+
+    Phase can also be computed (see setPhaseEnabled), in which case a complex FFT is used in place of the frequency-only transform &
+    the unwrapped phase & group delay of each bin are written to a second probe per channel (see copyPhaseFrame). Phase is measured
+    relative to the centre of the window, so a symmetric impulse at the centre of the frame has zero phase & zero group delay. It isn't
+    averaged & it isn't computed in multi-resolution mode (where the levels are computed at different times).
+
+    Hold traces can be kept for each channel (see setHoldTracesEnabled): an infinite peak hold, an infinite minimum hold (which shows
+    the noise floor over a long run) & a timed peak hold (see setHoldTime). They are taken from the averaged output (before the
+    amplitude envelope), are restarted by resetHoldTraces or by any change to the layout or units of the frame, & are written to
+    their own probes (see copyHoldFrame). Each is a vectorised max or min over the frame, so they cost O(bins) per frame.
+
+    The per-channel buffers & probes are only as large as the current FFT size & number of levels need, & those for features that are
+    switched off (phase, hold traces, the amplitude envelope & averaging) aren't allocated at all. When a setting changes what is
+    needed, the analysis thread reallocates them before it analyses the next frame (so the audio thread is never involved). Readers
+    are held off while the probes are replaced (they simply find no frame), so keep leases short.
+
+    With high channel counts, analyse only the channels that are needed (see FixedBlockProcessor::setChannelMask): disabled channels
+    are discarded before they're queued & have no buffers or probes, so they cost next to nothing. Listeners are notified once the
+    last enabled channel of each block has been analysed, & the load on the analysis thread is measured so that the cost of the
+    enabled channels can be shown (see getAnalysisLoad).
 */
-template <int Order>
 class FftProcessor final : public FixedBlockProcessor
 {
 public:
 
-	// This FftFrame is necessary for us to use the AudioProbe class and is why this class (& therefore FftScope) is templated.
+    static constexpr int minOrder = 8;      // 256 point FFT
+    static constexpr int maxOrder = 16;     // 65536 point FFT
+    static constexpr int defaultOrder = 12; // 4096 point FFT
+    static constexpr int maxSize = 1 << maxOrder;
+    static constexpr int maxResolutionLevels = 6;
+    static constexpr int maxNumBins = (maxResolutionLevels + 3) * (maxSize / 8) + 1; // Enough for the largest multi-resolution frame
+    static constexpr int numWindows = dsp::WindowingFunction<float>::numWindowingMethods;
+
+    /** Hold traces kept for each channel when hold traces are enabled. */
+    enum HoldTrace
+    {
+        PeakHold = 0,   // Maximum of each bin since the traces were restarted
+        MinHold,        // Minimum of each bin since the traces were restarted
+        TimedHold,      // Maximum of each bin over the last one to two hold times
+        numHoldTraces
+    };
+    static constexpr float kaiserBeta = 8.6f; // Gives sidelobes at about -90dB, similar to Blackman-Harris
+
+	/** This FftFrame is necessary for us to use the AudioProbe class. It is sized for the maximum FFT size, but the probes only hold
+	 *  (& copy) the header & the bins of the current layout. */
     struct FftFrame final
     {
-		alignas(16) float f [1 << Order];
+        int fftSize;                        // Size of the FFT that generated this frame (0 if no frame has been computed)
+        int numLevels;                      // Number of resolution levels stitched into this frame (1 for a single FFT)
+		alignas(16) float f [maxNumBins];   // Amplitude of each bin (from DC to Nyquist - see getBinFrequencies)
 	};
 
+    /** This PhaseFrame is necessary for us to use the AudioProbe class. It is sized for the maximum FFT size, but the probes only hold
+     *  (& copy) the header & the bins of the current FFT size. The phase of each bin comes first, followed by the group delay of each bin. */
+    struct PhaseFrame final
+    {
+        int fftSize;                        // Size of the FFT that generated this frame (0 if no frame has been computed)
+        alignas(16) float f [maxSize + 2];  // Unwrapped phase of each bin (radians) then the group delay of each bin (seconds)
+    };
+
+    /** Defines the overlap between successive FFT frames (values are used as ComboBox IDs). */
+    enum Overlap
+    {
+        None = 1,       // A frame is computed every FFT size samples
+        Half,           // 50% overlap
+        ThreeQuarters,  // 75% overlap
+        SevenEighths    // 87.5% overlap
+    };
+
+    /** Defines how successive FFT frames are averaged (values are used as ComboBox IDs). */
+    enum Averaging
+    {
+        NoAveraging = 1,        // Each frame is output as is
+        LinearAveraging,        // Power is averaged over blocks of frames & the average of the last complete block is output
+        ExponentialAveraging    // Power is averaged with an exponential weighting (defined by a time constant)
+    };
+
     explicit FftProcessor();
-    ~FftProcessor () override = default;
+    ~FftProcessor () override;
 
-    /** Note that this clears then sets AudioProbes per channel - so it must be called before any attached classes attempt to add listeners to the AudioProbes. */
+    /** Note that this clears then sets AudioProbes per channel - so it must be called before any attached classes attempt to add listeners to the AudioProbes.
+     *  This also (re)starts the analysis thread. */
     void prepare (const dsp::ProcessSpec& spec) override;
 
+    /** Called on the audio thread - this just queues the block for the analysis thread. */
     void performProcessing (const int channel) override;
-    
-    /** Copy frame of FFT frequency data */
-    void copyFrequencyFrame (float* dest, const int channel) const;
 
-    /** Copy frame of FFT phase data */
-	void copyPhaseFrame (float* dest, const int channel) const;
+    /** Returns the proportion of a CPU core used by the analysis thread (measured over the last half second or so). */
+    float getAnalysisLoad() const;
+
+    /** Returns the number of frames that were dropped because the analysis thread couldn't keep up (since prepare was called). */
+    int getNumDroppedFrames() const;
+
+    /** Copy frame of FFT frequency data. Returns the number of bins copied (or 0 if no valid frame was available). */
+    int copyFrequencyFrame (FftFrame& dest, const int channel) const;
+
+    /** A lease on the latest frame of FFT frequency data for a channel (see AudioProbe::leaseFrame). It also stops the analysis thread
+     *  reallocating the probes until it is destroyed, so keep it short (e.g. for a paint). */
+    class FrameLease final
+    {
+    public:
+        FrameLease (const FftProcessor& processorToRead, const int channel);
+        ~FrameLease();
+
+        /** Returns the leased frame (or nullptr if the lease is empty). */
+        [[nodiscard]] const FftFrame* get() const noexcept { return lease.get(); }
 
-    /** Call this to choose a different windowing method (class is initialised with Hann) */
+        const FftFrame* operator->() const noexcept { return get(); }
+        explicit operator bool() const noexcept { return static_cast<bool> (lease); }
+
+        FrameLease (const FrameLease&) = delete;
+        FrameLease& operator= (const FrameLease&) = delete;
+
+    private:
+        const FftProcessor& fftProcessor;
+        AudioProbe<FftFrame>::ReadLease lease;
+    };
+
+    /** Leases the latest frame of FFT frequency data so that it can be read in place, without a copy. The lease is empty if no valid
+     *  frame is available. The number of bins is getNumBins (frame->fftSize, frame->numLevels). */
+    FrameLease leaseFrequencyFrame (const int channel) const;
+
+    /** Copy frame of FFT phase data. Returns the number of bins copied (or 0 if no valid frame was available). The phase of bin k is
+     *  dest.f[k] & its group delay is dest.f[numBins + k]. */
+    int copyPhaseFrame (PhaseFrame& dest, const int channel) const;
+
+    /** Sets whether phase & group delay are computed (this costs a little more than the frequency-only transform). This is safe to
+     *  call from another thread. */
+    void setPhaseEnabled (const bool shouldComputePhase);
+
+    /** Returns true if phase & group delay are computed. */
+    bool isPhaseEnabled() const;
+
+    /** Copies the latest hold trace for the channel into dest in the same way as copyFrequencyFrame. Returns the number of bins copied
+     *  (or 0 if no trace is available). */
+    int copyHoldFrame (FftFrame& dest, const int channel, const HoldTrace trace) const;
+
+    /** Sets whether hold traces are kept (they restart when enabled). This is safe to call from another thread. */
+    void setHoldTracesEnabled (const bool shouldKeepHoldTraces);
+
+    /** Returns true if hold traces are being kept. */
+    bool areHoldTracesEnabled() const;
+
+    /** Sets how long the timed hold keeps a peak (in seconds). A peak is held for between one & two hold times, as the trace is the
+     *  maximum of the current & previous hold periods. */
+    void setHoldTime (const float holdTimeInSeconds);
+
+    /** Gets how long the timed hold keeps a peak (in seconds). */
+    float getHoldTime() const;
+
+    /** Restarts the hold traces. This is safe to call from another thread. */
+    void resetHoldTraces();
+
+    /** Sets the FFT size to 2 ^ order (where order is between minOrder & maxOrder). This is safe to call from another thread. */
+    void setFftOrder (const int order);
+
+    /** Gets the FFT order (i.e. the FFT size is 2 ^ order). */
+    int getFftOrder() const;
+
+    /** Sets the number of resolution levels (1 computes a single FFT, higher values enable multi-resolution mode with each extra level
+     *  analysing the octave below at twice the resolution). The FFT size applies to every level. This is safe to call from another thread. */
+    void setResolutionLevels (const int numLevels);
+
+    /** Gets the number of resolution levels. */
+    int getResolutionLevels() const;
+
+    /** Returns the number of samples spanned by the longest frame (i.e. the frame of the deepest resolution level). */
+    int getAnalysisLength() const;
+
+    /** Returns the number of bins in a frame computed with the given FFT size & number of resolution levels. */
+    static int getNumBins (const int fftSize, const int numLevels);
+
+    /** Fills dest with the centre frequency of each bin in a frame computed with the given FFT size & number of resolution levels. */
+    static void getBinFrequencies (float* dest, const int fftSize, const int numLevels, const double sampleRate);
+
+    /** Call this to choose a different windowing method (class is initialised with Hann). This is safe to call from another thread. */
     void setWindowingMethod (dsp::WindowingFunction<float>::WindowingMethod);
 
+    /** Gets the current windowing method. */
+    dsp::WindowingFunction<float>::WindowingMethod getWindowingMethod() const;
+
+    /** Gets the coherent gain of the current window (i.e. the mean of the window, which is the gain applied to a bin-centred sinusoid). */
+    float getWindowCoherentGain() const;
+
+    /** Gets the equivalent noise bandwidth of the current window (in bins). Divide a noise power spectrum by this to correct for the window. */
+    float getWindowEquivalentNoiseBandwidth() const;
+
+    /** Sets the overlap between successive FFT frames (class is initialised with no overlap). This is safe to call from another thread. */
+    void setOverlap (const Overlap overlap);
+
+    /** Gets the overlap between successive FFT frames. */
+    Overlap getOverlap() const;
+
+    /** Sets how successive FFT frames are averaged (class is initialised with no averaging). This is safe to call from another thread. */
+    void setAveraging (const Averaging averaging);
+
+    /** Gets how successive FFT frames are averaged. */
+    Averaging getAveraging() const;
+
+    /** Sets the number of frames in each block for linear averaging. */
+    void setLinearAveragingFrames (const int numFrames);
+
+    /** Gets the number of frames in each block for linear averaging. */
+    int getLinearAveragingFrames() const;
+
+    /** Sets the time constant for exponential averaging (in seconds). */
+    void setExponentialAveragingTime (const float timeConstantInSeconds);
+
+    /** Gets the time constant for exponential averaging (in seconds). */
+    float getExponentialAveragingTime() const;
+
+    /** Restarts averaging (e.g. after the signal being measured has changed). This is safe to call from another thread. */
+    void resetAveraging();
+
+    /** Sets whether the output is the power spectral density rather than the amplitude of each bin. The PSD is output as the square
+     *  root of the power per Hz (i.e. converting it to dB using 20 * log10 gives dB/Hz) & is corrected for the equivalent noise
+     *  bandwidth of the window. */
+    void setPowerSpectralDensityEnabled (const bool shouldOutputPsd);
+
+    /** Returns true if the output is the power spectral density. */
+    bool isPowerSpectralDensityEnabled() const;
+
     /** Sets whether or not an envelope will be applied to the amplitude output. */
     void setAmplitudeEnvelopeEnabled (const bool shouldBeEnabled);
 
     /** Returns true if an envelope us being applied to the amplitude output. */
     bool isAmplitudeEnvelopeEnabled() const;
 
-    /** Sets the release constant for the amplitude envelope. Note that this is calculated per FFT frame, which is a small
-     *  fraction of the sample rate - so a reasonable value is between 0.2f to 0.6f. */
+    /** Sets the release constant for the amplitude envelope (which holds the peak amplitude of each bin & releases it by this factor
+     *  per frame, so it doesn't change the level of a steady signal). Note that this is calculated per non-overlapped FFT frame of the default
+     *  size, which is a small fraction of the sample rate - so a reasonable value is between 0.2f to 0.6f. The constant is scaled for
+     *  other FFT sizes & overlaps so that the release time doesn't change. */
     void setAmplitudeEnvelopeReleaseConstant (const float releaseConstant);
 
     /** Gets the release constant for the amplitude envelope. */
     float getAmplitudeEnvelopeReleaseConstant() const;
 
-    /** Allows a listener to add a lambda function as a callback to the AudioProbe assigned to the phase of the last channel.
-     *  Listener callbacks are cleared each time prepare() is called on this class, so they must be added after this.
-     *  
+    /** Allows a listener to add a lambda function as a callback which is called once the last enabled channel of each block has been
+     *  analysed. Listener callbacks are cleared each time prepare() is called on this class, so they must be added after this.
+     *
      *  Returns a function which allows the listener to de-register it's callback. The listener must remove any references
      *  to de-register functions that have become invalid.
      */
@@ -68,138 +280,1112 @@ public:
 
 private:
 
-    dsp::FFT fft;
-    const int size;
+    /** Worker thread which computes FFTs for frames as they arrive in the queue. */
+    class AnalysisThread final : public Thread
+    {
+    public:
+        explicit AnalysisThread (FftProcessor& owner) : Thread ("FFT analysis"), fftProcessor (owner) { }
+        void run() override;
+    private:
+        FftProcessor& fftProcessor;
+        JUCE_DECLARE_NON_COPYABLE (AnalysisThread)
+    };
+
+    /** A precomputed window table along with its corrections. */
+    struct Window final
+    {
+        HeapBlock<float> table;
+        float amplitudeCorrectionFactor = 0.0f; // Scales a bin-centred sinusoid to its peak amplitude
+        float coherentGain = 0.0f;
+        float equivalentNoiseBandwidth = 0.0f;  // In bins
+    };
+
+    /** Everything needed to compute an FFT of a particular size. */
+    struct Plan final
+    {
+        explicit Plan (const int order);
+        dsp::FFT fft;
+        const int size;
+        Window windows [numWindows];
+    };
+
+    /** State of each decimated resolution level (one per level below the top one, for each channel). */
+    struct LevelState final
+    {
+        HalfBandDecimator decimator;
+        int writeIndex = 0;             // Write position in the level's history
+        int numSamples = 0;             // Number of valid samples in the level's history
+        int samplesSinceLastFrame = 0;  // Number of samples written since the level's last FFT
+    };
+
+    /** Averaging state for each channel (averaging restarts if any of the settings used to compute the average change). */
+    struct AveragingState final
+    {
+        int fftSize = 0;
+        int numLevels = 0;
+        int averaging = 0;
+        int windowingMethod = -1;
+        int generation = 0;
+        int numFrames = 0;      // Number of frames accumulated in the current block (linear averaging)
+        bool hasAverage = false;
+    };
+
+    /** Hold state for each channel (the traces restart if the layout or units of the frame change, or if they are reset). */
+    struct HoldState final
+    {
+        int layout = 0;
+        int generation = 0;
+        bool psd = false;
+        int samplesInPeriod = 0;    // Number of samples analysed in the current period of the timed hold
+    };
+
+    /** What the per-channel buffers & probes are allocated for (see reallocate). */
+    struct Allocation final
+    {
+        int fftSize = 0;
+        int numLevels = 0;
+        int averaging = NoAveraging;
+        uint64 channelMask = 0;     // The analysed channels
+        bool phase = false;
+        bool hold = false;
+        bool envelope = false;
+
+        bool operator== (const Allocation& other) const noexcept
+        {
+            return fftSize == other.fftSize && numLevels == other.numLevels && averaging == other.averaging
+                && channelMask == other.channelMask && phase == other.phase && hold == other.hold && envelope == other.envelope;
+        }
+        bool operator!= (const Allocation& other) const noexcept { return !operator== (other); }
+    };
+
+    /** Held while the probes are read, so that reallocate can't replace them (an invalid reader must not touch them). */
+    class ProbeReader final
+    {
+    public:
+        explicit ProbeReader (const FftProcessor& processorToRead);
+        ~ProbeReader();
+        [[nodiscard]] bool isValid() const noexcept { return valid; }
+        ProbeReader (const ProbeReader&) = delete;
+        ProbeReader& operator= (const ProbeReader&) = delete;
+    private:
+        const FftProcessor& fftProcessor;
+        bool valid = false;
+    };
+
+    /** Returns what needs to be allocated to analyse frames of the given FFT size with the current settings. */
+    Allocation getRequiredAllocation (const int fftSize) const;
+
+    /** Sizes the per-channel buffers & probes for the allocation, restarting the state of any that change size or move to another channel
+     *  (called on the analysis thread, or by prepare while the analysis thread is stopped). This waits for readers of the probes to finish. */
+    void reallocate (const Allocation& required);
+
+    /** Computes the FFT of the frame held in temp & writes the results to the probes for the channel (called on the analysis thread). */
+    void analyseFrame (const int channel, const int numSamples, const int hopSize);
+
+    /** Applies the window, computes the FFT & corrects the amplitude of the frame held in data (in place). If outputPower is true then
+     *  the mean square power of each bin is output instead of its amplitude (which saves a square root per bin when averaging). */
+    static void computeAmplitudes (float* data, const Plan& plan, const Window& window, const bool outputPower);
+
+    /** As computeAmplitudes, but uses a complex FFT so that the unwrapped phase & the group delay (in seconds) of each bin can be
+     *  written to the phase frame at the same time. */
+    static void computeAmplitudesAndPhase (float* data, PhaseFrame& phaseFrame, const Plan& plan, const Window& window, const double sampleRate);
+
+    /** Feeds the frame held in temp through the decimated levels & stitches the amplitudes of every level that has a new frame into
+     *  the multi-resolution frame of the channel in the slot (called on the analysis thread). */
+    void analyseLevels (const int slot, const Plan& plan, const Window& window, const int numLevels, const int hop);
+
+    /** Averages the data in power (as allocated for) for the channel in the slot & converts it to the output units (called on the
+     *  analysis thread). The data is the amplitude of each bin, or its mean square power if isPower is true. */
+    void applyAveraging (const int slot, float* data, const Plan& plan, const int windowIndex, const int numLevels, const bool isPower, const int hop);
+
+    /** Folds the output data into the channel's hold traces & writes them to the hold probes (called on the analysis thread). */
+    void updateHoldTraces (const int channel, const int slot, const float* data, const int fftSize, const int numLevels, const int hop);
+
+    /** Returns the range of bins from a level's FFT that are stitched into a multi-resolution frame. */
+    static Range<int> getLevelBins (const int fftSize, const int numLevels, const int level);
+
+    /** Returns a value which identifies the layout of a frame (used to detect when state computed from earlier frames is stale). */
+    static int getLayout (const int fftSize, const int numLevels);
+
+    /** Sets the hop size to suit the current FFT size & overlap. */
+    void updateHopSize();
+
+    /** Number of frames per channel that can be queued for the analysis thread (with many channels, the queue is capped at two blocks
+     *  of every channel, as it only has to absorb bursts & its memory would otherwise be large at the biggest FFT size). */
+    static constexpr int queueLengthPerChannel = 8;
+
+    /** Number of rows of holdBuffers per analysed channel (the timed hold needs the maxima of the current & previous periods). */
+    static constexpr int holdRowsPerChannel = numHoldTraces + 1;
+
+    OwnedArray<Plan> plans;
 	AudioSampleBuffer temp;
-	AudioSampleBuffer window;
     AudioSampleBuffer amplitudeEnvelope;
-    float amplitudeCorrectionFactor = 0.0f;
+    HeapBlock<int> amplitudeEnvelopeLayout;
+    OwnedArray<LevelState> levelStates;
+    AudioSampleBuffer levelHistory;
+    AudioSampleBuffer levelFrames;
+    HeapBlock<int> levelFramesLayout;
+    AudioSampleBuffer decimated;
+    AudioSampleBuffer powerSum;
+    AudioSampleBuffer powerAverage;
+    HeapBlock<AveragingState> averagingStates;
+    AudioSampleBuffer holdBuffers;
+    HeapBlock<HoldState> holdStates;
+    HeapBlock<int> channelSlots;    // Row (or state) of each channel in the per-channel buffers, which only cover the analysed channels (-1 if not analysed)
+    int numSlots = 0;
+    Allocation allocation;          // Only used by the analysis thread (& prepare)
+    mutable std::atomic<int> numReaders { 0 };
+    std::atomic<bool> isReallocating { false };
+    double sampleRate = 48000.0; // will be set correctly in prepare()
+    std::unique_ptr<FftFrame> outputFrame;
+    std::unique_ptr<PhaseFrame> outputPhaseFrame;
     Atomic<bool> amplitudeEnvelopeEnabled = false;
     Atomic<float> amplitudeReleaseConstant = 0.0f;
+    Atomic<int> fftOrder = defaultOrder;
+    Atomic<int> resolutionLevels = 1;
+    Atomic<int> overlap = None;
+    Atomic<int> windowingMethod = dsp::WindowingFunction<float>::hann;
+    Atomic<int> averagingMode = NoAveraging;
+    Atomic<int> linearAveragingFrames = 16;
+    Atomic<float> exponentialAveragingTime = 1.0f;
+    Atomic<int> averagingGeneration = 0;
+    Atomic<bool> psdEnabled = false;
+    Atomic<bool> phaseEnabled = false;
+    Atomic<bool> holdTracesEnabled = false;
+    Atomic<float> holdTime = 2.0f;
+    Atomic<int> holdGeneration = 0;
+
+    OwnedArray <AudioProbe <FftFrame>> freqProbes;  // One per channel (nullptr if the channel isn't analysed)
+    OwnedArray <AudioProbe <PhaseFrame>> phaseProbes;
+    OwnedArray <AudioProbe <FftFrame>> holdProbes;  // numHoldTraces per channel
+    std::unique_ptr<AudioProbe<int>> notificationProbe; // Only used to notify listeners (holds the number of blocks analysed)
+    int numBlocksAnalysed = 0;
+    Atomic<float> analysisLoad = 0.0f;
 
-    OwnedArray <AudioProbe <FftFrame>> freqProbes;;
-    OwnedArray <AudioProbe <FftFrame>> phaseProbes;
+    FrameQueue frameQueue;
+    AnalysisThread analysisThread { *this };
 };
 
 
 // ===========================================================================================
-//  Template implementations
+//  Implementation
 // ===========================================================================================
 
-template <int Order>
-FftProcessor<Order>::FftProcessor(): FixedBlockProcessor (1 << Order),
-                                      fft (Order),
-                                      size (1 << Order)
+inline FftProcessor::Plan::Plan (const int order) : fft (order), size (1 << order)
 {
-    temp.setSize (1, size * 2, false, true);
-    window.setSize (1, size);
+    for (auto w = 0; w < numWindows; ++w)
+    {
+        auto& window = windows[w];
+        window.table.allocate (static_cast<size_t> (size), true);
+        const auto method = static_cast<dsp::WindowingFunction<float>::WindowingMethod> (w);
+        dsp::WindowingFunction<float>::fillWindowingTables (window.table.getData(), static_cast<size_t> (size), method, false, kaiserBeta);
+
+        // Accumulate in double precision as the largest tables are long
+        auto sum = 0.0;
+        auto sumOfSquares = 0.0;
+        for (auto i = 0; i < size; ++i)
+        {
+            const auto value = static_cast<double> (window.table[i]);
+            sum += value;
+            sumOfSquares += value * value;
+        }
+
+        window.amplitudeCorrectionFactor = static_cast<float> (2.0 / sum);
+        window.coherentGain = static_cast<float> (sum / size);
+        window.equivalentNoiseBandwidth = static_cast<float> (size * sumOfSquares / (sum * sum));
+    }
+}
+
+inline FftProcessor::FftProcessor(): FixedBlockProcessor (maxSize),
+                                     outputFrame (std::make_unique<FftFrame>()),
+                                     outputPhaseFrame (std::make_unique<PhaseFrame>())
+{
+    for (auto order = minOrder; order <= maxOrder; ++order)
+        plans.add (new Plan (order));
+
+    temp.setSize (1, maxSize * 2, false, true);
+    decimated.setSize (1, maxSize, false, true);
+
+    setFftOrder (defaultOrder);
+}
 
-    setWindowingMethod(dsp::WindowingFunction<float>::hann);
+inline FftProcessor::~FftProcessor()
+{
+    analysisThread.stopThread (1000);
 }
 
-template <int Order>
-void FftProcessor<Order>::prepare (const dsp::ProcessSpec& spec)
+inline void FftProcessor::prepare (const dsp::ProcessSpec& spec)
 {
+    // Stop the analysis thread while we reallocate everything it uses
+    analysisThread.stopThread (1000);
+
     FixedBlockProcessor::prepare (spec);
+    frameQueue.prepare (maxSize, jmin (static_cast<int> (spec.numChannels) * queueLengthPerChannel, jmax (32, static_cast<int> (spec.numChannels) * 2)));
 
-    amplitudeEnvelope.clear();
-    amplitudeEnvelope.setSize (spec.numChannels, size);
+    sampleRate = spec.sampleRate;
+    channelSlots.allocate (spec.numChannels, false);
 
+    // Drop the buffers, states & probes from the last run & allocate them for the current settings & analysed channels (the analysis
+    // thread reallocates them whenever the settings or the channel mask change after this)
+    amplitudeEnvelope.setSize (0, 0);
+    levelStates.clear();
+    levelHistory.setSize (0, 0);
+    levelFrames.setSize (0, 0);
+    powerSum.setSize (0, 0);
+    powerAverage.setSize (0, 0);
+    holdBuffers.setSize (0, 0);
     freqProbes.clear();
     phaseProbes.clear();
+    holdProbes.clear();
+    allocation = Allocation();
+    reallocate (getRequiredAllocation (1 << fftOrder.get()));
+
+    notificationProbe = std::make_unique<AudioProbe<int>>();
+    analysisLoad.set (0.0f);
+
+    analysisThread.startThread();
+}
 
-    // Add probes for each channel to transfer audio data to the GUI
-    for (auto ch = 0; ch < static_cast<int> (spec.numChannels); ++ch)
+inline void FftProcessor::performProcessing (const int channel)
+{
+    // The analysis thread polls the queue (see FrameQueue::getConsumerPollInterval). The hop size is passed with the frame, as the
+    // block size it depends on is changed by the audio thread.
+    frameQueue.push (getBlockReadPointer (channel), getCurrentBlockSize(), channel, getHopSize());
+}
+
+inline float FftProcessor::getAnalysisLoad() const
+{
+    return analysisLoad.get();
+}
+
+inline int FftProcessor::getNumDroppedFrames() const
+{
+    return frameQueue.getNumDroppedFrames();
+}
+
+inline void FftProcessor::AnalysisThread::run()
+{
+    // The load is the proportion of the time spent analysing, measured over periods of about half a second
+    const auto ticksPerPeriod = Time::getHighResolutionTicksPerSecond() / 2;
+    auto periodStart = Time::getHighResolutionTicks();
+    int64 busyTicks = 0;
+
+    auto lastFrameTime = Time::getMillisecondCounter();
+
+    while (!threadShouldExit())
     {
-        freqProbes.add(new AudioProbe<FftFrame>());
-        phaseProbes.add (new AudioProbe<FftFrame>());
+        auto channel = 0;
+        auto numSamples = 0;
+        auto hopSize = 0;
+        while (fftProcessor.frameQueue.pop (fftProcessor.temp.getWritePointer (0), numSamples, channel, hopSize))
+        {
+            lastFrameTime = Time::getMillisecondCounter();
+            const auto start = Time::getHighResolutionTicks();
+            fftProcessor.analyseFrame (channel, numSamples, hopSize);
+            busyTicks += Time::getHighResolutionTicks() - start;
+
+            // Notify listeners once every enabled channel of the block has been analysed
+            if (channel == fftProcessor.getLastEnabledChannel())
+            {
+                ++fftProcessor.numBlocksAnalysed;
+                fftProcessor.notificationProbe->writeFrame (&fftProcessor.numBlocksAnalysed);
+            }
+            if (threadShouldExit())
+                return;
+        }
+
+        const auto now = Time::getHighResolutionTicks();
+        if (now - periodStart >= ticksPerPeriod)
+        {
+            fftProcessor.analysisLoad.set (static_cast<float> (static_cast<double> (busyTicks) / static_cast<double> (now - periodStart)));
+            periodStart = now;
+            busyTicks = 0;
+        }
+        wait (FrameQueue::getConsumerPollInterval (lastFrameTime));
     }
 }
 
-template <int Order>
-void FftProcessor<Order>::performProcessing (const int channel)
+inline FftProcessor::Allocation FftProcessor::getRequiredAllocation (const int fftSize) const
 {
-    // Apply window to audio input
-    temp.copyFrom (0, 0, buffer.getReadPointer (channel), size);
-    FloatVectorOperations::multiply (temp.getWritePointer (0), window.getWritePointer (0), size);
+    Allocation required;
+    required.fftSize = fftSize;
+    required.numLevels = resolutionLevels.get();
+    required.averaging = averagingMode.get();
+    required.channelMask = getNumChannels() >= 64 ? getChannelMask() : getChannelMask() & ((uint64 (1) << getNumChannels()) - 1);
+    required.phase = phaseEnabled.get() && required.numLevels == 1; // Phase isn't computed in multi-resolution mode
+    required.hold = holdTracesEnabled.get();
+    required.envelope = amplitudeEnvelopeEnabled.get();
+    return required;
+}
 
-    // Perform FFT
-    fft.performFrequencyOnlyForwardTransform (temp.getWritePointer (0));
+inline void FftProcessor::reallocate (const Allocation& required)
+{
+    // Hold off new readers & wait for current ones to finish, as the probes may be replaced
+    isReallocating.store (true);
+    while (numReaders.load() > 0)
+        Thread::yield();
+
+    const auto numChannels = getNumChannels();
+    const auto numBins = getNumBins (required.fftSize, required.numLevels);
+    const auto layoutChanged = required.fftSize != allocation.fftSize || required.numLevels != allocation.numLevels;
+
+    // Only the analysed channels get a slot in the buffers & states (everything is fresh after prepare, which zeroes the FFT size)
+    const auto channelsChanged = required.channelMask != allocation.channelMask || allocation.fftSize == 0;
+    if (channelsChanged)
+    {
+        numSlots = 0;
+        for (auto ch = 0; ch < numChannels; ++ch)
+            channelSlots[ch] = ch < 64 && (required.channelMask & (uint64 (1) << ch)) != 0 ? numSlots++ : -1;
+
+        // The layouts are zeroed so that every slot starts afresh
+        amplitudeEnvelopeLayout.allocate (static_cast<size_t> (numSlots), true);
+        levelFramesLayout.allocate (static_cast<size_t> (numSlots), true);
+        averagingStates.allocate (static_cast<size_t> (numSlots), false);
+        holdStates.allocate (static_cast<size_t> (numSlots), false);
+        std::fill_n (averagingStates.getData(), numSlots, AveragingState());
+        std::fill_n (holdStates.getData(), numSlots, HoldState());
+    }
+
+    // A buffer is only reallocated (& cleared) if its size changes or its rows move to other channels, in which case the state computed
+    // from it must restart
+    const auto resize = [channelsChanged] (AudioSampleBuffer& buffer, const int numRows, const int numSamples)
+    {
+        if (!channelsChanged && buffer.getNumChannels() == numRows && buffer.getNumSamples() == numSamples)
+            return false;
+        buffer.setSize (numRows, numSamples);
+        buffer.clear();
+        return true;
+    };
 
-    // Correct amplitude
-    FloatVectorOperations::multiply (temp.getWritePointer (0), amplitudeCorrectionFactor, size);
+    if (resize (amplitudeEnvelope, required.envelope ? numSlots : 0, required.envelope ? numBins : 0))
+        std::fill_n (amplitudeEnvelopeLayout.getData(), numSlots, 0);
 
-    if (amplitudeEnvelopeEnabled.get())
+    // Each analysed channel has a history & a decimator for every level below the top one
+    const auto numDecimatedLevels = numSlots * (required.numLevels - 1);
+    if (channelsChanged || levelStates.size() != numDecimatedLevels)
     {
-        // Compute envelope on amplitude
-        FloatVectorOperations::addWithMultiply (temp.getWritePointer (0), amplitudeEnvelope.getWritePointer (channel), amplitudeReleaseConstant.get(), size);
-    
+        levelStates.clear();
+        for (auto i = 0; i < numDecimatedLevels; ++i)
+            levelStates.add (new LevelState());
+    }
+    resize (levelHistory, numDecimatedLevels, numDecimatedLevels > 0 ? required.fftSize : 0);
+    if (resize (levelFrames, numDecimatedLevels > 0 ? numSlots : 0, numDecimatedLevels > 0 ? numBins : 0))
+        std::fill_n (levelFramesLayout.getData(), numSlots, 0);
+
+    const auto linear = required.averaging == LinearAveraging;
+    const auto averaged = required.averaging != NoAveraging;
+    const auto sumResized = resize (powerSum, linear ? numSlots : 0, linear ? numBins : 0);
+    const auto averageResized = resize (powerAverage, averaged ? numSlots : 0, averaged ? numBins : 0);
+    if (sumResized || averageResized)
+        std::fill_n (averagingStates.getData(), numSlots, AveragingState());
+
+    if (resize (holdBuffers, required.hold ? numSlots * holdRowsPerChannel : 0, required.hold ? numBins : 0))
+        std::fill_n (holdStates.getData(), numSlots, HoldState());
+
+    // Each probe only holds the header & the bins of the layout. The probes are indexed by channel, with none for channels that
+    // aren't analysed.
+    const auto frameBytes = offsetof (FftFrame, f) + sizeof (float) * static_cast<size_t> (numBins);
+    if (layoutChanged || channelsChanged || freqProbes.size() != numChannels)
+    {
+        freqProbes.clear();
+        for (auto ch = 0; ch < numChannels; ++ch)
+            freqProbes.add (channelSlots[ch] >= 0 ? new AudioProbe<FftFrame> (AudioProbe<FftFrame>::defaultQueueLength, frameBytes) : nullptr);
+    }
+    const auto numPhaseProbes = required.phase ? numChannels : 0;
+    if (layoutChanged || channelsChanged || phaseProbes.size() != numPhaseProbes)
+    {
+        phaseProbes.clear();
+        for (auto ch = 0; ch < numPhaseProbes; ++ch)
+            phaseProbes.add (channelSlots[ch] >= 0 ? new AudioProbe<PhaseFrame> (AudioProbe<PhaseFrame>::defaultQueueLength, offsetof (PhaseFrame, f) + sizeof (float) * static_cast<size_t> (required.fftSize + 2))
+                                                   : nullptr);
+    }
+    const auto numHoldProbes = required.hold ? numChannels * numHoldTraces : 0;
+    if (layoutChanged || channelsChanged || holdProbes.size() != numHoldProbes)
+    {
+        holdProbes.clear();
+        for (auto i = 0; i < numHoldProbes; ++i)
+            holdProbes.add (channelSlots[i / numHoldTraces] >= 0 ? new AudioProbe<FftFrame> (AudioProbe<FftFrame>::defaultQueueLength, frameBytes) : nullptr);
+    }
+
+    allocation = required;
+    isReallocating.store (false);
+}
+
+inline void FftProcessor::analyseFrame (const int channel, const int numSamples, const int hopSize)
+{
+    const auto order = roundToInt (std::log2 (numSamples));
+    jassert (order >= minOrder && order <= maxOrder && (1 << order) == numSamples);
+    auto* plan = plans[order - minOrder];
+    if (plan == nullptr)
+        return;
+
+    // Everything below follows the allocation rather than the settings, which may change at any time
+    const auto required = getRequiredAllocation (plan->size);
+    if (required != allocation)
+        reallocate (required);
+
+    // Frames of a channel that has just been masked out may still be queued
+    const auto slot = channelSlots[channel];
+    if (slot < 0)
+        return;
+
+    const auto size = plan->size;
+    const auto numLevels = allocation.numLevels;
+    const auto numBins = getNumBins (size, numLevels);
+    const auto layout = getLayout (size, numLevels);
+    const auto hop = jlimit (1, size, hopSize);
+    const auto windowIndex = windowingMethod.get();
+    const auto& window = plan->windows[windowIndex];
+    auto* data = temp.getWritePointer (0);
+
+    // Output power directly if it's going to be averaged or converted to PSD (otherwise each bin would be square rooted & squared again)
+    auto isPower = false;
+
+    if (numLevels == 1)
+    {
+        if (allocation.phase)
+        {
+            computeAmplitudesAndPhase (data, *outputPhaseFrame, *plan, window, sampleRate);
+            outputPhaseFrame->fftSize = size;
+            phaseProbes[channel]->writeFrame (outputPhaseFrame.get(), offsetof (PhaseFrame, f) + sizeof (float) * static_cast<size_t> (numBins * 2));
+        }
+        else
+        {
+            isPower = allocation.averaging != NoAveraging || psdEnabled.get();
+            computeAmplitudes (data, *plan, window, isPower);
+        }
+        levelFramesLayout[slot] = 0; // So the levels start afresh if multi-resolution mode is re-enabled
+    }
+    else
+    {
+        // The stitched frame holds the latest amplitudes of every level, so work on a copy of it
+        analyseLevels (slot, *plan, window, numLevels, hop);
+        FloatVectorOperations::copy (data, levelFrames.getReadPointer (slot), numBins);
+    }
+
+    applyAveraging (slot, data, *plan, windowIndex, numLevels, isPower, hop);
+
+    if (allocation.hold)
+        updateHoldTraces (channel, slot, data, size, numLevels, hop);
+
+    if (allocation.envelope)
+    {
+        // Restart the envelope if the FFT size or number of levels has changed
+        if (amplitudeEnvelopeLayout[slot] != layout)
+        {
+            amplitudeEnvelope.clear (slot, 0, numBins);
+            amplitudeEnvelopeLayout[slot] = layout;
+        }
+
+        // Compute a peak envelope with exponential release on amplitude, so the envelope never exceeds the peak amplitude (scaling the
+        // release constant so that the release time is independent of FFT size & overlap)
+        const auto releaseConstant = std::pow (amplitudeReleaseConstant.get(), static_cast<float> (hop) / static_cast<float> (1 << defaultOrder));
+        auto* envelope = amplitudeEnvelope.getWritePointer (slot);
+        FloatVectorOperations::multiply (envelope, releaseConstant, numBins);
+        FloatVectorOperations::max (data, data, envelope, numBins);
+
         // Store last audio frame in envelope buffer
-        amplitudeEnvelope.copyFrom (channel, 0, temp.getReadPointer (0), size);
+        amplitudeEnvelope.copyFrom (slot, 0, data, numBins);
+    }
+
+    // Write output frame (only copying the bins in use)
+    outputFrame->fftSize = size;
+    outputFrame->numLevels = numLevels;
+    FloatVectorOperations::copy (outputFrame->f, data, numBins);
+    freqProbes[channel]->writeFrame (outputFrame.get(), offsetof (FftFrame, f) + sizeof (float) * static_cast<size_t> (numBins));
+}
+
+inline void FftProcessor::computeAmplitudes (float* data, const Plan& plan, const Window& window, const bool outputPower)
+{
+    // Apply window to audio input
+    FloatVectorOperations::multiply (data, window.table.getData(), plan.size);
+
+    // Perform FFT (only the bins up to Nyquist are needed)
+    plan.fft.performRealOnlyForwardTransform (data, true);
+
+    // Square the real & imaginary parts & add each pair in place (which, unlike std::abs on each complex bin, is cheap & vectorises).
+    // Writing bin k only overwrites values that have already been read.
+    const auto numBins = plan.size / 2 + 1;
+    FloatVectorOperations::multiply (data, data, numBins * 2);
+    for (auto k = 0; k < numBins; ++k)
+        data[k] = data[2 * k] + data[2 * k + 1];
+
+    // Correct amplitude (the mean square of a sine is half its peak squared)
+    const auto correction = window.amplitudeCorrectionFactor;
+    if (outputPower)
+    {
+        FloatVectorOperations::multiply (data, 0.5f * correction * correction, numBins);
+    }
+    else
+    {
+        for (auto k = 0; k < numBins; ++k)
+            data[k] = std::sqrt (data[k]);
+        FloatVectorOperations::multiply (data, correction, numBins);
+    }
+}
+
+inline void FftProcessor::computeAmplitudesAndPhase (float* data, PhaseFrame& phaseFrame, const Plan& plan, const Window& window, const double sampleRate)
+{
+    const auto size = plan.size;
+    const auto numBins = size / 2 + 1;
+    auto* phase = phaseFrame.f;
+    auto* groupDelay = phaseFrame.f + numBins;
+
+    // Apply window to audio input & perform FFT (the output is interleaved real & imaginary parts from DC to Nyquist)
+    FloatVectorOperations::multiply (data, window.table.getData(), size);
+    plan.fft.performRealOnlyForwardTransform (data, true);
+
+    // Magnitude & phase in a single pass. Each magnitude overwrites the real part of an earlier bin, which has already been read.
+    // Phase is measured from the centre of the window (a shift of half the frame, which negates every odd bin) & unwrapped by choosing
+    // the multiple of 2 pi that keeps each bin closest to the one before.
+    auto previous = 0.0f;
+    for (auto k = 0; k < numBins; ++k)
+    {
+        const auto sign = (k & 1) != 0 ? -1.0f : 1.0f;
+        const auto re = data[2 * k] * sign;
+        const auto im = data[2 * k + 1] * sign;
+        data[k] = std::sqrt (re * re + im * im) * window.amplitudeCorrectionFactor;
+        const auto wrapped = std::atan2 (im, re);
+        previous = wrapped + MathConstants<float>::twoPi * std::round ((previous - wrapped) / MathConstants<float>::twoPi);
+        phase[k] = previous;
+    }
+
+    // Group delay is the negative slope of the phase against angular frequency (using central differences inside the band)
+    const auto secondsPerRadianPerBin = static_cast<float> (static_cast<double> (size) / (MathConstants<double>::twoPi * sampleRate));
+    groupDelay[0] = (phase[0] - phase[1]) * secondsPerRadianPerBin;
+    for (auto k = 1; k < numBins - 1; ++k)
+        groupDelay[k] = (phase[k - 1] - phase[k + 1]) * 0.5f * secondsPerRadianPerBin;
+    groupDelay[numBins - 1] = (phase[numBins - 2] - phase[numBins - 1]) * secondsPerRadianPerBin;
+}
+
+inline void FftProcessor::analyseLevels (const int slot, const Plan& plan, const Window& window, const int numLevels, const int hop)
+{
+    const auto size = plan.size;
+    auto* data = temp.getWritePointer (0);
+    auto* samples = decimated.getWritePointer (0);
+    auto* stitched = levelFrames.getWritePointer (slot);
+
+    // Start the levels afresh if the layout has changed (feeding them the whole frame rather than just the samples that are new since
+    // the last frame). Dropped frames aren't detected, so they will cause a brief discontinuity in the decimated levels.
+    auto numNewSamples = hop;
+    const auto layout = getLayout (size, numLevels);
+    if (levelFramesLayout[slot] != layout)
+    {
+        for (auto level = 1; level < numLevels; ++level)
+        {
+            auto* state = levelStates[slot * (numLevels - 1) + level - 1];
+            state->decimator.reset();
+            state->writeIndex = 0;
+            state->numSamples = 0;
+            state->samplesSinceLastFrame = 0;
+        }
+        FloatVectorOperations::clear (stitched, getNumBins (size, numLevels));
+        levelFramesLayout[slot] = layout;
+        numNewSamples = size;
+    }
+    FloatVectorOperations::copy (samples, data + size - numNewSamples, numNewSamples);
+
+    // The top level is the undecimated frame, which is stitched in last as it covers the highest frequencies
+    auto offset = getNumBins (size, numLevels);
+    const auto stitchLevel = [&] (const int level)
+    {
+        const auto bins = getLevelBins (size, numLevels, level);
+        offset -= bins.getLength();
+        FloatVectorOperations::copy (stitched + offset, data + bins.getStart(), bins.getLength());
+    };
+    computeAmplitudes (data, plan, window, false);
+    stitchLevel (0);
+
+    for (auto level = 1; level < numLevels; ++level)
+    {
+        // Decimate the samples from the level above in place & append them to this level's history
+        const auto index = slot * (numLevels - 1) + level - 1;
+        auto& state = *levelStates[index];
+        auto* history = levelHistory.getWritePointer (index);
+        numNewSamples = state.decimator.process (samples, numNewSamples, samples);
+
+        const auto firstPart = jmin (numNewSamples, size - state.writeIndex);
+        FloatVectorOperations::copy (history + state.writeIndex, samples, firstPart);
+        FloatVectorOperations::copy (history, samples + firstPart, numNewSamples - firstPart);
+        state.writeIndex = (state.writeIndex + numNewSamples) & (size - 1);
+        state.numSamples = jmin (size, state.numSamples + numNewSamples);
+        state.samplesSinceLastFrame += numNewSamples;
+
+        // Each level computes a frame every hop samples (at its own sample rate) once its history is full
+        if (state.numSamples == size && state.samplesSinceLastFrame >= hop)
+        {
+            state.samplesSinceLastFrame = 0;
+            FloatVectorOperations::copy (data, history + state.writeIndex, size - state.writeIndex);
+            FloatVectorOperations::copy (data + size - state.writeIndex, history, state.writeIndex);
+            computeAmplitudes (data, plan, window, false);
+            stitchLevel (level);
+        }
+        else
+        {
+            offset -= getLevelBins (size, numLevels, level).getLength();
+        }
+    }
+}
+
+inline void FftProcessor::applyAveraging (const int slot, float* data, const Plan& plan, const int windowIndex, const int numLevels, const bool isPower, const int hop)
+{
+    const auto averaging = allocation.averaging;
+    const auto psd = psdEnabled.get();
+    const auto size = plan.size;
+    const auto numBins = getNumBins (size, numLevels);
+    if (averaging == NoAveraging && !psd)
+    {
+        // The settings may have changed since the power was computed
+        if (isPower)
+            for (auto i = 0; i < numBins; ++i)
+                data[i] = std::sqrt (data[i] * 2.0f);
+        return;
+    }
+
+    const auto& window = plan.windows[windowIndex];
+
+    // Convert peak amplitude to power (mean square)
+    if (!isPower)
+    {
+        FloatVectorOperations::multiply (data, data, numBins);
+        FloatVectorOperations::multiply (data, 0.5f, numBins);
+    }
+
+    auto& state = averagingStates[slot];
+    if (state.fftSize != size || state.numLevels != numLevels || state.averaging != averaging || state.windowingMethod != windowIndex || state.generation != averagingGeneration.get())
+    {
+        state.fftSize = size;
+        state.numLevels = numLevels;
+        state.averaging = averaging;
+        state.windowingMethod = windowIndex;
+        state.generation = averagingGeneration.get();
+        state.numFrames = 0;
+        state.hasAverage = false;
+    }
+
+    if (averaging == LinearAveraging)
+    {
+        auto* sum = powerSum.getWritePointer (slot);
+        auto* average = powerAverage.getWritePointer (slot);
+        if (state.numFrames == 0)
+            FloatVectorOperations::copy (sum, data, numBins);
+        else
+            FloatVectorOperations::add (sum, data, numBins);
+        ++state.numFrames;
+
+        // Until the first block is complete, we output the average of the frames so far
+        const auto blockComplete = state.numFrames >= linearAveragingFrames.get();
+        if (blockComplete || !state.hasAverage)
+            FloatVectorOperations::multiply (average, sum, 1.0f / static_cast<float> (state.numFrames), numBins);
+        if (blockComplete)
+        {
+            state.numFrames = 0;
+            state.hasAverage = true;
+        }
+        FloatVectorOperations::copy (data, average, numBins);
+    }
+    else if (averaging == ExponentialAveraging)
+    {
+        auto* average = powerAverage.getWritePointer (slot);
+        if (state.hasAverage)
+        {
+            const auto alpha = static_cast<float> (1.0 - std::exp (-static_cast<double> (hop) / (static_cast<double> (exponentialAveragingTime.get()) * sampleRate)));
+            FloatVectorOperations::multiply (average, 1.0f - alpha, numBins);
+            FloatVectorOperations::addWithMultiply (average, data, alpha, numBins);
+        }
+        else
+        {
+            FloatVectorOperations::copy (average, data, numBins);
+            state.hasAverage = true;
+        }
+        FloatVectorOperations::copy (data, average, numBins);
+    }
+
+    // Convert power back to amplitude, or to PSD by dividing by the equivalent noise bandwidth of the window (in Hz). The bins of each
+    // decimated level are half the width of those of the level above, so the PSD scaling doubles with each level.
+    auto offset = numBins;
+    for (auto level = 0; level < numLevels; ++level)
+    {
+        const auto numLevelBins = getLevelBins (size, numLevels, level).getLength();
+        offset -= numLevelBins;
+        const auto binWidth = sampleRate / static_cast<double> (size << level);
+        const auto scale = psd ? static_cast<float> (1.0 / (static_cast<double> (window.equivalentNoiseBandwidth) * binWidth)) : 2.0f;
+        for (auto i = offset; i < offset + numLevelBins; ++i)
+            data[i] = std::sqrt (data[i] * scale);
+    }
+}
+
+inline void FftProcessor::updateHoldTraces (const int channel, const int slot, const float* data, const int fftSize, const int numLevels, const int hop)
+{
+    const auto numBins = getNumBins (fftSize, numLevels);
+    const auto layout = getLayout (fftSize, numLevels);
+    auto& state = holdStates[slot];
+    auto* peak = holdBuffers.getWritePointer (slot * holdRowsPerChannel + PeakHold);
+    auto* minimum = holdBuffers.getWritePointer (slot * holdRowsPerChannel + MinHold);
+    auto* period = holdBuffers.getWritePointer (slot * holdRowsPerChannel + TimedHold);
+    auto* previousPeriod = holdBuffers.getWritePointer (slot * holdRowsPerChannel + numHoldTraces);
+    const auto generation = holdGeneration.get();
+    const auto psd = psdEnabled.get();
+
+    if (state.layout != layout || state.generation != generation || state.psd != psd)
+    {
+        // Restart every trace from this frame
+        FloatVectorOperations::copy (peak, data, numBins);
+        FloatVectorOperations::copy (minimum, data, numBins);
+        FloatVectorOperations::copy (period, data, numBins);
+        FloatVectorOperations::copy (previousPeriod, data, numBins);
+        state.layout = layout;
+        state.generation = generation;
+        state.psd = psd;
+        state.samplesInPeriod = 0;
+    }
+    else
+    {
+        FloatVectorOperations::max (peak, peak, data, numBins);
+        FloatVectorOperations::min (minimum, minimum, data, numBins);
+        FloatVectorOperations::max (period, period, data, numBins);
+    }
+
+    // Start a new period of the timed hold once the current one is complete (each frame advances by the hop size)
+    state.samplesInPeriod += hop;
+    if (state.samplesInPeriod >= roundToInt (holdTime.get() * sampleRate))
+    {
+        FloatVectorOperations::copy (previousPeriod, period, numBins);
+        FloatVectorOperations::copy (period, data, numBins);
+        state.samplesInPeriod = 0;
+    }
+
+    // Write each trace through the output frame (which is only used for the main output afterwards)
+    outputFrame->fftSize = fftSize;
+    outputFrame->numLevels = numLevels;
+    const auto frameBytes = offsetof (FftFrame, f) + sizeof (float) * static_cast<size_t> (numBins);
+    const auto firstProbe = channel * numHoldTraces;
+    FloatVectorOperations::copy (outputFrame->f, peak, numBins);
+    holdProbes.getUnchecked (firstProbe + PeakHold)->writeFrame (outputFrame.get(), frameBytes);
+    FloatVectorOperations::copy (outputFrame->f, minimum, numBins);
+    holdProbes.getUnchecked (firstProbe + MinHold)->writeFrame (outputFrame.get(), frameBytes);
+    FloatVectorOperations::max (outputFrame->f, period, previousPeriod, numBins);
+    holdProbes.getUnchecked (firstProbe + TimedHold)->writeFrame (outputFrame.get(), frameBytes);
+}
+
+inline int FftProcessor::copyFrequencyFrame (FftFrame& dest, const int channel) const
+{
+    // Copy the header first to find out how many bins are in use
+    const ProbeReader reader (*this);
+    auto* probe = freqProbes[channel];
+    if (!reader.isValid() || probe == nullptr)
+        return 0;
+    probe->copyFrame (&dest, offsetof (FftFrame, f));
+    const auto fftSize = dest.fftSize;
+    const auto numLevels = dest.numLevels;
+    if (fftSize <= 0 || fftSize > maxSize || numLevels < 1 || numLevels > maxResolutionLevels)
+        return 0;
+
+    const auto numBins = getNumBins (fftSize, numLevels);
+    probe->copyFrame (&dest, offsetof (FftFrame, f) + sizeof (float) * static_cast<size_t> (numBins));
+
+    // If the layout changed between the two copies then the frame may be incomplete
+    return dest.fftSize == fftSize && dest.numLevels == numLevels ? numBins : 0;
+}
+
+inline FftProcessor::FrameLease::FrameLease (const FftProcessor& processorToRead, const int channel)
+    : fftProcessor (processorToRead)
+{
+    fftProcessor.numReaders.fetch_add (1);
+    if (fftProcessor.isReallocating.load())
+        return;
+    auto* probe = fftProcessor.freqProbes[channel];
+    if (probe == nullptr)
+        return;
+
+    lease = probe->leaseFrame();
+    if (lease->fftSize <= 0 || lease->fftSize > maxSize || lease->numLevels < 1 || lease->numLevels > maxResolutionLevels)
+        lease.release();
+}
+
+inline FftProcessor::FrameLease::~FrameLease()
+{
+    // The frame must be released before the probe can be replaced
+    lease.release();
+    fftProcessor.numReaders.fetch_sub (1);
+}
+
+inline FftProcessor::FrameLease FftProcessor::leaseFrequencyFrame (const int channel) const
+{
+    return FrameLease (*this, channel);
+}
+
+inline FftProcessor::ProbeReader::ProbeReader (const FftProcessor& processorToRead)
+    : fftProcessor (processorToRead)
+{
+    fftProcessor.numReaders.fetch_add (1);
+    valid = !fftProcessor.isReallocating.load();
+}
+
+inline FftProcessor::ProbeReader::~ProbeReader()
+{
+    fftProcessor.numReaders.fetch_sub (1);
+}
+
+inline int FftProcessor::copyPhaseFrame (PhaseFrame& dest, const int channel) const
+{
+    // Copy the header first to find out how many bins are in use
+    const ProbeReader reader (*this);
+    auto* probe = phaseProbes[channel];
+    if (!reader.isValid() || probe == nullptr)
+        return 0;
+    probe->copyFrame (&dest, offsetof (PhaseFrame, f));
+    const auto fftSize = dest.fftSize;
+    if (fftSize <= 0 || fftSize > maxSize)
+        return 0;
+
+    const auto numBins = fftSize / 2 + 1;
+    probe->copyFrame (&dest, offsetof (PhaseFrame, f) + sizeof (float) * static_cast<size_t> (numBins * 2));
+
+    // If the size changed between the two copies then the frame may be incomplete
+    return dest.fftSize == fftSize ? numBins : 0;
+}
+
+inline int FftProcessor::copyHoldFrame (FftFrame& dest, const int channel, const HoldTrace trace) const
+{
+    jassert (trace >= PeakHold && trace < numHoldTraces);
+
+    // Copy the header first to find out how many bins are in use
+    const ProbeReader reader (*this);
+    auto* probe = holdProbes[channel * numHoldTraces + trace];
+    if (!reader.isValid() || probe == nullptr)
+        return 0;
+    probe->copyFrame (&dest, offsetof (FftFrame, f));
+    const auto fftSize = dest.fftSize;
+    const auto numLevels = dest.numLevels;
+    if (fftSize <= 0 || fftSize > maxSize || numLevels < 1 || numLevels > maxResolutionLevels)
+        return 0;
+
+    const auto numBins = getNumBins (fftSize, numLevels);
+    probe->copyFrame (&dest, offsetof (FftFrame, f) + sizeof (float) * static_cast<size_t> (numBins));
+
+    // If the layout changed between the two copies then the frame may be incomplete
+    return dest.fftSize == fftSize && dest.numLevels == numLevels ? numBins : 0;
+}
+
+inline void FftProcessor::setHoldTracesEnabled (const bool shouldKeepHoldTraces)
+{
+    if (shouldKeepHoldTraces && !holdTracesEnabled.get())
+        resetHoldTraces();
+    holdTracesEnabled.set (shouldKeepHoldTraces);
+}
+
+inline bool FftProcessor::areHoldTracesEnabled() const
+{
+    return holdTracesEnabled.get();
+}
+
+inline void FftProcessor::setHoldTime (const float holdTimeInSeconds)
+{
+    jassert (holdTimeInSeconds > 0.0f);
+    holdTime.set (jmax (0.01f, holdTimeInSeconds));
+}
+
+inline float FftProcessor::getHoldTime() const
+{
+    return holdTime.get();
+}
+
+inline void FftProcessor::resetHoldTraces()
+{
+    holdGeneration.set (holdGeneration.get() + 1);
+}
+
+inline void FftProcessor::setPhaseEnabled (const bool shouldComputePhase)
+{
+    phaseEnabled.set (shouldComputePhase);
+}
+
+inline bool FftProcessor::isPhaseEnabled() const
+{
+    return phaseEnabled.get();
+}
+
+inline void FftProcessor::setFftOrder (const int order)
+{
+    jassert (order >= minOrder && order <= maxOrder);
+    fftOrder.set (jlimit (minOrder, maxOrder, order));
+    requestCurrentBlockSize (1 << fftOrder.get());
+    updateHopSize();
+}
+
+inline int FftProcessor::getFftOrder() const
+{
+    return fftOrder.get();
+}
+
+inline void FftProcessor::setResolutionLevels (const int numLevels)
+{
+    jassert (numLevels >= 1 && numLevels <= maxResolutionLevels);
+    resolutionLevels.set (jlimit (1, maxResolutionLevels, numLevels));
+}
+
+inline int FftProcessor::getResolutionLevels() const
+{
+    return resolutionLevels.get();
+}
+
+inline int FftProcessor::getAnalysisLength() const
+{
+    return (1 << fftOrder.get()) << (resolutionLevels.get() - 1);
+}
+
+inline int FftProcessor::getNumBins (const int fftSize, const int numLevels)
+{
+    auto numBins = 0;
+    for (auto level = 0; level < numLevels; ++level)
+        numBins += getLevelBins (fftSize, numLevels, level).getLength();
+    return numBins;
+}
+
+inline void FftProcessor::getBinFrequencies (float* dest, const int fftSize, const int numLevels, const double sampleRate)
+{
+    // Bins are stitched in ascending frequency order, so the deepest level comes first
+    for (auto level = numLevels - 1; level >= 0; --level)
+    {
+        const auto bins = getLevelBins (fftSize, numLevels, level);
+        const auto binToHz = sampleRate / static_cast<double> (fftSize << level);
+        for (auto k = bins.getStart(); k < bins.getEnd(); ++k)
+            *dest++ = static_cast<float> (k * binToHz);
     }
+}
 
-    // Write output frames
-    freqProbes[channel]->writeFrame (reinterpret_cast<const FftFrame*> (temp.getReadPointer (0)));
-    phaseProbes[channel]->writeFrame (reinterpret_cast<const FftFrame*> (temp.getReadPointer (0) + size));
+inline Range<int> FftProcessor::getLevelBins (const int fftSize, const int numLevels, const int level)
+{
+    jassert (level >= 0 && level < numLevels);
+    if (numLevels == 1)
+        return { 0, fftSize / 2 + 1 };
+
+    // Each decimated level contributes the octave from an eighth to a quarter of its sample rate (where the decimators are flat & free
+    // of aliasing), except that the deepest level also covers everything below & the top level covers everything above
+    const auto start = level == numLevels - 1 ? 0 : fftSize / 8;
+    const auto end = level == 0 ? fftSize / 2 + 1 : fftSize / 4;
+    return { start, end };
+}
+
+inline int FftProcessor::getLayout (const int fftSize, const int numLevels)
+{
+    return fftSize * (maxResolutionLevels + 1) + numLevels;
+}
+
+inline void FftProcessor::setWindowingMethod (const dsp::WindowingFunction<float>::WindowingMethod method)
+{
+    jassert (method >= 0 && method < numWindows);
+    windowingMethod.set (jlimit (0, numWindows - 1, static_cast<int> (method)));
+}
+
+inline dsp::WindowingFunction<float>::WindowingMethod FftProcessor::getWindowingMethod() const
+{
+    return static_cast<dsp::WindowingFunction<float>::WindowingMethod> (windowingMethod.get());
+}
+
+inline float FftProcessor::getWindowCoherentGain() const
+{
+    return plans[getFftOrder() - minOrder]->windows[windowingMethod.get()].coherentGain;
+}
+
+inline float FftProcessor::getWindowEquivalentNoiseBandwidth() const
+{
+    return plans[getFftOrder() - minOrder]->windows[windowingMethod.get()].equivalentNoiseBandwidth;
+}
+
+inline void FftProcessor::setOverlap (const Overlap newOverlap)
+{
+    jassert (newOverlap >= None && newOverlap <= SevenEighths);
+    overlap.set (jlimit (static_cast<int> (None), static_cast<int> (SevenEighths), static_cast<int> (newOverlap)));
+    updateHopSize();
+}
+
+inline FftProcessor::Overlap FftProcessor::getOverlap() const
+{
+    return static_cast<Overlap> (overlap.get());
+}
+
+inline void FftProcessor::updateHopSize()
+{
+    setHopSize ((1 << fftOrder.get()) >> (overlap.get() - 1));
 }
 
-template <int Order>
-void FftProcessor<Order>::copyFrequencyFrame (float* dest, const int channel) const
+inline void FftProcessor::setAveraging (const Averaging averaging)
 {
-    freqProbes[channel]->copyFrame(reinterpret_cast<FftFrame*>(dest));
+    jassert (averaging >= NoAveraging && averaging <= ExponentialAveraging);
+    averagingMode.set (jlimit (static_cast<int> (NoAveraging), static_cast<int> (ExponentialAveraging), static_cast<int> (averaging)));
 }
 
-template <int Order>
-void FftProcessor<Order>::copyPhaseFrame (float* dest, const int channel) const
+inline FftProcessor::Averaging FftProcessor::getAveraging() const
 {
-	phaseProbes[channel]->copyFrame (reinterpret_cast <FftFrame*> (dest));
+    return static_cast<Averaging> (averagingMode.get());
 }
 
-template <int Order>
-void FftProcessor<Order>::setWindowingMethod (dsp::WindowingFunction<float>::WindowingMethod)
+inline void FftProcessor::setLinearAveragingFrames (const int numFrames)
 {
-    const auto windowType = dsp::WindowingFunction<float>::hann;
-    dsp::WindowingFunction<float>::fillWindowingTables (window.getWritePointer (0), static_cast<size_t> (size), windowType);
+    jassert (numFrames > 0);
+    linearAveragingFrames.set (jmax (1, numFrames));
+}
 
-    auto windowIntegral = 0.0f;
-    for (auto i = 0; i < size; ++i)
-        windowIntegral += window.getWritePointer(0)[i];
+inline int FftProcessor::getLinearAveragingFrames() const
+{
+    return linearAveragingFrames.get();
+}
+
+inline void FftProcessor::setExponentialAveragingTime (const float timeConstantInSeconds)
+{
+    jassert (timeConstantInSeconds > 0.0f);
+    exponentialAveragingTime.set (jmax (0.001f, timeConstantInSeconds));
+}
 
-    amplitudeCorrectionFactor = 2.0f / windowIntegral;
+inline float FftProcessor::getExponentialAveragingTime() const
+{
+    return exponentialAveragingTime.get();
+}
+
+inline void FftProcessor::resetAveraging()
+{
+    averagingGeneration.set (averagingGeneration.get() + 1);
+}
+
+inline void FftProcessor::setPowerSpectralDensityEnabled (const bool shouldOutputPsd)
+{
+    psdEnabled.set (shouldOutputPsd);
+}
+
+inline bool FftProcessor::isPowerSpectralDensityEnabled() const
+{
+    return psdEnabled.get();
 }
 
-template<int Order>
-inline void FftProcessor<Order>::setAmplitudeEnvelopeEnabled(const bool shouldBeEnabled)
+inline void FftProcessor::setAmplitudeEnvelopeEnabled(const bool shouldBeEnabled)
 {
     amplitudeEnvelopeEnabled.set(shouldBeEnabled);
 }
 
-template<int Order>
-inline bool FftProcessor<Order>::isAmplitudeEnvelopeEnabled() const
+inline bool FftProcessor::isAmplitudeEnvelopeEnabled() const
 {
     return amplitudeEnvelopeEnabled.get();
 }
 
-template<int Order>
-inline void FftProcessor<Order>::setAmplitudeEnvelopeReleaseConstant(const float releaseConstant)
+inline void FftProcessor::setAmplitudeEnvelopeReleaseConstant(const float releaseConstant)
 {
     amplitudeReleaseConstant.set (releaseConstant);
 }
 
-template<int Order>
-inline float FftProcessor<Order>::getAmplitudeEnvelopeReleaseConstant() const
+inline float FftProcessor::getAmplitudeEnvelopeReleaseConstant() const
 {
     return amplitudeReleaseConstant.get();
 }
 
-template <int Order>
-ListenerRemovalCallback FftProcessor<Order>::addListenerCallback (ListenerCallback&& listenerCallback) const
+inline ListenerRemovalCallback FftProcessor::addListenerCallback (ListenerCallback&& listenerCallback) const
 {
     // If this asserts then you're trying to add the listener before the AudioProbes are set up
     jassert (getNumChannels()>0);
 
-    if (phaseProbes.size() == getNumChannels() && phaseProbes[getNumChannels() - 1])
-        return phaseProbes[getNumChannels() - 1]->addListenerCallback(std::forward<ListenerCallback>(listenerCallback));
+    if (notificationProbe != nullptr)
+        return notificationProbe->addListenerCallback(std::forward<ListenerCallback>(listenerCallback));
 
     return {};
 }
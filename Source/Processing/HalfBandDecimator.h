@@ -0,0 +1,106 @@
+/*
+  ==============================================================================
+
+    HalfBandDecimator.h
+    Created: 18 Oct 2026 1:25:42pm
+    Author:  Andrew
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+
+/**
+	Single channel FIR half-band filter that decimates by a factor of 2. Stages can be cascaded to analyse successively lower octaves.
+
+	The filter is a Kaiser windowed sinc with a -6dB point at a quarter of the input sample rate. It is designed for spectrum analysis
+	where only the lower half of the decimated band is used: it is flat to within 0.001dB up to an eighth of the input sample rate and
+	rejects everything that would alias into that region by more than 80dB.
+
+	Only the centre tap and the odd taps are non-zero (as for any half-band filter), so each output sample costs just 9 multiplies.
+*/
+class HalfBandDecimator final
+{
+public:
+    static constexpr int numTaps = 31;
+    static constexpr int centreTap = numTaps / 2;
+    static constexpr int numOddTaps = (centreTap + 1) / 2;
+
+    HalfBandDecimator()
+    {
+        float window [numTaps];
+        dsp::WindowingFunction<float>::fillWindowingTables (window, numTaps, dsp::WindowingFunction<float>::kaiser, false, 8.0f);
+
+        // Windowed sinc with a cutoff at a quarter of the sample rate (the even taps either side of the centre are zero)
+        float taps [numTaps];
+        auto sum = 0.0f;
+        for (auto i = 0; i < numTaps; ++i)
+        {
+            const auto n = static_cast<float> (i - centreTap);
+            const auto sinc = i == centreTap ? 1.0f : std::sin (MathConstants<float>::halfPi * n) / (MathConstants<float>::halfPi * n);
+            taps[i] = 0.5f * sinc * window[i];
+            sum += taps[i];
+        }
+
+        // Normalise for unity gain at DC
+        centreCoefficient = taps[centreTap] / sum;
+        for (auto k = 0; k < numOddTaps; ++k)
+            oddCoefficients[k] = taps[centreTap + 2 * k + 1] / sum;
+
+        reset();
+    }
+
+    ~HalfBandDecimator() = default;
+
+    /** Clears the filter history. */
+    void reset()
+    {
+        zeromem (history, sizeof (history));
+        writeIndex = 0;
+        phase = 0;
+    }
+
+    /** Filters & decimates numInput samples, writing the output to dest & returning the number of output samples written (which is
+     *  numInput / 2, give or take one depending on the phase left over from the previous call). The output may overwrite the input. */
+    int process (const float* input, const int numInput, float* dest)
+    {
+        auto numOutput = 0;
+        for (auto i = 0; i < numInput; ++i)
+        {
+            // Write each sample twice so that the most recent numTaps samples are always contiguous
+            history[writeIndex] = input[i];
+            history[writeIndex + numTaps] = input[i];
+            if (++writeIndex == numTaps)
+                writeIndex = 0;
+
+            phase ^= 1;
+            if (phase != 0)
+                continue;
+
+            // The filter is symmetric, so add each pair of samples that share a coefficient first
+            const auto* x = history + writeIndex + centreTap;
+            auto y = centreCoefficient * x[0];
+            for (auto k = 0; k < numOddTaps; ++k)
+                y += oddCoefficients[k] * (x[2 * k + 1] + x[-2 * k - 1]);
+            dest[numOutput++] = y;
+        }
+        return numOutput;
+    }
+
+private:
+
+    float centreCoefficient = 0.5f;
+    float oddCoefficients [numOddTaps] = {};
+    float history [numTaps * 2] = {};
+    int writeIndex = 0;
+    int phase = 0;
+
+public:
+    // Declare non-copyable, non-movable
+    HalfBandDecimator (const HalfBandDecimator&) = delete;
+    HalfBandDecimator& operator= (const HalfBandDecimator&) = delete;
+    HalfBandDecimator (HalfBandDecimator&& other) = delete;
+    HalfBandDecimator& operator= (HalfBandDecimator&& other) = delete;
+};
@@ -0,0 +1,308 @@
+/*
+  ==============================================================================
+
+    HarmonicAnalyser.h
+    Created: 18 Oct 2026 1:30:34pm
+    Author:  Andrew
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "AudioDataTransfer.h"
+
+/**
+	Measures the distortion & noise of a signal that is known to be a sine wave of a particular frequency (i.e. the synthesis source
+	used as a stimulus). Set the stimulus frequency with setStimulusFrequency - nothing is measured while it is zero.
+
+	Like FftProcessor, this collects fixed size blocks on the audio thread & pushes them through a FrameQueue to a worker thread.
+	The worker computes a Blackman-Harris windowed power spectrum of each block & averages it with the previous blocks, so the
+	results become steadier the longer the stimulus is held. The fundamental & harmonics are located directly from the stimulus
+	frequency (rather than by searching for peaks) and the power of each is measured by summing the bins in its main lobe, which
+	avoids scalloping loss when the frequency falls between bins.
+
+	The results are written to an AudioProbe per channel after every block, so they can be displayed while listening.
+*/
+class HarmonicAnalyser final : public FixedBlockProcessor
+{
+public:
+
+    static constexpr int fftOrder = 15;                 // 32768 point FFT (about 0.3Hz resolution at 48kHz before windowing)
+    static constexpr int fftSize = 1 << fftOrder;
+    static constexpr int numBins = fftSize / 2 + 1;
+    static constexpr int maxHarmonics = 10;             // Including the fundamental
+    static constexpr int mainLobeHalfWidth = 5;         // In bins (the 4-term Blackman-Harris main lobe is +/-4 bins wide)
+    static constexpr int numAveragingFrames = 8;        // Frames are averaged linearly until this many have been collected, then exponentially
+
+    /** The results of a measurement. This is necessary for us to use the AudioProbe class. */
+    struct Measurement final
+    {
+        double fundamentalFrequency;        // Stimulus frequency the measurement was made at (0 if no measurement has been made)
+        float fundamentalLevel;             // dBFS (i.e. relative to a full scale sine)
+        float thd;                          // Total harmonic distortion (ratio of harmonic amplitude to fundamental amplitude)
+        float thdPlusNoise;                 // Total harmonic distortion plus noise (ratio of residual amplitude to fundamental amplitude)
+        float snr;                          // Signal to noise ratio (dB, where noise excludes the harmonics)
+        float sinad;                        // Signal to noise and distortion ratio (dB)
+        int numHarmonics;                   // Number of harmonics below Nyquist (including the fundamental)
+        float harmonicLevels [maxHarmonics];// dB relative to the fundamental (so the first is always 0dB)
+        int numFramesAveraged;
+    };
+
+    explicit HarmonicAnalyser();
+    ~HarmonicAnalyser() override;
+
+    /** Note that this clears then sets AudioProbes per channel - so it must be called before any attached classes attempt to add listeners to the AudioProbes.
+     *  This also (re)starts the analysis thread. */
+    void prepare (const dsp::ProcessSpec& spec) override;
+
+    /** Called on the audio thread - this just queues the block for the analysis thread. */
+    void performProcessing (const int channel) override;
+
+    /** Sets the frequency of the sine used as the stimulus (or 0 if the stimulus isn't a steady sine). Averaging restarts whenever
+     *  this changes. This is safe to call from the audio thread. */
+    void setStimulusFrequency (const double frequencyInHz);
+
+    /** Gets the frequency of the sine used as the stimulus. */
+    double getStimulusFrequency() const;
+
+    /** Copies the latest measurement for a channel. Returns false if no valid measurement was available. */
+    bool copyMeasurement (Measurement& dest, const int channel) const;
+
+    /** Allows a listener to add a lambda function as a callback to the AudioProbe assigned to the last channel.
+     *  Listener callbacks are cleared each time prepare() is called on this class, so they must be added after this.
+     *
+     *  Returns a function which allows the listener to de-register it's callback. The listener must remove any references
+     *  to de-register functions that have become invalid.
+     */
+    ListenerRemovalCallback addListenerCallback (ListenerCallback&& listenerCallback) const;
+
+private:
+
+    /** Worker thread which analyses frames as they arrive in the queue. */
+    class AnalysisThread final : public Thread
+    {
+    public:
+        explicit AnalysisThread (HarmonicAnalyser& owner) : Thread ("Harmonic analysis"), harmonicAnalyser (owner) { }
+        void run() override;
+    private:
+        HarmonicAnalyser& harmonicAnalyser;
+        JUCE_DECLARE_NON_COPYABLE (AnalysisThread)
+    };
+
+    /** Averages the power spectrum of the frame held in temp & writes the measurement to the probe for the channel (called on the analysis thread). */
+    void analyseFrame (const int channel);
+
+    /** Returns the sum of the power spectrum over the main lobe centred on the given bin (called on the analysis thread). */
+    static double sumMainLobe (const float* power, const double centreBin);
+
+    /** Number of frames per channel that can be queued for the analysis thread. */
+    static constexpr int queueLengthPerChannel = 4;
+
+    dsp::FFT fft;
+    HeapBlock<float> window;
+    double powerScale = 1.0; // Converts the sum of bins to mean square power (corrected for the window)
+	AudioSampleBuffer temp;
+    AudioSampleBuffer powerAverage;
+    HeapBlock<int> numFramesAveraged;
+    HeapBlock<double> averagedFrequency;
+    double sampleRate = 48000.0; // will be set correctly in prepare()
+    Atomic<double> stimulusFrequency = 0.0;
+
+    OwnedArray <AudioProbe <Measurement>> probes;
+
+    FrameQueue frameQueue;
+    AnalysisThread analysisThread { *this };
+};
+
+
+// ===========================================================================================
+//  Implementation
+// ===========================================================================================
+
+inline HarmonicAnalyser::HarmonicAnalyser(): FixedBlockProcessor (fftSize),
+                                             fft (fftOrder)
+{
+    window.allocate (fftSize, true);
+    dsp::WindowingFunction<float>::fillWindowingTables (window.getData(), fftSize, dsp::WindowingFunction<float>::blackmanHarris, false);
+
+    // A sine of amplitude A puts a total of N * sum (w^2) * A^2 / 4 into the bins of its (one-sided) main lobe & it has a mean square of
+    // A^2 / 2, so this scaling gives the mean square power of anything summed over bins
+    auto sumOfSquares = 0.0;
+    for (auto i = 0; i < fftSize; ++i)
+        sumOfSquares += static_cast<double> (window[i]) * static_cast<double> (window[i]);
+    powerScale = 2.0 / (static_cast<double> (fftSize) * sumOfSquares);
+
+    temp.setSize (1, fftSize * 2, false, true);
+
+    // Overlap frames by half, which is enough to recover what the window throws away
+    setHopSize (fftSize / 2);
+}
+
+inline HarmonicAnalyser::~HarmonicAnalyser()
+{
+    analysisThread.stopThread (1000);
+}
+
+inline void HarmonicAnalyser::prepare (const dsp::ProcessSpec& spec)
+{
+    // Stop the analysis thread while we reallocate everything it uses
+    analysisThread.stopThread (1000);
+
+    FixedBlockProcessor::prepare (spec);
+    frameQueue.prepare (fftSize, static_cast<int> (spec.numChannels) * queueLengthPerChannel);
+
+    sampleRate = spec.sampleRate;
+    powerAverage.setSize (static_cast<int> (spec.numChannels), numBins);
+    numFramesAveraged.allocate (spec.numChannels, true);
+    averagedFrequency.allocate (spec.numChannels, true);
+
+    probes.clear();
+
+    // Add probes for each channel to transfer measurements to the GUI
+    for (auto ch = 0; ch < static_cast<int> (spec.numChannels); ++ch)
+        probes.add (new AudioProbe<Measurement>());
+
+    analysisThread.startThread();
+}
+
+inline void HarmonicAnalyser::performProcessing (const int channel)
+{
+    // There's nothing to measure without a stimulus
+    if (stimulusFrequency.get() <= 0.0)
+        return;
+
+    // The analysis thread polls the queue (see FrameQueue::getConsumerPollInterval)
+    frameQueue.push (getBlockReadPointer (channel), getCurrentBlockSize(), channel);
+}
+
+inline void HarmonicAnalyser::setStimulusFrequency (const double frequencyInHz)
+{
+    stimulusFrequency.set (jmax (0.0, frequencyInHz));
+}
+
+inline double HarmonicAnalyser::getStimulusFrequency() const
+{
+    return stimulusFrequency.get();
+}
+
+inline void HarmonicAnalyser::AnalysisThread::run()
+{
+    auto lastFrameTime = Time::getMillisecondCounter();
+
+    while (!threadShouldExit())
+    {
+        auto channel = 0;
+        auto numSamples = 0;
+        while (harmonicAnalyser.frameQueue.pop (harmonicAnalyser.temp.getWritePointer (0), numSamples, channel))
+        {
+            lastFrameTime = Time::getMillisecondCounter();
+            jassert (numSamples == fftSize);
+            harmonicAnalyser.analyseFrame (channel);
+            if (threadShouldExit())
+                return;
+        }
+        wait (FrameQueue::getConsumerPollInterval (lastFrameTime));
+    }
+}
+
+inline void HarmonicAnalyser::analyseFrame (const int channel)
+{
+    // The fundamental must be clear of DC & have room for its main lobe between harmonics
+    const auto frequency = stimulusFrequency.get();
+    const auto binsPerHz = static_cast<double> (fftSize) / sampleRate;
+    const auto fundamentalBin = frequency * binsPerHz;
+    if (fundamentalBin < static_cast<double> (2 * mainLobeHalfWidth + 1) || fundamentalBin > static_cast<double> (numBins - mainLobeHalfWidth - 1))
+        return;
+
+    // Compute the power spectrum
+    auto* data = temp.getWritePointer (0);
+    FloatVectorOperations::multiply (data, window.getData(), fftSize);
+    fft.performFrequencyOnlyForwardTransform (data);
+    FloatVectorOperations::multiply (data, data, numBins);
+
+    // Average it with previous frames (restarting if the stimulus has changed)
+    auto* average = powerAverage.getWritePointer (channel);
+    if (averagedFrequency[channel] != frequency)
+    {
+        averagedFrequency[channel] = frequency;
+        numFramesAveraged[channel] = 0;
+    }
+    if (numFramesAveraged[channel] < numAveragingFrames)
+        ++numFramesAveraged[channel];
+    const auto alpha = 1.0f / static_cast<float> (numFramesAveraged[channel]);
+    if (numFramesAveraged[channel] == 1)
+        FloatVectorOperations::copy (average, data, numBins);
+    else
+    {
+        FloatVectorOperations::multiply (average, 1.0f - alpha, numBins);
+        FloatVectorOperations::addWithMultiply (average, data, alpha, numBins);
+    }
+
+    // Total power excludes DC (& the main lobe around it)
+    auto total = 0.0;
+    for (auto k = mainLobeHalfWidth + 1; k < numBins; ++k)
+        total += static_cast<double> (average[k]);
+
+    // Measure the fundamental & each harmonic that has room for its main lobe below Nyquist
+    Measurement measurement {};
+    double harmonicPower [maxHarmonics] {};
+    auto harmonics = 0.0;
+    for (auto h = 1; h <= maxHarmonics; ++h)
+    {
+        const auto centreBin = fundamentalBin * static_cast<double> (h);
+        if (centreBin > static_cast<double> (numBins - mainLobeHalfWidth - 1))
+            break;
+        harmonicPower[h - 1] = sumMainLobe (average, centreBin);
+        if (h > 1)
+            harmonics += harmonicPower[h - 1];
+        measurement.numHarmonics = h;
+    }
+
+    // Guard against silence (& against rounding pushing the residual below zero)
+    const auto tiny = 1.0e-30;
+    const auto fundamental = jmax (tiny, harmonicPower[0]);
+    const auto residual = jmax (tiny, total - fundamental);
+    const auto noise = jmax (tiny, residual - harmonics);
+
+    measurement.fundamentalFrequency = frequency;
+    measurement.fundamentalLevel = static_cast<float> (10.0 * std::log10 (2.0 * fundamental * powerScale));
+    measurement.thd = static_cast<float> (std::sqrt (harmonics / fundamental));
+    measurement.thdPlusNoise = static_cast<float> (std::sqrt (residual / fundamental));
+    measurement.snr = static_cast<float> (10.0 * std::log10 (fundamental / noise));
+    measurement.sinad = static_cast<float> (10.0 * std::log10 (jmax (total, fundamental) / residual));
+    for (auto h = 0; h < measurement.numHarmonics; ++h)
+        measurement.harmonicLevels[h] = static_cast<float> (10.0 * std::log10 (jmax (tiny, harmonicPower[h]) / fundamental));
+    measurement.numFramesAveraged = numFramesAveraged[channel];
+
+    probes[channel]->writeFrame (&measurement);
+}
+
+inline double HarmonicAnalyser::sumMainLobe (const float* power, const double centreBin)
+{
+    const auto centre = roundToInt (centreBin);
+    auto sum = 0.0;
+    for (auto k = centre - mainLobeHalfWidth; k <= centre + mainLobeHalfWidth; ++k)
+        sum += static_cast<double> (power[k]);
+    return sum;
+}
+
+inline bool HarmonicAnalyser::copyMeasurement (Measurement& dest, const int channel) const
+{
+    if (channel < 0 || channel >= probes.size())
+        return false;
+
+    probes[channel]->copyFrame (&dest);
+    return dest.fundamentalFrequency > 0.0 && dest.numHarmonics > 0;
+}
+
+inline ListenerRemovalCallback HarmonicAnalyser::addListenerCallback (ListenerCallback&& listenerCallback) const
+{
+    // If this asserts then you're trying to add the listener before the AudioProbes are set up
+    jassert (getNumChannels()>0);
+
+    if (probes.size() == getNumChannels() && probes[getNumChannels() - 1])
+        return probes[getNumChannels() - 1]->addListenerCallback(std::forward<ListenerCallback>(listenerCallback));
+
+    return {};
+}
@@ -11,23 +11,33 @@
 #include "ProcessorExamples.h"
 
 LpfExample::LpfExample()
-: ProcessorHarness (2)
+: SimdProcessorHarness (2)
 {
     init();
 }
-void LpfExample::prepare (const dsp::ProcessSpec & spec)
+void LpfExample::prepareProcessor (const dsp::ProcessSpec & spec)
 {
     numChannels = static_cast<int> (spec.numChannels);
     freqConversionFactor = MathConstants<double>::pi / spec.sampleRate;
     z1.allocate (numChannels, true);
     z2.allocate (numChannels, true);
+    const auto numGroups = (static_cast<size_t> (numChannels) + numLanes - 1) / numLanes;
+    simdZ1.assign (numGroups, SIMDFloat::expand (0.0f));
+    simdZ2.assign (numGroups, SIMDFloat::expand (0.0f));
 }
-void LpfExample::process (const dsp::ProcessContextReplacing<float>& context)
+void LpfExample::processScalar (const dsp::ProcessContextReplacing<float>& context)
 {
     jassert (context.getInputBlock().getNumChannels() == context.getOutputBlock().getNumChannels());
 
     calculateCoefficients();
 
+    // Filter in the same (single) precision as the SIMD path, so the two paths differ only in vectorisation
+    const auto fa0 = static_cast<float> (a0);
+    const auto fa1 = static_cast<float> (a1);
+    const auto fb1 = static_cast<float> (b1);
+    const auto fb2 = static_cast<float> (b2);
+    const auto gain = getControlValueAsFloat (1);
+
     for (size_t ch = 0; ch <context.getOutputBlock().getNumChannels(); ++ch)
     {
         auto* in = context.getInputBlock().getChannelPointer (ch);
@@ -35,14 +45,46 @@ void LpfExample::process (const dsp::ProcessContextReplacing<float>& context)
 
         for (size_t i = 0; i < context.getOutputBlock().getNumSamples(); i++)
         {
-            const auto sample = static_cast<double> (in[i]) * a0 + z1[ch];
-            z1[ch] = static_cast<double> (in[i]) * a1 + z2[ch] - b1 * sample;
-            z2[ch] = static_cast<double> (in[i]) * a0 - b2 * sample;
-            out[i] = static_cast<float> (sample * getControlValue (1));
+            const auto sample = in[i] * fa0 + z1[ch];
+            z1[ch] = in[i] * fa1 + z2[ch] - fb1 * sample;
+            z2[ch] = in[i] * fa0 - fb2 * sample;
+            out[i] = sample * gain;
         }
     }
 }
-void LpfExample::reset()
+void LpfExample::processSimd (const dsp::ProcessContextReplacing<SIMDFloat>& context)
+{
+    calculateCoefficients();
+
+    const auto fa0 = static_cast<float> (a0);
+    const auto fa1 = static_cast<float> (a1);
+    const auto fb1 = static_cast<float> (b1);
+    const auto fb2 = static_cast<float> (b2);
+    const auto gain = getControlValueAsFloat (1);
+
+    auto& block = context.getOutputBlock();
+    jassert (block.getNumChannels() <= simdZ1.size());
+
+    for (size_t g = 0; g < block.getNumChannels(); ++g)
+    {
+        auto* data = block.getChannelPointer (g);
+        auto s1 = simdZ1[g];
+        auto s2 = simdZ2[g];
+
+        for (size_t i = 0; i < block.getNumSamples(); i++)
+        {
+            const auto x = data[i];
+            const auto y = x * fa0 + s1;
+            s1 = x * fa1 + s2 - y * fb1;
+            s2 = x * fa0 - y * fb2;
+            data[i] = y * gain;
+        }
+
+        simdZ1[g] = s1;
+        simdZ2[g] = s2;
+    }
+}
+void LpfExample::resetProcessor()
 {
    init();
 }
@@ -82,9 +124,11 @@ void LpfExample::init()
     b2 = 0.0;
     for (auto ch = 0; ch < numChannels; ++ch)
     {
-        z1[ch] = 0.0;
-        z2[ch] = 0.0;
+        z1[ch] = 0.0f;
+        z2[ch] = 0.0f;
     }
+    std::fill (simdZ1.begin(), simdZ1.end(), SIMDFloat::expand (0.0f));
+    std::fill (simdZ2.begin(), simdZ2.end(), SIMDFloat::expand (0.0f));
 }
 void LpfExample::calculateCoefficients()
 {
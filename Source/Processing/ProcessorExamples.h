@@ -10,19 +10,23 @@
 
 #pragma once
 #include "ProcessorHarness.h"
+#include "SimdProcessorHarness.h"
 
 /** 
  * Example processor implementing a low pass filter using a biquad.
+ * Both paths filter in single precision (so the harness's timings compare vectorisation alone), with the SIMD path filtering groups
+ * of channels together.
  */
-class LpfExample : public ProcessorHarness
+class LpfExample : public SimdProcessorHarness
 {
 public:
     LpfExample();
     ~LpfExample() override = default;
 
-    void prepare (const dsp::ProcessSpec& spec) override;
-    void process (const dsp::ProcessContextReplacing<float>& context) override;
-    void reset() override;
+    void prepareProcessor (const dsp::ProcessSpec& spec) override;
+    void processScalar (const dsp::ProcessContextReplacing<float>& context) override;
+    void processSimd (const dsp::ProcessContextReplacing<SIMDFloat>& context) override;
+    void resetProcessor() override;
 
     String getProcessorName() override;
     String getControlName (const int index) override;
@@ -36,7 +40,8 @@ private:
     int numChannels = 0;
     double freqConversionFactor = 0.0;
     double a0 = 0.0, a1 = 0.0, b1 = 0.0, b2 = 0.0;
-    HeapBlock<double> z1, z2;
+    HeapBlock<float> z1, z2;
+    std::vector<SIMDFloat> simdZ1, simdZ2;
 };
 
 
@@ -32,6 +32,11 @@ void ProcessorHarness::prepareHarness (const dsp::ProcessSpec& spec)
     }
     currentSpec = spec;
 
+    // Allocate the buffers for measureLatency() here so it can be called from the audio thread
+    latencyMeasurementBlock = dsp::AudioBlock<float> (latencyMeasurementMemory, static_cast<size_t> (spec.numChannels), static_cast<size_t> (spec.maximumBlockSize));
+    if (impulseResponse == nullptr)
+        impulseResponse.allocate (static_cast<size_t> (maxMeasurableLatency), true);
+
     const auto start = Time::getMillisecondCounterHiRes();
 
 // =====================
@@ -72,6 +77,58 @@ void ProcessorHarness::resetHarness ()
     resetDurationSum += duration;
     resetDurationCount++;
 }
+void ProcessorHarness::measureLatency()
+{
+    const auto numChannels = static_cast<size_t> (currentSpec.numChannels);
+    const auto blockSize = static_cast<size_t> (currentSpec.maximumBlockSize);
+    if (numChannels == 0 || blockSize == 0)
+    {
+        measuredLatency.set (-1);
+        return;
+    }
+
+    auto& block = latencyMeasurementBlock;
+    jassert (block.getNumChannels() == numChannels && block.getNumSamples() == blockSize);
+
+    // Record the magnitude of the first channel's impulse response
+    auto peak = 0.0f;
+    for (size_t offset = 0; offset < static_cast<size_t> (maxMeasurableLatency); offset += blockSize)
+    {
+        block.clear();
+        if (offset == 0)
+            for (size_t ch = 0; ch < numChannels; ++ch)
+                block.setSample (static_cast<int> (ch), 0, 1.0f);
+
+        process (dsp::ProcessContextReplacing<float> (block));
+
+        const auto* data = block.getChannelPointer (0);
+        const auto numToCopy = jmin (blockSize, static_cast<size_t> (maxMeasurableLatency) - offset);
+        for (size_t i = 0; i < numToCopy; ++i)
+        {
+            impulseResponse[offset + i] = std::abs (data[i]);
+            peak = jmax (peak, impulseResponse[offset + i]);
+        }
+    }
+    reset();
+
+    // An output below -100 dB (or a NaN) is treated as no response (e.g. if the processor's gain is set to zero)
+    if (!(peak > 1.0e-5f))
+    {
+        measuredLatency.set (-1);
+        return;
+    }
+
+    // The latency is taken as the onset of the response (the peak of a minimum phase filter's response comes later, by its group delay)
+    const auto threshold = peak * 0.001f;
+    auto onset = 0;
+    while (impulseResponse[onset] < threshold)
+        ++onset;
+    measuredLatency.set (onset);
+}
+int ProcessorHarness::getMeasuredLatencySamples() const
+{
+    return measuredLatency.get();
+}
 int ProcessorHarness::getNumControls() const
 {
     return static_cast<int> (controlValues.size());
@@ -45,6 +45,13 @@ public:
     virtual double getDefaultControlValue (const int index) = 0;
 
     virtual juce::Range<double> getControlRange (const int index) = 0;
+
+    /** Override this if your processor introduces latency (e.g. lookahead or linear phase filtering).
+     *  Return -1 (the default) if the latency isn't known, in which case no latency is assumed unless the user asks for it to be
+     *  measured. Linear phase processors should report their latency, as the onset of their impulse response is well before it.
+     *  This is polled from the message thread while audio is running, so it must be safe to call alongside process().
+     */
+    virtual int getLatencySamples() { return -1; }
     
     // =================================================================================================================================
 
@@ -58,6 +65,20 @@ public:
     void resetHarness();
 
 
+    /** Feeds an impulse through your process() method to measure the processor's latency, then calls reset().
+     *  The latency is taken as the onset of the impulse response (the first sample within 60 dB of its peak) rather than the peak,
+     *  which would include the group delay of minimum phase filters. This must be called after prepareHarness() and not while audio
+     *  is running (it processes several blocks & resets the processor, which would cause a dropout).
+     */
+    void measureLatency();
+
+    /** Returns the latency measured by measureLatency() (or -1 if no impulse response could be detected). */
+    [[nodiscard]] int getMeasuredLatencySamples() const;
+
+    /** Longest latency that measureLatency() will look for (in samples). */
+    static constexpr int maxMeasurableLatency = 16384;
+
+
     /** Returns the number of control values for this processor. */
     [[nodiscard]] int getNumControls() const;
 
@@ -121,7 +142,7 @@ public:
 
 
     /** Reset statistics */
-    void resetStatistics();
+    virtual void resetStatistics();
 
 private:
     	
@@ -131,6 +152,10 @@ private:
     double resetDurationMin = 1.0E100, resetDurationMax = -1.0, resetDurationSum = 0.0, resetDurationCount = 0.0;
 
     std::vector <Atomic<double>> controlValues;
+    Atomic<int> measuredLatency = -1;
+    HeapBlock<char> latencyMeasurementMemory;
+    dsp::AudioBlock<float> latencyMeasurementBlock;
+    HeapBlock<float> impulseResponse;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ProcessorHarness)
 };
\ No newline at end of file
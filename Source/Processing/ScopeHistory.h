@@ -0,0 +1,322 @@
+/*
+  ==============================================================================
+
+    ScopeHistory.h
+    Created: 18 Oct 2026 2:11:54pm
+    Author:  Andrew
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include <atomic>
+
+/**
+	Long history of audio (seconds to minutes per channel) for an oscilloscope, held in a preallocated ring buffer per channel.
+
+	Alongside the samples, each channel has a decimation pyramid holding the minimum & maximum of cells of 4, 16, 64... samples, so
+	the min/max envelope of any range can be found by visiting a few cells per level (see getMinMax). This keeps the cost of drawing
+	proportional to the width of the scope rather than the amount of history shown, so minutes of audio can be scrolled & zoomed.
+
+	The memory is allocated in prepare(), sized from the sample rate & the number of channels to record (the history is shortened if
+	it would exceed maxMemoryBytes). Only the channels in the mask given to prepare() are recorded. The audio thread writes each channel
+	with writeChannel() & then publishes the samples with advance() (a recorded channel that wasn't written is filled with silence, so it
+	doesn't show stale samples). Any other thread can read the published samples without locking - the oldest few blocks are excluded
+	from the readable range because the writer may be overwriting them.
+
+	As prepare() reallocates the memory, readers must hold a ReadLease while they use anything but getNumSamplesWritten(). prepare()
+	waits for current leases to be released & no new lease is valid until it has finished, so a reader can't see freed memory.
+*/
+class ScopeHistory final
+{
+public:
+    /** Each level of the pyramid decimates the level below by this factor. */
+    static constexpr int levelFactor = 4;
+
+    /** Maximum number of levels in the pyramid (the top level has cells of 4^8 = 65536 samples). */
+    static constexpr int maxNumLevels = 8;
+
+    /** Upper limit on the memory allocated for the samples & pyramids of all channels. */
+    static constexpr size_t maxMemoryBytes = size_t (256) << 20;
+
+    ScopeHistory() = default;
+    ~ScopeHistory() = default;
+
+    /** Keeps the memory of the history from being reallocated while it's held (check isValid() first - a lease taken while the history
+     *  is being prepared is invalid, so the reader should skip reading). Leases may be nested & are cheap (a pair of atomic operations). */
+    class ReadLease final
+    {
+    public:
+        explicit ReadLease (const ScopeHistory& historyToRead)
+            : history (historyToRead)
+        {
+            history.numReaders.fetch_add (1);
+            valid = !history.isPreparing.load();
+        }
+
+        ~ReadLease()
+        {
+            history.numReaders.fetch_sub (1);
+        }
+
+        [[nodiscard]] bool isValid() const noexcept { return valid; }
+
+        ReadLease (const ReadLease&) = delete;
+        ReadLease& operator= (const ReadLease&) = delete;
+
+    private:
+        const ScopeHistory& history;
+        bool valid = false;
+    };
+
+    /** Allocates a history of at least the requested length for each channel in channelMask (a length of zero releases the memory).
+     *  The writer must not write more than maximumWriteSize samples per channel between calls to advance(). This must not be called
+     *  while the writer is active, but it may be called while readers are active (it waits for their leases to be released). */
+    void prepare (const dsp::ProcessSpec& spec, const uint64 channelMask, const double lengthInSeconds, const int maximumWriteSize);
+
+    /** Returns true if history has been allocated. */
+    [[nodiscard]] bool isEnabled() const noexcept { return capacity > 0; }
+
+    // === Audio thread ===
+
+    /** Appends samples to a channel's history (they aren't readable until advance() is called). Channels that aren't recorded are ignored. */
+    void writeChannel (const int channel, const float* samples, const int numSamples);
+
+    /** Publishes the samples written to each channel since the last call. */
+    void advance (const int numSamples);
+
+    // === Any thread (while holding a ReadLease, apart from getNumSamplesWritten) ===
+
+    /** Returns the total number of samples published (the position of the next sample to be written). */
+    [[nodiscard]] int64 getNumSamplesWritten() const noexcept { return numSamplesWritten.load (std::memory_order_acquire); }
+
+    /** Returns the position of the oldest sample that can be read safely. */
+    [[nodiscard]] int64 getOldestReadableSample() const noexcept;
+
+    /** Returns the length of the history in samples (i.e. the most that can be read once the history has filled). */
+    [[nodiscard]] int64 getLength() const noexcept { return capacity > 0 ? capacity - 2 * static_cast<int64> (maxWriteSize) : 0; }
+
+    [[nodiscard]] double getSampleRate() const noexcept { return sampleRate; }
+    [[nodiscard]] int getNumChannels() const noexcept { return numChannels; }
+
+    /** Returns true if the channel is recorded (i.e. it was in the channel mask when the history was prepared). */
+    [[nodiscard]] bool isChannelRecorded (const int channel) const noexcept
+    {
+        return capacity > 0 && channel >= 0 && channel < numChannels && channelSlots[channel] >= 0;
+    }
+
+    /** Returns the sample at an absolute position (which must be readable) of a recorded channel. */
+    [[nodiscard]] float getSample (const int channel, const int64 position) const;
+
+    /** Returns the minimum & maximum of the samples in [startSample, endSample), limited to the readable range (returns an empty range
+     *  at zero if no samples can be read). */
+    [[nodiscard]] Range<float> getMinMax (const int channel, const int64 startSample, const int64 endSample) const;
+
+private:
+    [[nodiscard]] const float* getChannelData (const int channel) const noexcept { return data.get() + static_cast<size_t> (channelSlots[channel]) * channelStride; }
+    [[nodiscard]] float* getChannelData (const int channel) noexcept { return data.get() + static_cast<size_t> (channelSlots[channel]) * channelStride; }
+
+    /** Writes samples to the slot of a recorded channel (or silence if samples is nullptr). */
+    void writeSlot (const int slot, const float* samples, const int numSamples);
+
+    /** Returns the number of samples in each cell of a level (level 0 is the samples themselves). */
+    static constexpr int64 getCellSize (const int level) { return int64 (1) << (2 * level); }
+
+    HeapBlock<float> data;                  // For each recorded channel, the samples followed by interleaved min/max pairs for each level
+    HeapBlock<int> channelSlots;            // The slot in data of each channel (or -1 if the channel isn't recorded)
+    HeapBlock<bool> slotWritten;            // Whether each slot has been written since the last call to advance()
+    size_t channelStride = 0;
+    size_t levelOffsets [maxNumLevels + 1] = {};
+    int64 capacity = 0;                     // Power of two, so positions can be wrapped with a mask
+    int numLevels = 0;
+    int numChannels = 0;
+    int numSlots = 0;
+    int maxWriteSize = 0;
+    double sampleRate = 0.0;
+    std::atomic<int64> numSamplesWritten { 0 };
+    mutable std::atomic<int> numReaders { 0 };
+    std::atomic<bool> isPreparing { false };
+
+public:
+    // Declare non-copyable, non-movable
+    ScopeHistory (const ScopeHistory&) = delete;
+    ScopeHistory& operator= (const ScopeHistory&) = delete;
+    ScopeHistory (ScopeHistory&& other) = delete;
+    ScopeHistory& operator= (ScopeHistory&& other) = delete;
+};
+
+
+// ===========================================================================================
+//  Implementation
+// ===========================================================================================
+
+inline void ScopeHistory::prepare (const dsp::ProcessSpec& spec, const uint64 channelMask, const double lengthInSeconds, const int maximumWriteSize)
+{
+    // Stop new readers & wait for current ones to finish before changing anything
+    isPreparing.store (true);
+    while (numReaders.load() > 0)
+        Thread::yield();
+
+    numChannels = static_cast<int> (spec.numChannels);
+    sampleRate = spec.sampleRate;
+    maxWriteSize = jmax (1, maximumWriteSize);
+    numSamplesWritten.store (0, std::memory_order_release);
+
+    // Give each recorded channel a slot (only the first 64 channels can be masked)
+    channelSlots.allocate (static_cast<size_t> (jmax (1, numChannels)), true);
+    numSlots = 0;
+    for (auto ch = 0; ch < numChannels; ++ch)
+        channelSlots[ch] = ch < 64 && (channelMask & (uint64 (1) << ch)) != 0 ? numSlots++ : -1;
+    slotWritten.allocate (static_cast<size_t> (jmax (1, numSlots)), true);
+
+    // Round the length up to a power of two, then halve it until the memory for every recorded channel fits within the limit (each
+    // level of the pyramid needs a pair of values per cell, so the pyramid adds two thirds to the memory used by the samples)
+    capacity = 0;
+    if (lengthInSeconds > 0.0 && sampleRate > 0.0 && numSlots > 0)
+    {
+        const auto requestedLength = static_cast<int64> (std::ceil (lengthInSeconds * sampleRate)) + 2 * maxWriteSize;
+        capacity = int64 (1) << jlimit (16, 40, static_cast<int> (std::ceil (std::log2 (static_cast<double> (requestedLength)))));
+        while (capacity > (int64 (1) << 16) && (capacity + capacity * 2 / 3) * static_cast<int64> (sizeof (float) * numSlots) > static_cast<int64> (maxMemoryBytes))
+            capacity >>= 1;
+    }
+
+    if (capacity == 0)
+    {
+        data.free();
+        channelStride = 0;
+        numLevels = 0;
+        isPreparing.store (false);
+        return;
+    }
+
+    // Keep at least four cells in the top level
+    numLevels = 1;
+    while (numLevels < maxNumLevels && getCellSize (numLevels + 1) * 4 <= capacity)
+        ++numLevels;
+
+    auto offset = static_cast<size_t> (capacity);
+    levelOffsets[0] = 0;
+    for (auto level = 1; level <= numLevels; ++level)
+    {
+        levelOffsets[level] = offset;
+        offset += 2 * static_cast<size_t> (capacity / getCellSize (level));
+    }
+    channelStride = offset;
+    data.allocate (channelStride * static_cast<size_t> (numSlots), true);
+    isPreparing.store (false);
+}
+
+inline void ScopeHistory::writeChannel (const int channel, const float* samples, const int numSamples)
+{
+    if (!isChannelRecorded (channel))
+        return;
+    writeSlot (channelSlots[channel], samples, numSamples);
+}
+
+inline void ScopeHistory::writeSlot (const int slot, const float* samples, const int numSamples)
+{
+    jassert (numSamples <= maxWriteSize);
+    slotWritten[slot] = true;
+
+    auto* channelData = data.get() + static_cast<size_t> (slot) * channelStride;
+    const auto mask = capacity - 1;
+    const auto start = numSamplesWritten.load (std::memory_order_relaxed);
+    const auto end = start + numSamples;
+    for (auto i = 0; i < numSamples; ++i)
+        channelData[(start + i) & mask] = samples != nullptr ? samples[i] : 0.0f;
+
+    // Complete each cell that ends within the new samples, working up from the level below (level 1 is built from the samples)
+    for (auto level = 1; level <= numLevels; ++level)
+    {
+        const auto shift = 2 * level;
+        const auto cellMask = (capacity >> shift) - 1;
+        const auto childMask = (capacity >> (shift - 2)) - 1;
+        auto* cells = channelData + levelOffsets[level];
+        const auto* children = channelData + levelOffsets[level - 1];
+        for (auto cell = start >> shift; cell < end >> shift; ++cell)
+        {
+            auto minimum = std::numeric_limits<float>::max();
+            auto maximum = std::numeric_limits<float>::lowest();
+            for (auto child = cell * levelFactor; child < (cell + 1) * levelFactor; ++child)
+            {
+                const auto index = child & childMask;
+                minimum = jmin (minimum, level == 1 ? children[index] : children[2 * index]);
+                maximum = jmax (maximum, level == 1 ? children[index] : children[2 * index + 1]);
+            }
+            const auto index = cell & cellMask;
+            cells[2 * index] = minimum;
+            cells[2 * index + 1] = maximum;
+        }
+        if ((end >> shift) == (start >> shift))
+            break; // No cells were completed, so none can be at higher levels either
+    }
+}
+
+inline void ScopeHistory::advance (const int numSamples)
+{
+    if (capacity == 0)
+        return;
+
+    // Fill any channel that wasn't written (e.g. it has been masked out since the history was prepared) with silence
+    for (auto slot = 0; slot < numSlots; ++slot)
+    {
+        if (!slotWritten[slot])
+            writeSlot (slot, nullptr, numSamples);
+        slotWritten[slot] = false;
+    }
+    numSamplesWritten.store (numSamplesWritten.load (std::memory_order_relaxed) + numSamples, std::memory_order_release);
+}
+
+inline int64 ScopeHistory::getOldestReadableSample() const noexcept
+{
+    // The writer may be overwriting the block after the newest published sample, which wraps around onto the oldest samples (a
+    // second block is excluded to give readers time to finish)
+    return jmax (int64 (0), getNumSamplesWritten() - capacity + 2 * static_cast<int64> (maxWriteSize));
+}
+
+inline float ScopeHistory::getSample (const int channel, const int64 position) const
+{
+    jassert (isChannelRecorded (channel));
+    return getChannelData (channel)[position & (capacity - 1)];
+}
+
+inline Range<float> ScopeHistory::getMinMax (const int channel, const int64 startSample, const int64 endSample) const
+{
+    if (!isChannelRecorded (channel))
+        return {};
+
+    auto start = jmax (startSample, getOldestReadableSample());
+    const auto end = jmin (endSample, getNumSamplesWritten());
+    if (start >= end)
+        return {};
+
+    // Take the largest aligned cell that starts at the current sample & fits in the range (at most three cells per level are visited
+    // on the way up & on the way down)
+    const auto* channelData = getChannelData (channel);
+    auto minimum = std::numeric_limits<float>::max();
+    auto maximum = std::numeric_limits<float>::lowest();
+    while (start < end)
+    {
+        auto level = 0;
+        while (level < numLevels && (start & (getCellSize (level + 1) - 1)) == 0 && start + getCellSize (level + 1) <= end)
+            ++level;
+
+        if (level == 0)
+        {
+            const auto value = channelData[start & (capacity - 1)];
+            minimum = jmin (minimum, value);
+            maximum = jmax (maximum, value);
+        }
+        else
+        {
+            const auto index = (start >> (2 * level)) & ((capacity >> (2 * level)) - 1);
+            const auto* cells = channelData + levelOffsets[level];
+            minimum = jmin (minimum, cells[2 * index]);
+            maximum = jmax (maximum, cells[2 * index + 1]);
+        }
+        start += getCellSize (level);
+    }
+    return { minimum, maximum };
+}
@@ -0,0 +1,229 @@
+/*
+  ==============================================================================
+
+    SimdProcessorHarness.cpp
+    Created: 18 Oct 2026 1:06:52pm
+    Author:  Andrew
+
+  ==============================================================================
+*/
+
+#include "SimdProcessorHarness.h"
+
+SimdProcessorHarness::SimdProcessorHarness (const int numberOfControlValues)
+    : ProcessorHarness (numberOfControlValues)
+{ }
+void SimdProcessorHarness::prepare (const dsp::ProcessSpec& spec)
+{
+    const auto numGroups = (static_cast<size_t> (spec.numChannels) + numLanes - 1) / numLanes;
+    interleavedBlock = dsp::AudioBlock<SIMDFloat> (interleavedData, numGroups, spec.maximumBlockSize);
+    silence.allocate (spec.maximumBlockSize, true);
+    simdWasUsed = simdEnabled.get();
+
+    prepareProcessor (spec);
+}
+void SimdProcessorHarness::process (const dsp::ProcessContextReplacing<float>& context)
+{
+    const auto useSimd = simdEnabled.get();
+    if (useSimd != simdWasUsed)
+    {
+        // The two paths keep separate state, so start afresh rather than carrying stale state across
+        resetProcessor();
+        simdWasUsed = useSimd;
+    }
+
+    if (!useSimd)
+    {
+        processScalar (context);
+        return;
+    }
+
+    auto& outputBlock = context.getOutputBlock();
+    const auto numGroups = (outputBlock.getNumChannels() + numLanes - 1) / numLanes;
+    jassert (numGroups <= interleavedBlock.getNumChannels());
+    jassert (outputBlock.getNumSamples() <= interleavedBlock.getNumSamples());
+
+    auto groups = interleavedBlock.getSubsetChannelBlock (0, numGroups).getSubBlock (0, outputBlock.getNumSamples());
+
+    auto start = Time::getMillisecondCounterHiRes();
+    interleave (context.getInputBlock(), groups);
+    auto duration = Time::getMillisecondCounterHiRes() - start;
+
+// =====================
+    processSimd (dsp::ProcessContextReplacing<SIMDFloat> (groups));
+// =====================
+
+    start = Time::getMillisecondCounterHiRes();
+    deinterleave (groups, outputBlock);
+    duration += Time::getMillisecondCounterHiRes() - start;
+
+    if (duration<transposeDurationMin) transposeDurationMin = duration;
+    if (duration>transposeDurationMax) transposeDurationMax = duration;
+    transposeDurationSum += duration;
+    transposeDurationCount++;
+}
+void SimdProcessorHarness::reset()
+{
+    resetProcessor();
+}
+void SimdProcessorHarness::setSimdProcessingEnabled (const bool shouldUseSimd)
+{
+    simdEnabled.set (shouldUseSimd);
+}
+bool SimdProcessorHarness::isSimdProcessingEnabled() const
+{
+    return simdEnabled.get();
+}
+double SimdProcessorHarness::queryTransposeDurationAverage() const
+{
+    return transposeDurationSum / transposeDurationCount;
+}
+double SimdProcessorHarness::queryTransposeDurationMax() const
+{
+    return transposeDurationMax;
+}
+double SimdProcessorHarness::queryTransposeDurationMin() const
+{
+    return transposeDurationMin;
+}
+void SimdProcessorHarness::resetStatistics()
+{
+    ProcessorHarness::resetStatistics();
+
+    transposeDurationMin = 1.0E100;
+    transposeDurationMax = -1.0;
+    transposeDurationSum = 0.0;
+    transposeDurationCount = 0.0;
+}
+SimdProcessorHarness::ComparisonResult SimdProcessorHarness::compareWithScalarPath (const dsp::AudioBlock<float>& block, const double sampleRate, const int iterations)
+{
+    jassert (iterations > 0);
+
+    const auto wasEnabled = isSimdProcessingEnabled();
+    const dsp::ProcessSpec spec { sampleRate, static_cast<uint32> (block.getNumSamples()), static_cast<uint32> (block.getNumChannels()) };
+    auto ioBlock = block;
+    const dsp::ProcessContextReplacing<float> context (ioBlock);
+
+    ComparisonResult result;
+    result.numChannels = static_cast<int> (block.getNumChannels());
+
+    prepareHarness (spec);
+    for (const auto useSimd : { false, true })
+    {
+        setSimdProcessingEnabled (useSimd);
+        resetHarness();
+        resetStatistics();
+
+        for (auto i = 0; i < iterations; ++i)
+            processHarness (context);
+
+        if (useSimd)
+        {
+            result.simdDuration = queryProcessingDurationAverage();
+            result.transposeDuration = queryTransposeDurationAverage();
+        }
+        else
+        {
+            result.scalarDuration = queryProcessingDurationAverage();
+        }
+    }
+    setSimdProcessingEnabled (wasEnabled);
+
+    return result;
+}
+void SimdProcessorHarness::interleave (const dsp::AudioBlock<const float>& source, const dsp::AudioBlock<SIMDFloat>& dest) const
+{
+    const auto numChannels = source.getNumChannels();
+    const auto numSamples = dest.getNumSamples();
+
+    for (size_t g = 0; g < dest.getNumChannels(); ++g)
+    {
+        const float* in[numLanes];
+        for (size_t lane = 0; lane < numLanes; ++lane)
+        {
+            const auto ch = g * numLanes + lane;
+            in[lane] = ch < numChannels ? source.getChannelPointer (ch) : silence.getData();
+        }
+        auto* out = reinterpret_cast<float*> (dest.getChannelPointer (g));
+        size_t i = 0;
+
+       #if JUCE_USE_SSE_INTRINSICS
+        // Transpose 4 channels x 4 samples at a time (wider registers are handled as several groups of 4 lanes)
+        for (; i + 4 <= numSamples; i += 4)
+        {
+            for (size_t q = 0; q < numLanes; q += 4)
+            {
+                auto r0 = _mm_loadu_ps (in[q] + i);
+                auto r1 = _mm_loadu_ps (in[q + 1] + i);
+                auto r2 = _mm_loadu_ps (in[q + 2] + i);
+                auto r3 = _mm_loadu_ps (in[q + 3] + i);
+                _MM_TRANSPOSE4_PS (r0, r1, r2, r3);
+                _mm_store_ps (out + i * numLanes + q, r0);
+                _mm_store_ps (out + (i + 1) * numLanes + q, r1);
+                _mm_store_ps (out + (i + 2) * numLanes + q, r2);
+                _mm_store_ps (out + (i + 3) * numLanes + q, r3);
+            }
+        }
+       #elif JUCE_USE_ARM_NEON
+        // NEON registers always hold 4 floats, and vst4q interleaves 4 registers as it stores them
+        for (; i + 4 <= numSamples; i += 4)
+        {
+            const float32x4x4_t r = { { vld1q_f32 (in[0] + i), vld1q_f32 (in[1] + i), vld1q_f32 (in[2] + i), vld1q_f32 (in[3] + i) } };
+            vst4q_f32 (out + i * numLanes, r);
+        }
+       #endif
+
+        for (; i < numSamples; ++i)
+            for (size_t lane = 0; lane < numLanes; ++lane)
+                out[i * numLanes + lane] = in[lane][i];
+    }
+}
+void SimdProcessorHarness::deinterleave (const dsp::AudioBlock<SIMDFloat>& source, const dsp::AudioBlock<float>& dest)
+{
+    const auto numChannels = dest.getNumChannels();
+    const auto numSamples = source.getNumSamples();
+
+    for (size_t g = 0; g < source.getNumChannels(); ++g)
+    {
+        const auto* in = reinterpret_cast<const float*> (source.getChannelPointer (g));
+        const auto lanesUsed = jmin (numLanes, numChannels - g * numLanes);
+        float* out[numLanes];
+        for (size_t lane = 0; lane < lanesUsed; ++lane)
+            out[lane] = dest.getChannelPointer (g * numLanes + lane);
+        size_t i = 0;
+
+        if (lanesUsed == numLanes)
+        {
+           #if JUCE_USE_SSE_INTRINSICS
+            for (; i + 4 <= numSamples; i += 4)
+            {
+                for (size_t q = 0; q < numLanes; q += 4)
+                {
+                    auto r0 = _mm_load_ps (in + i * numLanes + q);
+                    auto r1 = _mm_load_ps (in + (i + 1) * numLanes + q);
+                    auto r2 = _mm_load_ps (in + (i + 2) * numLanes + q);
+                    auto r3 = _mm_load_ps (in + (i + 3) * numLanes + q);
+                    _MM_TRANSPOSE4_PS (r0, r1, r2, r3);
+                    _mm_storeu_ps (out[q] + i, r0);
+                    _mm_storeu_ps (out[q + 1] + i, r1);
+                    _mm_storeu_ps (out[q + 2] + i, r2);
+                    _mm_storeu_ps (out[q + 3] + i, r3);
+                }
+            }
+           #elif JUCE_USE_ARM_NEON
+            for (; i + 4 <= numSamples; i += 4)
+            {
+                const auto r = vld4q_f32 (in + i * numLanes);
+                vst1q_f32 (out[0] + i, r.val[0]);
+                vst1q_f32 (out[1] + i, r.val[1]);
+                vst1q_f32 (out[2] + i, r.val[2]);
+                vst1q_f32 (out[3] + i, r.val[3]);
+            }
+           #endif
+        }
+
+        for (; i < numSamples; ++i)
+            for (size_t lane = 0; lane < lanesUsed; ++lane)
+                out[lane][i] = in[i * numLanes + lane];
+    }
+}
@@ -0,0 +1,113 @@
+/*
+  ==============================================================================
+
+    SimdProcessorHarness.h
+    Created: 18 Oct 2026 1:06:52pm
+    Author:  Andrew
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "ProcessorHarness.h"
+
+/**
+ * Inherit from this (instead of ProcessorHarness) if your processor can process several channels at once using SIMD registers.
+ *
+ * The harness transposes groups of channels into the lanes of an AudioBlock<SIMDRegister<float>> (i.e. lane n of group g holds
+ * channel g * numLanes + n), calls processSimd() and then transposes the result back. If the number of channels isn't a multiple
+ * of the number of lanes, the spare lanes of the last group are fed with silence and discarded afterwards.
+ *
+ * The scalar path (processScalar) is used by default, so enabling SIMD is always a deliberate choice (the paths may differ in precision
+ * and so give slightly different results). The SIMD path can be selected with setSimdProcessingEnabled() & the two can be compared
+ * with compareWithScalarPath().
+ */
+class SimdProcessorHarness : public ProcessorHarness
+{
+public:
+
+    using SIMDFloat = dsp::SIMDRegister<float>;
+
+    /** Number of channels processed together in each SIMD register. */
+    static constexpr size_t numLanes = SIMDFloat::SIMDNumElements;
+
+    explicit SimdProcessorHarness (const int numberOfControlValues);
+    ~SimdProcessorHarness() override = default;
+
+    // =================================================================================================================================
+
+    /** You will need to override this with your own preparation code (spec.numChannels is the number of scalar channels). */
+    virtual void prepareProcessor (const dsp::ProcessSpec& spec) = 0;
+
+    /** You will need to override this with your scalar (one channel at a time) processing code. */
+    virtual void processScalar (const dsp::ProcessContextReplacing<float>& context) = 0;
+
+    /** You will need to override this with your SIMD processing code. Each channel of the context is one group of numLanes channels. */
+    virtual void processSimd (const dsp::ProcessContextReplacing<SIMDFloat>& context) = 0;
+
+    /** You will need to override this with your own reset code (this is also called when switching between the scalar & SIMD paths). */
+    virtual void resetProcessor() = 0;
+
+    // =================================================================================================================================
+
+    void prepare (const dsp::ProcessSpec& spec) final;
+    void process (const dsp::ProcessContextReplacing<float>& context) final;
+    void reset() final;
+
+    /** Selects whether the SIMD path or the scalar path is used for processing (the scalar path is used by default). */
+    void setSimdProcessingEnabled (const bool shouldUseSimd);
+
+    /** Returns true if the SIMD path is used for processing. */
+    [[nodiscard]] bool isSimdProcessingEnabled() const;
+
+    /** Returns the average time taken to transpose channels into & out of SIMD lanes per process call (in milliseconds). */
+    [[nodiscard]] double queryTransposeDurationAverage() const;
+
+    /** Returns the maximum time taken to transpose channels into & out of SIMD lanes per process call (in milliseconds). */
+    [[nodiscard]] double queryTransposeDurationMax() const;
+
+    /** Returns the minimum time taken to transpose channels into & out of SIMD lanes per process call (in milliseconds). */
+    [[nodiscard]] double queryTransposeDurationMin() const;
+
+    /** Reset statistics (including the transpose statistics). */
+    void resetStatistics() override;
+
+    /** Results of comparing the scalar & SIMD paths (all durations are averages per process call in milliseconds). */
+    struct ComparisonResult
+    {
+        int numChannels = 0;
+        double scalarDuration = 0.0;
+        double simdDuration = 0.0;
+        double transposeDuration = 0.0;
+
+        /** Returns the net speed-up of the SIMD path (including the transposes) relative to the scalar path. This only measures the gain
+         *  from vectorisation if both paths work in the same precision. */
+        [[nodiscard]] double getSpeedUp() const { return simdDuration > 0.0 ? scalarDuration / simdDuration : 0.0; }
+    };
+
+    /**
+     * Prepares the processor for the supplied block & sample rate then times the scalar & SIMD paths over the specified number of
+     * process iterations. Note that this resets the statistics & processing state, so it should only be used when benchmarking.
+     */
+    ComparisonResult compareWithScalarPath (const dsp::AudioBlock<float>& block, const double sampleRate, const int iterations);
+
+private:
+
+    /** Transposes the source channels into the lanes of the destination groups. */
+    void interleave (const dsp::AudioBlock<const float>& source, const dsp::AudioBlock<SIMDFloat>& dest) const;
+
+    /** Transposes the lanes of the source groups back into the destination channels. */
+    static void deinterleave (const dsp::AudioBlock<SIMDFloat>& source, const dsp::AudioBlock<float>& dest);
+
+    HeapBlock<char> interleavedData{};
+    dsp::AudioBlock<SIMDFloat> interleavedBlock{};
+    HeapBlock<float> silence{};
+
+    Atomic<bool> simdEnabled = false;
+    bool simdWasUsed = false;
+
+    double transposeDurationMin = 1.0E100, transposeDurationMax = -1.0, transposeDurationSum = 0.0, transposeDurationCount = 0.0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SimdProcessorHarness)
+};
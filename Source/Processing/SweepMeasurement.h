@@ -0,0 +1,510 @@
+/*
+  ==============================================================================
+
+    SweepMeasurement.h
+    Created: 18 Oct 2026 1:39:43pm
+    Author:  Andrew
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "AudioDataTransfer.h"
+
+/**
+	Measures the impulse response of a processor using an exponential sine sweep (Farina's method). A single sweep gives the linear
+	impulse response (& hence the frequency response) as well as a separate impulse response for each harmonic distortion order.
+
+	The sweep is computed in full before it is played, so it is phase-coherent from start to finish (unlike the block-wise sweep
+	generated by the synthesis source). Nothing is built in prepare(), as most sessions never measure a sweep: the sweep & its inverse
+	filter are built on the worker thread when a measurement is first requested & are kept until the sample rate changes, while the
+	memory used to capture & deconvolve the response is allocated for each measurement & freed once it is complete. When a
+	measurement is started, the sweep is written into the input of the processor under test (see
+	renderSweep) & the output of the processor is streamed to the worker thread through an AudioStreamingProbe (see captureResponse)
+	until the sweep & a tail of silence have been captured. The audio thread does nothing else. The worker thread reads the stream
+	into the capture as it arrives, so the stream only needs to hold a fraction of a second. If the worker falls far enough behind
+	that samples are lost, the capture has a gap in it, so the measurement is abandoned (see hasCaptureOverflowed).
+
+	A worker thread then deconvolves the captured response by multiplying its spectrum by the spectrum of the analytic inverse filter
+	(the time-reversed sweep with a -6dB/octave envelope) using a single large FFT. The linear impulse response lands at the end of
+	the sweep (offset by the processor's latency, which is found from the peak), while the response of each harmonic k arrives
+	earlier by L.ln(k), where L is the sweep rate. Each is windowed out & transformed to give its magnitude response.
+
+	The results are written to an AudioProbe once the analysis is complete.
+*/
+class SweepMeasurement final
+{
+public:
+
+    static constexpr double defaultStartFrequency = 20.0;
+    static constexpr double defaultEndFrequency = 20000.0;
+    static constexpr double sweepDuration = 4.0;        // Seconds
+    static constexpr double tailDuration = 1.0;         // Seconds of silence captured after the sweep
+    static constexpr float sweepAmplitude = 0.5f;       // -6dBFS leaves headroom in the processor under test
+    static constexpr double streamDuration = 1.0;       // Seconds of response buffered between the audio & worker threads
+    static constexpr int capturePollIntervalMs = 20;    // How often the worker reads the stream during a measurement
+    static constexpr int maxResponses = 5;              // The linear response followed by harmonics 2 to 5
+    static constexpr int impulseResponseLength = 16384; // Samples of the linear impulse response kept in the result
+    static constexpr int preRingSamples = 256;          // Samples kept before the peak of each impulse response
+    static constexpr int responseOrder = 13;
+    static constexpr int responseSize = 1 << responseOrder;
+    static constexpr int numResponseBins = responseSize / 2 + 1;
+
+    /** Defines the stages of a measurement. */
+    enum State
+    {
+        Idle = 0,
+        Preparing,      // Waiting for the worker thread to build the sweep & start reading the stream
+        Requested,      // Waiting for the audio thread to start the sweep
+        Playing,        // The sweep (or the tail after it) is playing & the response is being captured
+        Analysing       // The whole response has been streamed & the worker thread is reading the rest & deconvolving it
+    };
+
+    /** The result of a measurement. This is necessary for us to use the AudioProbe class. */
+    struct Result final
+    {
+        int numSamples;                                     // Length of impulseResponse (0 if no measurement has been made)
+        double sampleRate;
+        double startFrequency;
+        double endFrequency;
+        float impulseResponse [impulseResponseLength];      // Linear impulse response starting preRingSamples before its peak
+        int numResponses;                                   // Number of magnitude responses (the linear response then each harmonic)
+        float magnitude [maxResponses][numResponseBins];    // Magnitude response (linear) of each impulse response, against the bin frequency
+                                                            // of the harmonic itself (i.e. harmonic k at bin b is excited by frequency b / k)
+    };
+
+    explicit SweepMeasurement();
+    ~SweepMeasurement();
+
+    /** Works out the length of the sweep & the capture for the sample rate (the sweep itself is built when a measurement is requested).
+     *  This also (re)starts the analysis thread & clears the AudioProbe, so listeners must be added after this. */
+    void prepare (const dsp::ProcessSpec& spec);
+
+    /** Requests a measurement. The sweep starts with the first call to renderSweep after the worker thread has built it & allocated
+     *  the capture. This is safe to call from any thread, but is ignored if a measurement is already in progress. */
+    void startMeasurement();
+
+    /** Abandons any measurement in progress (the last result is kept). */
+    void cancelMeasurement();
+
+    State getState() const;
+
+    /** Returns the progress of the current measurement from 0 to 1 (while playing). */
+    float getProgress() const;
+
+    /** Returns true if the sweep is waiting to start or playing (called on the audio thread). */
+    bool isSweepActive() const noexcept;
+
+    /** Returns true if the last measurement was abandoned because the worker thread fell behind & part of the response was lost. */
+    bool hasCaptureOverflowed() const;
+
+    /** Writes the next part of the sweep to every channel of the block, replacing whatever was there (called on the audio thread). */
+    void renderSweep (const dsp::AudioBlock<float>& block);
+
+    /** Streams the response of the processor to the block of the sweep most recently rendered (called on the audio thread).
+     *  Only the first channel of the block is captured. */
+    void captureResponse (const dsp::AudioBlock<float>& block);
+
+    /** Copies the latest result. Returns false if no valid result was available. */
+    bool copyResult (Result& dest) const;
+
+    /** Allows a listener to add a lambda function as a callback to the AudioProbe.
+     *  Listener callbacks are cleared each time prepare() is called on this class, so they must be added after this.
+     *
+     *  Returns a function which allows the listener to de-register it's callback. The listener must remove any references
+     *  to de-register functions that have become invalid.
+     */
+    ListenerRemovalCallback addListenerCallback (ListenerCallback&& listenerCallback) const;
+
+private:
+
+    /** Worker thread which deconvolves the captured response once it is complete. */
+    class AnalysisThread final : public Thread
+    {
+    public:
+        explicit AnalysisThread (SweepMeasurement& owner) : Thread ("Sweep analysis"), sweepMeasurement (owner) { }
+        void run() override;
+    private:
+        SweepMeasurement& sweepMeasurement;
+        JUCE_DECLARE_NON_COPYABLE (AnalysisThread)
+    };
+
+    /** Builds the sweep if needed, allocates the capture, adds the analysis thread as a consumer of the stream & lets the audio thread
+     *  start the sweep (called on the analysis thread). */
+    void beginCapture();
+
+    /** Computes the sweep & the spectrum of its inverse filter for the current sample rate (called on the analysis thread). */
+    void buildSweep();
+
+    /** Reads whatever has arrived from the stream into the capture & analyses it once it's complete (called on the analysis thread). */
+    void readCapture();
+
+    /** Stops consuming the stream & frees the capture & workspace (called on the analysis thread). */
+    void endCapture();
+
+    /** Deconvolves the captured response & writes the result to the probe (called on the analysis thread). */
+    void analyse();
+
+    /** Copies part of the deconvolved response, applies a fade in & out & writes its magnitude response to dest (called on the analysis thread). */
+    void computeMagnitudeResponse (const float* deconvolved, const int start, const int length, float* dest);
+
+    /** Multiplies the complex spectrum in data by the spectrum of the inverse filter. */
+    void multiplyByInverse (float* data) const;
+
+    double sampleRate = 48000.0; // will be set correctly in prepare()
+    double startFrequency = defaultStartFrequency;
+    double endFrequency = defaultEndFrequency;
+    double sweepRate = 1.0;     // L, the time (in seconds) taken to sweep by a factor of e
+    int sweepLength = 0;
+    int captureLength = 0;
+    double builtSampleRate = 0.0;   // Sample rate the sweep & inverse were built for (0 if they haven't been)
+
+    HeapBlock<float> sweep;
+    AudioStreamingProbe responseStream;
+    int consumerId = -1;
+    AudioSampleBuffer capture;
+    int numCaptured = 0;
+    HeapBlock<float> inverseSpectrum;   // Interleaved complex spectrum of the inverse filter
+    HeapBlock<float> workspace;
+    std::unique_ptr<dsp::FFT> fft;
+    int fftSize = 0;
+
+    dsp::FFT responseFft { responseOrder };
+    HeapBlock<float> responseWorkspace;
+
+    Atomic<int> state = Idle;
+    Atomic<int> position = 0;           // Position of the audio thread within the capture
+    Atomic<bool> captureOverflowed = false;
+
+    std::unique_ptr<Result> result;
+    std::unique_ptr<AudioProbe <Result>> probe;
+
+    AnalysisThread analysisThread { *this };
+};
+
+
+// ===========================================================================================
+//  Implementation
+// ===========================================================================================
+
+inline SweepMeasurement::SweepMeasurement()
+{
+    responseWorkspace.allocate (responseSize * 2, true);
+    result = std::make_unique<Result>();
+}
+
+inline SweepMeasurement::~SweepMeasurement()
+{
+    analysisThread.stopThread (1000);
+}
+
+inline void SweepMeasurement::prepare (const dsp::ProcessSpec& spec)
+{
+    // Stop the analysis thread while we reallocate everything it uses
+    analysisThread.stopThread (1000);
+    state.set (Idle);
+    position.set (0);
+    consumerId = -1;
+
+    sampleRate = spec.sampleRate;
+    startFrequency = defaultStartFrequency;
+    endFrequency = jmin (defaultEndFrequency, sampleRate * 0.45);
+    sweepLength = roundToInt (sweepDuration * sampleRate);
+    captureLength = sweepLength + roundToInt (tailDuration * sampleRate);
+    sweepRate = sweepDuration / std::log (endFrequency / startFrequency);
+
+    // The FFT must be long enough that the convolution of the capture with the inverse filter doesn't wrap around
+    fftSize = nextPowerOfTwo (sweepLength + captureLength);
+
+    // Restarting audio at the same sample rate keeps the sweep we've already built
+    if (builtSampleRate != sampleRate)
+    {
+        sweep.free();
+        inverseSpectrum.free();
+        fft.reset();
+        builtSampleRate = 0.0;
+    }
+    capture.setSize (0, 0);
+    workspace.free();
+    responseStream.prepare (1, roundToInt (streamDuration * sampleRate), 1);
+
+    probe = std::make_unique<AudioProbe<Result>>();
+
+    analysisThread.startThread();
+}
+
+inline void SweepMeasurement::buildSweep()
+{
+    // The sweep is x(t) = sin (2.pi.f1.L.(exp (t / L) - 1)), faded in & out over a few milliseconds to limit the ringing of the inverse
+    sweep.allocate (static_cast<size_t> (sweepLength), true);
+    const auto fadeLength = roundToInt (0.005 * sampleRate);
+    for (auto i = 0; i < sweepLength; ++i)
+    {
+        const auto t = static_cast<double> (i) / sampleRate;
+        const auto phase = MathConstants<double>::twoPi * startFrequency * sweepRate * (std::exp (t / sweepRate) - 1.0);
+        auto gain = 1.0;
+        if (i < fadeLength)
+            gain = 0.5 - 0.5 * std::cos (MathConstants<double>::pi * static_cast<double> (i) / static_cast<double> (fadeLength));
+        else if (i >= sweepLength - fadeLength)
+            gain = 0.5 - 0.5 * std::cos (MathConstants<double>::pi * static_cast<double> (sweepLength - 1 - i) / static_cast<double> (fadeLength));
+        sweep[i] = static_cast<float> (std::sin (phase) * gain);
+    }
+
+    fft = std::make_unique<dsp::FFT> (roundToInt (std::log2 (static_cast<double> (fftSize))));
+    inverseSpectrum.allocate (static_cast<size_t> (fftSize) * 2, true);
+
+    // The inverse filter is the time-reversed sweep with an envelope of exp (-t / L), which falls by 6dB/octave to compensate for
+    // the sweep spending longer (& so putting more energy) at low frequencies
+    for (auto i = 0; i < sweepLength; ++i)
+        inverseSpectrum[i] = sweep[sweepLength - 1 - i] * static_cast<float> (std::exp (-static_cast<double> (i) / sampleRate / sweepRate));
+    fft->performRealOnlyForwardTransform (inverseSpectrum.getData(), true);
+
+    // Normalise the inverse so the sweep (as played) convolved with it has unity gain (measured in the middle of the sweep's band)
+    FloatVectorOperations::copy (workspace.getData(), sweep.getData(), sweepLength);
+    fft->performRealOnlyForwardTransform (workspace.getData(), true);
+    const auto midBin = roundToInt (std::sqrt (startFrequency * endFrequency) * static_cast<double> (fftSize) / sampleRate);
+    const std::complex<float> sweepBin (workspace[2 * midBin], workspace[2 * midBin + 1]);
+    const std::complex<float> inverseBin (inverseSpectrum[2 * midBin], inverseSpectrum[2 * midBin + 1]);
+    FloatVectorOperations::multiply (inverseSpectrum.getData(), 1.0f / (std::abs (sweepBin * inverseBin) * sweepAmplitude), fftSize * 2);
+
+    builtSampleRate = sampleRate;
+}
+
+inline void SweepMeasurement::startMeasurement()
+{
+    state.compareAndSetBool (Preparing, Idle);
+}
+
+inline void SweepMeasurement::cancelMeasurement()
+{
+    // The audio thread may be between renderSweep & captureResponse, but captureResponse does nothing unless playing. The analysis
+    // thread stops consuming the stream when it sees we're idle.
+    state.compareAndSetBool (Idle, Preparing);
+    state.compareAndSetBool (Idle, Requested);
+    state.compareAndSetBool (Idle, Playing);
+}
+
+inline SweepMeasurement::State SweepMeasurement::getState() const
+{
+    return static_cast<State> (state.get());
+}
+
+inline float SweepMeasurement::getProgress() const
+{
+    if (state.get() != Playing || captureLength == 0)
+        return 0.0f;
+    return static_cast<float> (position.get()) / static_cast<float> (captureLength);
+}
+
+inline bool SweepMeasurement::isSweepActive() const noexcept
+{
+    const auto s = state.get();
+    return s == Requested || s == Playing;
+}
+
+inline bool SweepMeasurement::hasCaptureOverflowed() const
+{
+    return captureOverflowed.get();
+}
+
+inline void SweepMeasurement::renderSweep (const dsp::AudioBlock<float>& block)
+{
+    if (state.compareAndSetBool (Playing, Requested))
+        position.set (0);
+
+    if (state.get() != Playing)
+        return;
+
+    // Play the sweep, then silence for the tail
+    const auto numSamples = static_cast<int> (block.getNumSamples());
+    const auto start = position.get();
+    const auto numSweepSamples = jlimit (0, numSamples, sweepLength - start);
+    for (size_t ch = 0; ch < block.getNumChannels(); ++ch)
+    {
+        auto* dest = block.getChannelPointer (ch);
+        if (numSweepSamples > 0)
+            FloatVectorOperations::copyWithMultiply (dest, sweep.getData() + start, sweepAmplitude, numSweepSamples);
+        FloatVectorOperations::clear (dest + numSweepSamples, numSamples - numSweepSamples);
+    }
+}
+
+inline void SweepMeasurement::captureResponse (const dsp::AudioBlock<float>& block)
+{
+    if (state.get() != Playing || block.getNumChannels() == 0)
+        return;
+
+    const auto start = position.get();
+    const auto n = jmin (static_cast<int> (block.getNumSamples()), captureLength - start);
+    responseStream.writeBlock (block.getSingleChannelBlock (0).getSubBlock (0, static_cast<size_t> (n)));
+    position.set (start + n);
+
+    // The analysis thread polls the stream, so it isn't woken from here (which would take a lock on the audio thread)
+    if (start + n >= captureLength)
+        state.compareAndSetBool (Analysing, Playing);
+}
+
+inline void SweepMeasurement::AnalysisThread::run()
+{
+    while (!threadShouldExit())
+    {
+        const auto s = sweepMeasurement.state.get();
+        if (s == Preparing)
+            sweepMeasurement.beginCapture();
+        else if (s != Idle)
+            sweepMeasurement.readCapture();
+        else if (sweepMeasurement.consumerId >= 0)
+            sweepMeasurement.endCapture(); // Cancelled
+
+        wait (s == Idle ? 100 : capturePollIntervalMs);
+    }
+}
+
+inline void SweepMeasurement::beginCapture()
+{
+    // A cancelled measurement may not have been cleaned up yet
+    endCapture();
+
+    workspace.allocate (static_cast<size_t> (fftSize) * 2, true);
+    if (builtSampleRate != sampleRate)
+        buildSweep();
+    capture.setSize (1, captureLength);
+
+    consumerId = responseStream.addConsumer();
+    numCaptured = 0;
+    captureOverflowed.set (false);
+    if (consumerId < 0 || !state.compareAndSetBool (Requested, Preparing))
+    {
+        endCapture();
+        state.compareAndSetBool (Idle, Preparing);
+    }
+}
+
+inline void SweepMeasurement::readCapture()
+{
+    if (consumerId < 0)
+        return;
+
+    // A gap in the capture would ruin the deconvolution, so give up
+    if (responseStream.getNumLostSamples (consumerId) > 0)
+    {
+        captureOverflowed.set (true);
+        cancelMeasurement();
+        state.compareAndSetBool (Idle, Analysing);
+        endCapture();
+        return;
+    }
+
+    const auto numToRead = jmin (responseStream.getNumReady (consumerId), captureLength - numCaptured);
+    numCaptured += responseStream.read (consumerId, capture, numCaptured, numToRead);
+
+    if (state.get() == Analysing && numCaptured >= captureLength)
+    {
+        analyse();
+        endCapture();
+        state.set (Idle);
+    }
+}
+
+inline void SweepMeasurement::endCapture()
+{
+    responseStream.removeConsumer (consumerId);
+    consumerId = -1;
+    capture.setSize (0, 0);
+    workspace.free();
+}
+
+inline void SweepMeasurement::analyse()
+{
+    // Deconvolve by multiplying the spectrum of the capture with the spectrum of the inverse filter
+    auto* data = workspace.getData();
+    FloatVectorOperations::copy (data, capture.getReadPointer (0), captureLength);
+    FloatVectorOperations::clear (data + captureLength, fftSize * 2 - captureLength);
+    fft->performRealOnlyForwardTransform (data, true);
+    multiplyByInverse (data);
+    fft->performRealOnlyInverseTransform (data);
+
+    // The linear impulse response starts at the end of the sweep, delayed by the latency of the processor, so take its peak as time zero
+    const auto searchStart = sweepLength - 1;
+    const auto searchLength = captureLength - sweepLength;
+    auto peak = searchStart;
+    auto peakLevel = 0.0f;
+    for (auto i = searchStart; i < searchStart + searchLength; ++i)
+    {
+        if (std::abs (data[i]) > peakLevel)
+        {
+            peakLevel = std::abs (data[i]);
+            peak = i;
+        }
+    }
+
+    // Keep the start of the linear impulse response for display
+    const auto irStart = peak - preRingSamples;
+    const auto irLength = jmin (impulseResponseLength, fftSize - irStart);
+    FloatVectorOperations::copy (result->impulseResponse, data + irStart, irLength);
+    FloatVectorOperations::clear (result->impulseResponse + irLength, impulseResponseLength - irLength);
+
+    // The linear response is followed by the tail, while each harmonic k has until harmonic k - 1 arrives (i.e. L.ln (k / (k - 1)))
+    computeMagnitudeResponse (data, irStart, jmin (responseSize, preRingSamples + captureLength - sweepLength), result->magnitude[0]);
+    result->numResponses = 1;
+    for (auto k = 2; k <= maxResponses; ++k)
+    {
+        const auto offset = roundToInt (sweepRate * std::log (static_cast<double> (k)) * sampleRate);
+        const auto gap = roundToInt (sweepRate * std::log (static_cast<double> (k) / static_cast<double> (k - 1)) * sampleRate);
+        const auto start = peak - offset - preRingSamples;
+        if (start < 0)
+            break;
+        computeMagnitudeResponse (data, start, jmin (responseSize, preRingSamples + gap * 9 / 10), result->magnitude[k - 1]);
+        result->numResponses = k;
+    }
+
+    result->numSamples = impulseResponseLength;
+    result->sampleRate = sampleRate;
+    result->startFrequency = startFrequency;
+    result->endFrequency = endFrequency;
+    probe->writeFrame (result.get());
+}
+
+inline void SweepMeasurement::computeMagnitudeResponse (const float* deconvolved, const int start, const int length, float* dest)
+{
+    // Half Hann fades over the pre-ring at the start & the last quarter at the end
+    auto* data = responseWorkspace.getData();
+    FloatVectorOperations::copy (data, deconvolved + start, length);
+    FloatVectorOperations::clear (data + length, responseSize * 2 - length);
+    const auto fadeOutLength = length / 4;
+    for (auto i = 0; i < preRingSamples; ++i)
+        data[i] *= 0.5f - 0.5f * std::cos (MathConstants<float>::pi * static_cast<float> (i) / static_cast<float> (preRingSamples));
+    for (auto i = 0; i < fadeOutLength; ++i)
+        data[length - 1 - i] *= 0.5f - 0.5f * std::cos (MathConstants<float>::pi * static_cast<float> (i) / static_cast<float> (fadeOutLength));
+
+    responseFft.performFrequencyOnlyForwardTransform (data);
+    FloatVectorOperations::copy (dest, data, numResponseBins);
+}
+
+inline void SweepMeasurement::multiplyByInverse (float* data) const
+{
+    auto* bins = reinterpret_cast<std::complex<float>*> (data);
+    const auto* inverse = reinterpret_cast<const std::complex<float>*> (inverseSpectrum.getData());
+    for (auto k = 0; k <= fftSize / 2; ++k)
+        bins[k] *= inverse[k];
+}
+
+inline bool SweepMeasurement::copyResult (Result& dest) const
+{
+    if (!probe)
+        return false;
+
+    probe->copyFrame (&dest);
+    return dest.numSamples > 0;
+}
+
+inline ListenerRemovalCallback SweepMeasurement::addListenerCallback (ListenerCallback&& listenerCallback) const
+{
+    // If this asserts then you're trying to add the listener before the AudioProbe is set up
+    jassert (probe != nullptr);
+
+    if (probe)
+        return probe->addListenerCallback (std::forward<ListenerCallback> (listenerCallback));
+
+    return {};
+}
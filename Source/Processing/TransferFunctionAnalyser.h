@@ -0,0 +1,340 @@
+/*
+  ==============================================================================
+
+    TransferFunctionAnalyser.h
+    Created: 18 Oct 2026 1:35:19pm
+    Author:  Andrew
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "AudioDataTransfer.h"
+#include "DelayCompensator.h"
+
+/**
+	Measures the frequency & phase response of a processor from the signal going into it (the reference) and the signal coming out
+	of it (the response). Because the measurement is made by comparing the two signals, any broadband stimulus will do (noise or
+	music as well as a sweep) - there's no need for a dedicated test signal.
+
+	The reference & response are appended on the audio thread with appendReference & appendResponse (only the first channel of each is
+	used). The reference is delayed by the latency of the processor (see setReferenceDelay) so that the two line up. Blocks are
+	collected in pairs & pushed through a FrameQueue to a worker thread.
+
+	The worker computes Hann windowed FFTs of each pair & averages the auto-spectra of the reference & response & the cross-spectrum
+	between them (averaging linearly until numAveragingFrames pairs have been collected, then exponentially). The transfer function
+	is the H1 estimate (cross-spectrum divided by the reference auto-spectrum), which is unbiased by noise added at the output. The
+	magnitude squared coherence shows how much of the response is explained linearly by the reference at each frequency: it falls
+	where the stimulus has little energy, where the processor is non-linear or adds noise, or if the latency is wrong.
+
+	The results are written to an AudioProbe after every pair, so they can be displayed while the stimulus is playing.
+*/
+class TransferFunctionAnalyser final : public FixedBlockProcessor
+{
+public:
+
+    static constexpr int fftOrder = 13;                 // 8192 point FFT (about 6Hz resolution at 48kHz)
+    static constexpr int fftSize = 1 << fftOrder;
+    static constexpr int numBins = fftSize / 2 + 1;
+    static constexpr int numAveragingFrames = 16;       // Frames are averaged linearly until this many have been collected, then exponentially
+
+    /** The result of a measurement. This is necessary for us to use the AudioProbe class. */
+    struct TransferFunctionFrame final
+    {
+        int numFramesAveraged;              // Number of frames in the average (0 if no measurement has been made)
+        float magnitude [numBins];          // Gain of the processor (linear)
+        float phase [numBins];              // Phase shift of the processor (radians, wrapped to +/-pi)
+        float coherence [numBins];          // Magnitude squared coherence (0 to 1)
+    };
+
+    explicit TransferFunctionAnalyser();
+    ~TransferFunctionAnalyser() override;
+
+    /** Sets the maximum latency that can be compensated for. This allocates, so must be called before prepare(). */
+    void setMaximumReferenceDelay (const int maximumDelaySamples);
+
+    /** Note that this clears then sets the AudioProbe - so it must be called before any attached classes attempt to add listeners to it.
+     *  This also (re)starts the analysis thread. The number of channels in spec is ignored (the reference & response are analysed as a pair). */
+    void prepare (const dsp::ProcessSpec& spec) override;
+
+    /** Called on the audio thread - this just queues the pair of blocks for the analysis thread once the response block is complete. */
+    void performProcessing (const int channel) override;
+
+    /** Appends the signal going into the processor (called on the audio thread). */
+    void appendReference (const float* data, const int numSamples);
+
+    /** Appends the signal coming out of the processor (called on the audio thread, after the matching call to appendReference). */
+    void appendResponse (const float* data, const int numSamples);
+
+    /** Sets the delay applied to the reference to compensate for the latency of the processor. The change is applied on the audio
+     *  thread & averaging restarts. This is safe to call from any thread. */
+    void setReferenceDelay (const int delaySamples);
+
+    /** Restarts averaging (e.g. if the processor under test is changed). This is safe to call from any thread. */
+    void resetAveraging();
+
+    /** Copies the latest measurement. Returns false if no valid measurement was available. */
+    bool copyFrame (TransferFunctionFrame& dest) const;
+
+    /** Allows a listener to add a lambda function as a callback to the AudioProbe.
+     *  Listener callbacks are cleared each time prepare() is called on this class, so they must be added after this.
+     *
+     *  Returns a function which allows the listener to de-register it's callback. The listener must remove any references
+     *  to de-register functions that have become invalid.
+     */
+    ListenerRemovalCallback addListenerCallback (ListenerCallback&& listenerCallback) const;
+
+private:
+
+    /** Worker thread which analyses pairs of frames as they arrive in the queue. */
+    class AnalysisThread final : public Thread
+    {
+    public:
+        explicit AnalysisThread (TransferFunctionAnalyser& owner) : Thread ("Transfer function analysis"), transferFunctionAnalyser (owner) { }
+        void run() override;
+    private:
+        TransferFunctionAnalyser& transferFunctionAnalyser;
+        JUCE_DECLARE_NON_COPYABLE (AnalysisThread)
+    };
+
+    /** Averages the spectra of the pair of frames held in temp & writes the measurement to the probe (called on the analysis thread). */
+    void analyseFrames();
+
+    static constexpr int referenceChannel = 0;
+    static constexpr int responseChannel = 1;
+
+    /** Number of frame pairs that can be queued for the analysis thread. */
+    static constexpr int queueLengthInPairs = 4;
+
+    dsp::FFT fft;
+    HeapBlock<float> window;
+	AudioSampleBuffer temp;                 // Reference & response frames (each with room for the complex FFT output)
+    AudioSampleBuffer averages;             // Reference auto-spectrum, response auto-spectrum & the real & imaginary parts of the cross-spectrum
+    int numFramesAveraged = 0;
+    bool referencePending = false;          // Whether the worker holds a reference frame that is waiting for its response
+    Atomic<bool> averagingResetRequested = false;
+
+    DelayCompensator referenceDelay;
+    AudioSampleBuffer delayedReference;     // Holds a copy of the reference so it can be delayed without touching the source
+    int maxReferenceDelay = 0;
+    Atomic<int> requestedReferenceDelay = 0;
+
+    std::unique_ptr<TransferFunctionFrame> result;
+    std::unique_ptr<AudioProbe <TransferFunctionFrame>> probe;
+
+    FrameQueue frameQueue;
+    AnalysisThread analysisThread { *this };
+};
+
+
+// ===========================================================================================
+//  Implementation
+// ===========================================================================================
+
+inline TransferFunctionAnalyser::TransferFunctionAnalyser(): FixedBlockProcessor (fftSize),
+                                                             fft (fftOrder)
+{
+    window.allocate (fftSize, true);
+    dsp::WindowingFunction<float>::fillWindowingTables (window.getData(), fftSize, dsp::WindowingFunction<float>::hann, false);
+
+    temp.setSize (2, fftSize * 2, false, true);
+    averages.setSize (4, numBins, false, true);
+    result = std::make_unique<TransferFunctionFrame>();
+
+    // Overlap frames by half, which is enough to recover what the window throws away
+    setHopSize (fftSize / 2);
+}
+
+inline TransferFunctionAnalyser::~TransferFunctionAnalyser()
+{
+    analysisThread.stopThread (1000);
+}
+
+inline void TransferFunctionAnalyser::setMaximumReferenceDelay (const int maximumDelaySamples)
+{
+    jassert (maximumDelaySamples >= 0);
+    maxReferenceDelay = jmax (0, maximumDelaySamples);
+}
+
+inline void TransferFunctionAnalyser::prepare (const dsp::ProcessSpec& spec)
+{
+    // Stop the analysis thread while we reallocate everything it uses
+    analysisThread.stopThread (1000);
+
+    // The reference & response are held as two channels
+    const dsp::ProcessSpec pairSpec { spec.sampleRate, spec.maximumBlockSize, 2 };
+    FixedBlockProcessor::prepare (pairSpec);
+    frameQueue.prepare (fftSize, 2 * queueLengthInPairs);
+
+    const dsp::ProcessSpec referenceSpec { spec.sampleRate, spec.maximumBlockSize, 1 };
+    referenceDelay.prepare (referenceSpec, maxReferenceDelay);
+    referenceDelay.setDelay (jmin (requestedReferenceDelay.get(), maxReferenceDelay));
+    delayedReference.setSize (1, static_cast<int> (spec.maximumBlockSize));
+
+    averages.clear();
+    numFramesAveraged = 0;
+    referencePending = false;
+    averagingResetRequested.set (false);
+
+    // Add a probe to transfer measurements to the GUI
+    probe = std::make_unique<AudioProbe<TransferFunctionFrame>>();
+
+    analysisThread.startThread();
+}
+
+inline void TransferFunctionAnalyser::performProcessing (const int channel)
+{
+    // The reference block completes first, so only queue it once its response has also arrived (the pair must be queued together)
+    if (channel != responseChannel || getBlockReadPointer (referenceChannel) == nullptr)
+        return;
+
+    // The analysis thread polls the queue (see FrameQueue::getConsumerPollInterval)
+    if (frameQueue.push (getBlockReadPointer (referenceChannel), getCurrentBlockSize(), referenceChannel))
+        frameQueue.push (getBlockReadPointer (responseChannel), getCurrentBlockSize(), responseChannel);
+}
+
+inline void TransferFunctionAnalyser::appendReference (const float* data, const int numSamples)
+{
+    jassert (numSamples <= delayedReference.getNumSamples());
+    const auto n = jmin (numSamples, delayedReference.getNumSamples());
+    if (n <= 0)
+        return;
+
+    // Apply any change to the latency compensation (the history is cleared so stale audio doesn't end up in the average)
+    const auto delay = jmin (requestedReferenceDelay.get(), maxReferenceDelay);
+    if (delay != referenceDelay.getDelay())
+    {
+        referenceDelay.reset();
+        referenceDelay.setDelay (delay);
+        resetAveraging();
+    }
+
+    delayedReference.copyFrom (0, 0, data, n);
+    referenceDelay.process (dsp::AudioBlock<float> (delayedReference).getSubBlock (0, static_cast<size_t> (n)));
+    appendData (referenceChannel, n, delayedReference.getReadPointer (0));
+}
+
+inline void TransferFunctionAnalyser::appendResponse (const float* data, const int numSamples)
+{
+    const auto n = jmin (numSamples, delayedReference.getNumSamples());
+    if (n > 0)
+        appendData (responseChannel, n, data);
+}
+
+inline void TransferFunctionAnalyser::setReferenceDelay (const int delaySamples)
+{
+    jassert (delaySamples >= 0);
+    requestedReferenceDelay.set (jmax (0, delaySamples));
+}
+
+inline void TransferFunctionAnalyser::resetAveraging()
+{
+    averagingResetRequested.set (true);
+}
+
+inline void TransferFunctionAnalyser::AnalysisThread::run()
+{
+    auto& owner = transferFunctionAnalyser;
+    auto lastFrameTime = Time::getMillisecondCounter();
+
+    while (!threadShouldExit())
+    {
+        auto channel = 0;
+        auto numSamples = 0;
+        auto* reference = owner.temp.getWritePointer (referenceChannel);
+        auto* response = owner.temp.getWritePointer (responseChannel);
+
+        // Frames arrive in pairs, but a response is only analysed if the reference queued just before it is held
+        while (owner.frameQueue.pop (owner.referencePending ? response : reference, numSamples, channel))
+        {
+            lastFrameTime = Time::getMillisecondCounter();
+            jassert (numSamples == fftSize);
+            if (channel == referenceChannel)
+            {
+                // The response to the previous reference was dropped, so this reference replaces it
+                if (owner.referencePending)
+                    FloatVectorOperations::copy (reference, response, fftSize);
+                owner.referencePending = true;
+                continue;
+            }
+            if (owner.referencePending)
+            {
+                owner.referencePending = false;
+                owner.analyseFrames();
+            }
+            if (threadShouldExit())
+                return;
+        }
+        wait (FrameQueue::getConsumerPollInterval (lastFrameTime));
+    }
+}
+
+inline void TransferFunctionAnalyser::analyseFrames()
+{
+    auto* x = temp.getWritePointer (referenceChannel);
+    auto* y = temp.getWritePointer (responseChannel);
+    FloatVectorOperations::multiply (x, window.getData(), fftSize);
+    FloatVectorOperations::multiply (y, window.getData(), fftSize);
+    fft.performRealOnlyForwardTransform (x, true);
+    fft.performRealOnlyForwardTransform (y, true);
+
+    if (averagingResetRequested.get())
+    {
+        averagingResetRequested.set (false);
+        numFramesAveraged = 0;
+    }
+    if (numFramesAveraged < numAveragingFrames)
+        ++numFramesAveraged;
+    const auto alpha = 1.0f / static_cast<float> (numFramesAveraged);
+
+    // Average the auto-spectra & the cross-spectrum conj(X).Y
+    auto* sxx = averages.getWritePointer (0);
+    auto* syy = averages.getWritePointer (1);
+    auto* sxyRe = averages.getWritePointer (2);
+    auto* sxyIm = averages.getWritePointer (3);
+    for (auto k = 0; k < numBins; ++k)
+    {
+        const auto xr = x[2 * k];
+        const auto xi = x[2 * k + 1];
+        const auto yr = y[2 * k];
+        const auto yi = y[2 * k + 1];
+        sxx[k] += alpha * (xr * xr + xi * xi - sxx[k]);
+        syy[k] += alpha * (yr * yr + yi * yi - syy[k]);
+        sxyRe[k] += alpha * (xr * yr + xi * yi - sxyRe[k]);
+        sxyIm[k] += alpha * (xr * yi - xi * yr - sxyIm[k]);
+    }
+
+    // H1 = Sxy / Sxx & coherence = |Sxy|^2 / (Sxx.Syy), guarding against bins that have no energy
+    const auto tiny = 1.0e-20f;
+    for (auto k = 0; k < numBins; ++k)
+    {
+        const auto crossSquared = sxyRe[k] * sxyRe[k] + sxyIm[k] * sxyIm[k];
+        result->magnitude[k] = std::sqrt (crossSquared) / jmax (tiny, sxx[k]);
+        result->phase[k] = std::atan2 (sxyIm[k], sxyRe[k]);
+        result->coherence[k] = jmin (1.0f, crossSquared / jmax (tiny, sxx[k] * syy[k]));
+    }
+    result->numFramesAveraged = numFramesAveraged;
+
+    probe->writeFrame (result.get());
+}
+
+inline bool TransferFunctionAnalyser::copyFrame (TransferFunctionFrame& dest) const
+{
+    if (!probe)
+        return false;
+
+    probe->copyFrame (&dest);
+    return dest.numFramesAveraged > 0;
+}
+
+inline ListenerRemovalCallback TransferFunctionAnalyser::addListenerCallback (ListenerCallback&& listenerCallback) const
+{
+    // If this asserts then you're trying to add the listener before the AudioProbe is set up
+    jassert (probe != nullptr);
+
+    if (probe)
+        return probe->addListenerCallback (std::forward<ListenerCallback> (listenerCallback));
+
+    return {};
+}
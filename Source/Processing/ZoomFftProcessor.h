@@ -0,0 +1,371 @@
+/*
+  ==============================================================================
+
+    ZoomFftProcessor.h
+    Created: 18 Oct 2026 1:49:09pm
+    Author:  Andrew
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "AudioDataTransfer.h"
+#include "HalfBandDecimator.h"
+
+/**
+	Zoom FFT for high resolution analysis of a narrow band around a centre frequency (e.g. to resolve closely spaced tones or the
+	sidebands of mains hum).
+
+	Like FftProcessor, this collects fixed size blocks on the audio thread & pushes them through a FrameQueue to a worker thread. The
+	worker mixes each block down to baseband with a complex oscillator at the centre frequency, then decimates the in-phase & quadrature
+	parts through a cascade of HalfBandDecimators (which are polyphase, so each stage only computes its output samples). A complex FFT
+	of the decimated stream then resolves the band with the resolution of an FFT 2 ^ zoomOrder times larger, for a fraction of the CPU.
+
+	Each decimator is flat & free of aliasing up to a quarter of its output rate, so only the middle half of the complex FFT is used:
+	the frame spans +/- fs / 2 ^ (zoomOrder + 2) around the centre frequency. Frames overlap by three quarters, so the display updates
+	four times per frame even though a frame spans several seconds at the highest zoom. Changing the centre frequency or zoom restarts
+	the analysis (see getFillProportion for progress towards the first frame).
+*/
+class ZoomFftProcessor final : public FixedBlockProcessor
+{
+public:
+
+    static constexpr int fftOrder = 11;                 // 2048 point complex FFT of the decimated stream
+    static constexpr int fftSize = 1 << fftOrder;
+    static constexpr int numBins = fftSize / 2 + 1;     // Bins in the middle half of the FFT (centred on the centre frequency)
+    static constexpr int minZoomOrder = 1;              // Decimate by 2
+    static constexpr int maxZoomOrder = 8;              // Decimate by 256 (about 0.09Hz per bin at 48kHz)
+    static constexpr int defaultZoomOrder = 4;
+    static constexpr int blockSize = 1024;              // Size of the blocks passed to the worker thread
+
+    /** The amplitude of each bin around the centre frequency. This is necessary for us to use the AudioProbe class. */
+    struct ZoomFrame final
+    {
+        double centreFrequency;             // Frequency of the middle bin (Hz)
+        double binWidth;                    // Spacing of the bins (Hz), or 0 if no frame has been computed
+        int zoomOrder;                      // The band was decimated by 2 ^ zoomOrder
+        float amplitude [numBins];          // Amplitude of each bin (linear, where 1 is a full scale sine) from the lowest frequency up
+    };
+
+    explicit ZoomFftProcessor();
+    ~ZoomFftProcessor() override;
+
+    /** Note that this clears then sets AudioProbes per channel - so it must be called before any attached classes attempt to add listeners to the AudioProbes.
+     *  This also (re)starts the analysis thread. */
+    void prepare (const dsp::ProcessSpec& spec) override;
+
+    /** Called on the audio thread - this just queues the block for the analysis thread. */
+    void performProcessing (const int channel) override;
+
+    /** Sets the frequency at the centre of the band (limited to between 0 & Nyquist). This is safe to call from another thread. */
+    void setCentreFrequency (const double frequencyInHz);
+
+    /** Gets the frequency at the centre of the band. */
+    double getCentreFrequency() const;
+
+    /** Sets the zoom, where the band is decimated by 2 ^ zoomOrder (between minZoomOrder & maxZoomOrder). This is safe to call from another thread. */
+    void setZoomOrder (const int zoomOrder);
+
+    /** Gets the zoom order. */
+    int getZoomOrder() const;
+
+    /** Returns the span of the band (Hz) for a given zoom order. */
+    static double getSpan (const int zoomOrder, const double sampleRate);
+
+    /** Returns the proportion of the first frame that has been collected since the analysis last restarted (for the last channel). */
+    float getFillProportion() const;
+
+    /** Copies the latest frame for a channel. Returns false if no frame was available. */
+    bool copyFrame (ZoomFrame& dest, const int channel) const;
+
+    /** Allows a listener to add a lambda function as a callback to the AudioProbe assigned to the last channel.
+     *  Listener callbacks are cleared each time prepare() is called on this class, so they must be added after this.
+     *
+     *  Returns a function which allows the listener to de-register it's callback. The listener must remove any references
+     *  to de-register functions that have become invalid.
+     */
+    ListenerRemovalCallback addListenerCallback (ListenerCallback&& listenerCallback) const;
+
+private:
+
+    /** Worker thread which analyses frames as they arrive in the queue. */
+    class AnalysisThread final : public Thread
+    {
+    public:
+        explicit AnalysisThread (ZoomFftProcessor& owner) : Thread ("Zoom FFT analysis"), zoomFftProcessor (owner) { }
+        void run() override;
+    private:
+        ZoomFftProcessor& zoomFftProcessor;
+        JUCE_DECLARE_NON_COPYABLE (AnalysisThread)
+    };
+
+    /** Mixer, decimators & decimated history for each channel (everything restarts if the settings change). */
+    struct ChannelState final
+    {
+        HalfBandDecimator decimatorsI [maxZoomOrder];
+        HalfBandDecimator decimatorsQ [maxZoomOrder];
+        dsp::Complex<double> oscillator { 1.0, 0.0 };
+        double centreFrequency = 0.0;
+        int zoomOrder = 0;
+        int generation = -1;
+        int writeIndex = 0;                 // Write position in the decimated history
+        int numSamples = 0;                 // Number of valid samples in the decimated history
+        int samplesSinceLastFrame = 0;      // Number of decimated samples written since the last FFT
+    };
+
+    /** Mixes & decimates the block held in temp, then computes an FFT if a new frame is due (called on the analysis thread). */
+    void analyseBlock (const int channel, const int numSamples);
+
+    /** Computes the FFT of the channel's decimated history & writes the frame to its probe (called on the analysis thread). */
+    void computeFrame (const int channel, const ChannelState& state);
+
+    /** Number of blocks per channel that can be queued for the analysis thread. */
+    static constexpr int queueLengthPerChannel = 8;
+
+    /** Number of decimated samples between successive frames. */
+    static constexpr int hopSize = fftSize / 4;
+
+    dsp::FFT fft;
+    HeapBlock<float> window;
+    float amplitudeCorrectionFactor = 0.0f;
+    HeapBlock<dsp::Complex<float>> timeData;
+    HeapBlock<dsp::Complex<float>> freqData;
+	AudioSampleBuffer temp;
+    AudioSampleBuffer history;  // In-phase & quadrature rows for each channel
+    OwnedArray<ChannelState> channelStates;
+    std::unique_ptr<ZoomFrame> outputFrame;
+    double sampleRate = 48000.0; // will be set correctly in prepare()
+    Atomic<double> centreFrequency = 1000.0;
+    Atomic<int> zoomOrder = defaultZoomOrder;
+    Atomic<int> settingsGeneration = 0;
+    Atomic<float> fillProportion = 0.0f;
+
+    OwnedArray <AudioProbe <ZoomFrame>> probes;
+
+    FrameQueue frameQueue;
+    AnalysisThread analysisThread { *this };
+};
+
+
+// ===========================================================================================
+//  Implementation
+// ===========================================================================================
+
+inline ZoomFftProcessor::ZoomFftProcessor(): FixedBlockProcessor (blockSize),
+                                             fft (fftOrder),
+                                             outputFrame (std::make_unique<ZoomFrame>())
+{
+    // The 4-term Blackman-Harris window keeps the sidelobes of strong tones (e.g. hum) below the sidebands around them
+    window.allocate (fftSize, true);
+    dsp::WindowingFunction<float>::fillWindowingTables (window.getData(), fftSize, dsp::WindowingFunction<float>::blackmanHarris, false);
+    auto sum = 0.0;
+    for (auto i = 0; i < fftSize; ++i)
+        sum += static_cast<double> (window[i]);
+
+    // Mixing a sine of amplitude A down to baseband leaves a complex tone of amplitude A / 2 (the other half is filtered out)
+    amplitudeCorrectionFactor = static_cast<float> (2.0 / sum);
+
+    timeData.allocate (fftSize, true);
+    freqData.allocate (fftSize, true);
+    temp.setSize (3, blockSize, false, true);
+}
+
+inline ZoomFftProcessor::~ZoomFftProcessor()
+{
+    analysisThread.stopThread (1000);
+}
+
+inline void ZoomFftProcessor::prepare (const dsp::ProcessSpec& spec)
+{
+    // Stop the analysis thread while we reallocate everything it uses
+    analysisThread.stopThread (1000);
+
+    FixedBlockProcessor::prepare (spec);
+    frameQueue.prepare (blockSize, static_cast<int> (spec.numChannels) * queueLengthPerChannel);
+
+    sampleRate = spec.sampleRate;
+    history.setSize (static_cast<int> (spec.numChannels) * 2, fftSize);
+    channelStates.clear();
+    for (auto ch = 0; ch < static_cast<int> (spec.numChannels); ++ch)
+        channelStates.add (new ChannelState());
+    fillProportion.set (0.0f);
+
+    probes.clear();
+
+    // Add probes for each channel to transfer frames to the GUI
+    for (auto ch = 0; ch < static_cast<int> (spec.numChannels); ++ch)
+        probes.add (new AudioProbe<ZoomFrame>());
+
+    analysisThread.startThread();
+}
+
+inline void ZoomFftProcessor::performProcessing (const int channel)
+{
+    // The analysis thread polls the queue (see FrameQueue::getConsumerPollInterval)
+    frameQueue.push (getBlockReadPointer (channel), getCurrentBlockSize(), channel);
+}
+
+inline void ZoomFftProcessor::setCentreFrequency (const double frequencyInHz)
+{
+    centreFrequency.set (jmax (0.0, frequencyInHz));
+    settingsGeneration.set (settingsGeneration.get() + 1);
+}
+
+inline double ZoomFftProcessor::getCentreFrequency() const
+{
+    return centreFrequency.get();
+}
+
+inline void ZoomFftProcessor::setZoomOrder (const int newZoomOrder)
+{
+    jassert (newZoomOrder >= minZoomOrder && newZoomOrder <= maxZoomOrder);
+    zoomOrder.set (jlimit (minZoomOrder, maxZoomOrder, newZoomOrder));
+    settingsGeneration.set (settingsGeneration.get() + 1);
+}
+
+inline int ZoomFftProcessor::getZoomOrder() const
+{
+    return zoomOrder.get();
+}
+
+inline double ZoomFftProcessor::getSpan (const int order, const double fs)
+{
+    return fs / static_cast<double> (1 << (order + 1));
+}
+
+inline float ZoomFftProcessor::getFillProportion() const
+{
+    return fillProportion.get();
+}
+
+inline void ZoomFftProcessor::AnalysisThread::run()
+{
+    auto lastFrameTime = Time::getMillisecondCounter();
+
+    while (!threadShouldExit())
+    {
+        auto channel = 0;
+        auto numSamples = 0;
+        while (zoomFftProcessor.frameQueue.pop (zoomFftProcessor.temp.getWritePointer (0), numSamples, channel))
+        {
+            lastFrameTime = Time::getMillisecondCounter();
+            zoomFftProcessor.analyseBlock (channel, numSamples);
+            if (threadShouldExit())
+                return;
+        }
+        wait (FrameQueue::getConsumerPollInterval (lastFrameTime));
+    }
+}
+
+inline void ZoomFftProcessor::analyseBlock (const int channel, const int numSamples)
+{
+    auto& state = *channelStates[channel];
+
+    // Restart if the centre frequency or zoom has changed
+    const auto generation = settingsGeneration.get();
+    if (state.generation != generation)
+    {
+        state.generation = generation;
+        state.centreFrequency = jmin (centreFrequency.get(), sampleRate * 0.5);
+        state.zoomOrder = zoomOrder.get();
+        state.oscillator = { 1.0, 0.0 };
+        for (auto stage = 0; stage < maxZoomOrder; ++stage)
+        {
+            state.decimatorsI[stage].reset();
+            state.decimatorsQ[stage].reset();
+        }
+        state.writeIndex = 0;
+        state.numSamples = 0;
+        state.samplesSinceLastFrame = 0;
+    }
+
+    // Mix down to baseband (the oscillator is renormalised after each block so rounding errors can't change its amplitude)
+    const auto* input = temp.getReadPointer (0);
+    auto* inPhase = temp.getWritePointer (1);
+    auto* quadrature = temp.getWritePointer (2);
+    const auto step = std::polar (1.0, -MathConstants<double>::twoPi * state.centreFrequency / sampleRate);
+    auto oscillator = state.oscillator;
+    for (auto i = 0; i < numSamples; ++i)
+    {
+        inPhase[i] = input[i] * static_cast<float> (oscillator.real());
+        quadrature[i] = input[i] * static_cast<float> (oscillator.imag());
+        oscillator *= step;
+    }
+    state.oscillator = oscillator / std::abs (oscillator);
+
+    // Decimate in place (the in-phase & quadrature decimators are always in step, so they output the same number of samples)
+    auto numDecimated = numSamples;
+    for (auto stage = 0; stage < state.zoomOrder; ++stage)
+    {
+        const auto numInput = numDecimated;
+        numDecimated = state.decimatorsI[stage].process (inPhase, numInput, inPhase);
+        state.decimatorsQ[stage].process (quadrature, numInput, quadrature);
+    }
+
+    // Append to the decimated history
+    auto* historyI = history.getWritePointer (channel * 2);
+    auto* historyQ = history.getWritePointer (channel * 2 + 1);
+    for (auto i = 0; i < numDecimated; ++i)
+    {
+        historyI[state.writeIndex] = inPhase[i];
+        historyQ[state.writeIndex] = quadrature[i];
+        if (++state.writeIndex == fftSize)
+            state.writeIndex = 0;
+    }
+    state.numSamples = jmin (fftSize, state.numSamples + numDecimated);
+    state.samplesSinceLastFrame += numDecimated;
+    if (channel == channelStates.size() - 1)
+        fillProportion.set (static_cast<float> (state.numSamples) / static_cast<float> (fftSize));
+
+    if (state.numSamples == fftSize && state.samplesSinceLastFrame >= hopSize)
+    {
+        state.samplesSinceLastFrame %= hopSize;
+        computeFrame (channel, state);
+    }
+}
+
+inline void ZoomFftProcessor::computeFrame (const int channel, const ChannelState& state)
+{
+    // Window the history (oldest sample first)
+    const auto* historyI = history.getReadPointer (channel * 2);
+    const auto* historyQ = history.getReadPointer (channel * 2 + 1);
+    for (auto i = 0; i < fftSize; ++i)
+    {
+        const auto index = (state.writeIndex + i) & (fftSize - 1);
+        timeData[i] = { historyI[index] * window[i], historyQ[index] * window[i] };
+    }
+
+    fft.perform (timeData.getData(), freqData.getData(), false);
+
+    // Output the middle half of the spectrum in ascending frequency order (negative frequencies are at the top of the FFT output)
+    for (auto k = 0; k < numBins; ++k)
+    {
+        const auto bin = (k - fftSize / 4) & (fftSize - 1);
+        outputFrame->amplitude[k] = std::abs (freqData[bin]) * amplitudeCorrectionFactor;
+    }
+    outputFrame->centreFrequency = state.centreFrequency;
+    outputFrame->binWidth = sampleRate / static_cast<double> (fftSize << state.zoomOrder);
+    outputFrame->zoomOrder = state.zoomOrder;
+    probes[channel]->writeFrame (outputFrame.get());
+}
+
+inline bool ZoomFftProcessor::copyFrame (ZoomFrame& dest, const int channel) const
+{
+    if (channel < 0 || channel >= probes.size())
+        return false;
+
+    probes[channel]->copyFrame (&dest);
+    return dest.binWidth > 0.0;
+}
+
+inline ListenerRemovalCallback ZoomFftProcessor::addListenerCallback (ListenerCallback&& listenerCallback) const
+{
+    // If this asserts then you're trying to add the listener before the AudioProbes are set up
+    jassert (getNumChannels()>0);
+
+    if (probes.size() == getNumChannels() && probes[getNumChannels() - 1])
+        return probes[getNumChannels() - 1]->addListenerCallback(std::forward<ListenerCallback>(listenerCallback));
+
+    return {};
+}